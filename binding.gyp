@@ -0,0 +1,13 @@
+{
+  "targets": [
+    {
+      "target_name": "lexer",
+      "sources": ["src/addon/addon.c", "src/addon/lexer16.c", "src/lexer.c"],
+      "defines": ["LEXER_PACK"],
+      "cflags": ["-O3"],
+      "xcode_settings": {
+        "OTHER_CFLAGS": ["-O3"]
+      }
+    }
+  ]
+}
@@ -1,9 +1,11 @@
 fn main() {
   println!("cargo:rerun-if-changed=src/lexer.h");
   println!("cargo:rerun-if-changed=src/lexer.c");
-  cc::Build::new()
-    .warnings(false)
-    .flag_if_supported("-std=c99")
-    .file("src/lexer.c")
-    .compile("lexer.a");
+  let mut build = cc::Build::new();
+  build.warnings(false).flag_if_supported("-std=c99").file("src/lexer.c");
+  // the scalar reference build, without the SIMD kernels
+  if std::env::var_os("CARGO_FEATURE_SCALAR").is_some() {
+    build.define("LEXER_SCALAR", None);
+  }
+  build.compile("lexer.a");
 }
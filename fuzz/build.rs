@@ -0,0 +1,24 @@
+fn main() {
+  println!("cargo:rerun-if-changed=../src/lexer.h");
+  println!("cargo:rerun-if-changed=../src/lexer.c");
+  println!("cargo:rerun-if-changed=src");
+  // the SIMD, scalar reference and switch dispatch reference builds of both
+  // code unit widths
+  let mut build = cc::Build::new();
+  // under cargo fuzz, instrumented for coverage and checked by ASan like the
+  // Rust code, which needs a clang CC
+  if std::env::var_os("CARGO_CFG_FUZZING").is_some() {
+    build.flag("-fsanitize=fuzzer-no-link,address");
+  }
+  build
+    .warnings(false)
+    .flag_if_supported("-std=c99")
+    .define("LEXER_PACK", None)
+    .file("../src/lexer.c")
+    .file("src/lexer_scalar.c")
+    .file("src/lexer_switch.c")
+    .file("src/lexer16.c")
+    .file("src/lexer16_scalar.c")
+    .file("src/lexer16_switch.c")
+    .compile("lexers.a");
+}
@@ -0,0 +1,9 @@
+#![no_main]
+
+// Lexes the input as source with the SIMD build and the scalar and switch
+// dispatch reference builds.
+use libfuzzer_sys::fuzz_target;
+
+fuzz_target!(|data: &[u8]| {
+  es_module_lexer_fuzz::check(data);
+});
@@ -0,0 +1,8 @@
+#![no_main]
+
+// Flags inputs the SIMD build lexes more slowly than the scalar reference.
+use libfuzzer_sys::fuzz_target;
+
+fuzz_target!(|data: &[u8]| {
+  es_module_lexer_fuzz::check_throughput(data);
+});
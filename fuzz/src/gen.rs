@@ -0,0 +1,537 @@
+//! A grammar-aware JS generator driven by fuzz input bytes, so mutations of
+//! the input explore the token contexts the lexer has to tell apart (regular
+//! expressions from division, template nesting, braces of blocks, objects and
+//! classes) far more often than random bytes would. The output is mostly but
+//! not always valid JS, since invalid sources must lex the same way too.
+
+/// Generates JS from the input, one choice per byte, ending when the input
+/// runs out.
+pub fn generate(data: &[u8]) -> String {
+  let mut gen = Gen {
+    data,
+    pos: 0,
+    depth: 0,
+    out: String::new(),
+  };
+  while gen.pos < data.len() {
+    gen.statement();
+    gen.newline();
+  }
+  gen.out
+}
+
+struct Gen<'a> {
+  data: &'a [u8],
+  pos: usize,
+  depth: u32,
+  out: String,
+}
+
+const MAX_DEPTH: u32 = 12;
+
+const NAMES: &[&str] = &[
+  "a", "b", "x", "$", "_y", "ünï", "await", "async", "of", "get", "as", "from", "type", "source", "defer",
+  "require", "exports", "module", "meta", "let",
+];
+const KEYWORDS: &[&str] = &[
+  "return",
+  "typeof",
+  "void",
+  "delete",
+  "throw",
+  "case",
+  "do",
+  "else",
+  "in",
+  "instanceof",
+  "new",
+  "yield",
+  "await",
+];
+const SPECIFIERS: &[&str] = &[
+  "'./a.js'",
+  "\"b\"",
+  "'@scope/pkg/sub'",
+  "'node:fs'",
+  "'#internal'",
+  "'../\\u0061'",
+  "'\\x62'",
+  "\"https://x.org/m.js\"",
+  "''",
+];
+const PUNCTUATORS: &[&str] = &[
+  " + ", " - ", " * ", " / ", " % ", " = ", " == ", " < ", " > ", " && ", " || ", " ?? ", ", ", "!", "~", "++",
+  "--", " ? b : ", ".", "?.", " => ",
+];
+
+impl<'a> Gen<'a> {
+  fn byte(&mut self) -> u8 {
+    let b = self.data.get(self.pos).copied().unwrap_or(0);
+    self.pos += 1;
+    b
+  }
+
+  fn choose(&mut self, n: u8) -> u8 {
+    self.byte() % n
+  }
+
+  fn pick(&mut self, items: &[&str]) {
+    let i = self.byte() as usize % items.len();
+    self.out.push_str(items[i]);
+  }
+
+  fn push(&mut self, s: &str) {
+    self.out.push_str(s);
+  }
+
+  fn newline(&mut self) {
+    match self.choose(4) {
+      0 => self.push(";\n"),
+      1 => self.push("\n"),
+      2 => self.push("; "),
+      _ => self.push("\r\n"),
+    }
+  }
+
+  fn space(&mut self) {
+    match self.choose(8) {
+      0 => self.push("/* c */"),
+      1 => self.push("\n"),
+      2 => self.push("// c\n"),
+      3 => {}
+      _ => self.push(" "),
+    }
+  }
+
+  fn name(&mut self) {
+    self.pick(NAMES);
+  }
+
+  fn statement(&mut self) {
+    if self.depth > MAX_DEPTH {
+      return self.name();
+    }
+    self.depth += 1;
+    match self.choose(16) {
+      0 | 1 => self.import_declaration(),
+      2 | 3 => self.export_declaration(),
+      4 => {
+        self.push("if (");
+        self.expression();
+        self.push(") ");
+        self.statement();
+        if self.choose(2) == 0 {
+          self.push(" else ");
+          self.statement();
+        }
+      }
+      5 => {
+        self.push("{");
+        self.statements();
+        self.push("}");
+      }
+      6 => {
+        self.push("function ");
+        self.name();
+        self.push(" (a) {");
+        self.statements();
+        self.push("}");
+      }
+      7 => self.class(),
+      8 => {
+        self.pick(&["const ", "let ", "var "]);
+        self.name();
+        self.push(" = ");
+        self.expression();
+      }
+      9 => {
+        self.pick(&["for (const a of ", "while (", "switch ("]);
+        self.expression();
+        self.push(") {");
+        self.statements();
+        self.push("}");
+      }
+      10 => {
+        self.pick(&["try {", "label: {", "do {"]);
+        self.statements();
+        self.pick(&["} catch (e) {}", "} finally {}", "}", "} while (a)"]);
+      }
+      11 => {
+        self.pick(KEYWORDS);
+        self.push(" ");
+        self.expression();
+      }
+      // division and regex ambiguity after what closes a statement
+      12 => {
+        self.pick(&["}", ")", "]", "x", "1", "a++", "/re/"]);
+        self.space();
+        self.expression();
+      }
+      _ => self.expression(),
+    }
+    self.depth -= 1;
+  }
+
+  fn statements(&mut self) {
+    for _ in 0..self.choose(4) {
+      self.statement();
+      self.newline();
+    }
+  }
+
+  fn import_declaration(&mut self) {
+    match self.choose(10) {
+      0 => {
+        self.push("import ");
+        self.pick(SPECIFIERS);
+      }
+      1 => {
+        self.push("import ");
+        self.name();
+        self.push(" from ");
+        self.pick(SPECIFIERS);
+      }
+      2 => {
+        self.push("import ");
+        self.pick(&[
+          "* as ns",
+          "source x",
+          "defer * as ns",
+          "type X",
+          "type * as ns",
+          "a, * as ns",
+        ]);
+        self.push(" from ");
+        self.pick(SPECIFIERS);
+      }
+      3 => {
+        self.push("import ");
+        self.named_list();
+        self.space();
+        self.push("from ");
+        self.pick(SPECIFIERS);
+        self.attributes();
+      }
+      4 => {
+        self.push("import json from ");
+        self.pick(SPECIFIERS);
+        self.attributes();
+      }
+      5 => {
+        self.push("import(");
+        self.pick(SPECIFIERS);
+        if self.choose(2) == 0 {
+          self.push(", { with: { type: 'json' } }");
+        }
+        self.push(")");
+      }
+      6 => {
+        self.push("import(");
+        self.expression();
+        self.push(")");
+      }
+      7 => self.push("import.meta.url"),
+      8 => {
+        self.push("require(");
+        self.pick(SPECIFIERS);
+        self.push(")");
+      }
+      _ => {
+        self.push("import a = require(");
+        self.pick(SPECIFIERS);
+        self.push(")");
+      }
+    }
+  }
+
+  fn attributes(&mut self) {
+    match self.choose(4) {
+      0 => self.push(" with { type: 'json' }"),
+      1 => self.push(" assert { \"type\": \"css\", 'a': \"\\u0062\" }"),
+      2 => self.push(" with {}"),
+      _ => {}
+    }
+  }
+
+  fn named_list(&mut self) {
+    self.push("{");
+    for i in 0..self.choose(4) {
+      if i > 0 {
+        self.push(", ");
+      }
+      match self.choose(6) {
+        0 => {
+          self.name();
+          self.push(" as ");
+          self.name();
+        }
+        1 => self.push("'str ing' as s"),
+        2 => self.push("default as d"),
+        3 => {
+          self.push("type ");
+          self.name();
+        }
+        _ => self.name(),
+      }
+    }
+    self.pick(&["}", ", }", " }"]);
+  }
+
+  fn export_declaration(&mut self) {
+    self.push("export ");
+    match self.choose(12) {
+      0 => self.named_list(),
+      1 => {
+        self.named_list();
+        self.push(" from ");
+        self.pick(SPECIFIERS);
+      }
+      2 => {
+        self.pick(&["* from ", "* as ns from ", "type * from ", "type { T } from "]);
+        self.pick(SPECIFIERS);
+      }
+      3 => {
+        self.push("default ");
+        self.expression();
+      }
+      4 => {
+        self.pick(&[
+          "default function ",
+          "default async function* ",
+          "async function ",
+          "function* ",
+        ]);
+        self.name();
+        self.push("() {");
+        self.statements();
+        self.push("}");
+      }
+      5 => {
+        self.pick(&["default ", ""]);
+        self.class();
+      }
+      6 => {
+        self.pick(&["const ", "let ", "var "]);
+        self.name();
+        self.push(" = ");
+        self.expression();
+        if self.choose(2) == 0 {
+          self.push(", ");
+          self.name();
+          self.push(" = 1");
+        }
+      }
+      7 => self.pick(&["const { a, b: c } = d", "var [e, f] = g"]),
+      8 => {
+        self.pick(&[
+          "type T = ",
+          "interface I ",
+          "enum E ",
+          "const enum F ",
+          "namespace N ",
+          "declare const d: ",
+          "abstract class A ",
+        ]);
+        self.push("{ a: 1 }");
+      }
+      9 => self.pick(&[
+        "as namespace NS",
+        "declare module 'm' {}",
+        "import Y = N.Y",
+        "default interface J {}",
+      ]),
+      _ => {
+        self.push("{ ");
+        self.name();
+        self.push(" }");
+      }
+    }
+  }
+
+  fn class(&mut self) {
+    self.push("class ");
+    self.name();
+    if self.choose(3) == 0 {
+      self.push(" extends ");
+      self.primary();
+    }
+    self.push(" {");
+    for _ in 0..self.choose(3) {
+      self.pick(&["static ", "get ", "async ", "#", ""]);
+      self.name();
+      self.push("() {");
+      self.statements();
+      self.push("}");
+      self.newline();
+    }
+    self.push("}");
+  }
+
+  fn expression(&mut self) {
+    if self.depth > MAX_DEPTH {
+      return self.name();
+    }
+    self.depth += 1;
+    self.primary();
+    for _ in 0..self.choose(3) {
+      self.pick(PUNCTUATORS);
+      self.space();
+      self.primary();
+    }
+    self.depth -= 1;
+  }
+
+  fn primary(&mut self) {
+    if self.depth > MAX_DEPTH {
+      return self.name();
+    }
+    self.depth += 1;
+    match self.choose(20) {
+      0 | 1 | 2 => self.name(),
+      3 => self.pick(&["1", "0.5", ".5", "1e3", "0x1f", "1_000n"]),
+      4 => self.string(),
+      5 => self.template(),
+      6 => self.regex(),
+      7 => {
+        self.push("(");
+        self.expression();
+        self.push(")");
+      }
+      8 => {
+        self.push("[");
+        self.expression();
+        self.push("]");
+      }
+      9 => {
+        self.push("{ ");
+        self.name();
+        self.push(": ");
+        self.expression();
+        self.pick(&[" }", ", b }", ", ...c }", ", get d() {} }"]);
+      }
+      10 => {
+        self.pick(&["(a) => ", "async (a) => ", "a => ", "async a => "]);
+        if self.choose(2) == 0 {
+          self.push("{");
+          self.statements();
+          self.push("}");
+        } else {
+          self.expression();
+        }
+      }
+      11 => {
+        self.pick(&["function (", "async function* ("]);
+        self.push(") {");
+        self.statements();
+        self.push("}");
+      }
+      12 => {
+        self.pick(KEYWORDS);
+        self.push(" ");
+        self.primary();
+      }
+      13 => {
+        self.primary();
+        self.pick(&["(", "?.(", "["]);
+        self.expression();
+        self.pick(&[")", ")", "]"]);
+      }
+      14 => self.jsx(),
+      15 => {
+        self.push("await ");
+        self.primary();
+      }
+      16 => {
+        self.push("x! / ");
+        self.primary();
+      }
+      17 => self.import_declaration(),
+      _ => {
+        self.primary();
+        self.push(".");
+        self.name();
+      }
+    }
+    self.depth -= 1;
+  }
+
+  fn string(&mut self) {
+    let quote = if self.choose(2) == 0 { "'" } else { "\"" };
+    self.push(quote);
+    for _ in 0..self.choose(4) {
+      self.pick(&[
+        "a",
+        "/",
+        "\\\\",
+        "\\'",
+        "\\\"",
+        "`",
+        "${",
+        "}",
+        "\\u{1F600}",
+        "\\x41",
+        "\\\n",
+        "import",
+        " ",
+      ]);
+    }
+    self.push(quote);
+  }
+
+  fn template(&mut self) {
+    self.push("`");
+    for _ in 0..self.choose(4) {
+      match self.choose(5) {
+        0 => {
+          self.push("${");
+          self.expression();
+          self.push("}");
+        }
+        1 => self.pick(&["\\`", "\\${", "$", "{", "}", "\n"]),
+        _ => self.pick(&["a", "/", "'", "\"", "import('x')", " "]),
+      }
+    }
+    self.push("`");
+  }
+
+  fn regex(&mut self) {
+    self.push("/");
+    for _ in 0..=self.choose(4) {
+      self.pick(&[
+        "a", "[/]", "\\/", "[\\]/]", "(?:x)", "*", "+", "`", "'", "{1}", "]", "}",
+      ]);
+    }
+    self.push("/");
+    self.pick(&["", "g", "u", "gimsuy", "v"]);
+  }
+
+  fn jsx(&mut self) {
+    self.push("<");
+    self.pick(&["div", "A.B", "x:y", "my-el", ""]);
+    for _ in 0..self.choose(3) {
+      self.push(" ");
+      self.pick(&["a=\"it's\"", "b='/'", "c={1 / 2}", "{...d}", "e"]);
+    }
+    if self.choose(3) == 0 {
+      self.push(" />");
+      return;
+    }
+    self.push(">");
+    for _ in 0..self.choose(3) {
+      match self.choose(4) {
+        0 => {
+          self.push("{");
+          self.expression();
+          self.push("}");
+        }
+        1 if self.depth < MAX_DEPTH => {
+          self.depth += 1;
+          self.jsx();
+          self.depth -= 1;
+        }
+        _ => self.pick(&["it's", " // text", " a / b ", "`", "\"", "&amp;"]),
+      }
+    }
+    self.push("</>");
+  }
+}
@@ -0,0 +1,12 @@
+// The SIMD build of the UTF-16 lexer, with the external symbols renamed so
+// the SIMD and reference builds of both widths link into one fuzz binary.
+#define LEXER_UTF16
+#define parse parse16
+#define parse_init parse_init16
+#define parse_step parse_step16
+#define parse_regions parse_regions16
+#define parse_packed parse_packed16
+#define parse_regions_packed parse_regions_packed16
+#define unescape unescape16
+
+#include "../../src/lexer.c"
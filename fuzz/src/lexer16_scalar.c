@@ -0,0 +1,14 @@
+// The scalar reference build of the UTF-16 lexer, with the external symbols
+// renamed so the SIMD and reference builds of both widths link into one fuzz
+// binary.
+#define LEXER_SCALAR
+#define LEXER_UTF16
+#define parse parse16_scalar
+#define parse_init parse_init16_scalar
+#define parse_step parse_step16_scalar
+#define parse_regions parse_regions16_scalar
+#define parse_packed parse_packed16_scalar
+#define parse_regions_packed parse_regions_packed16_scalar
+#define unescape unescape16_scalar
+
+#include "../../src/lexer.c"
@@ -0,0 +1,14 @@
+// The switch dispatch reference build of the UTF-16 lexer, the portable
+// lexSlice of compilers without computed goto, with the external symbols
+// renamed so every build links into one fuzz binary.
+#define LEXER_SWITCH
+#define LEXER_UTF16
+#define parse parse16_switch
+#define parse_init parse_init16_switch
+#define parse_step parse_step16_switch
+#define parse_regions parse_regions16_switch
+#define parse_packed parse_packed16_switch
+#define parse_regions_packed parse_regions_packed16_switch
+#define unescape unescape16_switch
+
+#include "../../src/lexer.c"
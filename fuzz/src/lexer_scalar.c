@@ -0,0 +1,13 @@
+// The scalar reference build of the one-byte lexer, with the external
+// symbols renamed so the SIMD and reference builds of both widths link into
+// one fuzz binary.
+#define LEXER_SCALAR
+#define parse parse_scalar
+#define parse_init parse_init_scalar
+#define parse_step parse_step_scalar
+#define parse_regions parse_regions_scalar
+#define parse_packed parse_packed_scalar
+#define parse_regions_packed parse_regions_packed_scalar
+#define unescape unescape_scalar
+
+#include "../../src/lexer.c"
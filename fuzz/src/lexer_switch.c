@@ -0,0 +1,13 @@
+// The switch dispatch reference build of the one-byte lexer, the portable
+// lexSlice of compilers without computed goto, with the external symbols
+// renamed so every build links into one fuzz binary.
+#define LEXER_SWITCH
+#define parse parse_switch
+#define parse_init parse_init_switch
+#define parse_step parse_step_switch
+#define parse_regions parse_regions_switch
+#define parse_packed parse_packed_switch
+#define parse_regions_packed parse_regions_packed_switch
+#define unescape unescape_switch
+
+#include "../../src/lexer.c"
@@ -0,0 +1,247 @@
+//! Differential fuzzing of the lexer's SIMD build against its scalar reference
+//! build (`-DLEXER_SCALAR`) and its switch dispatch reference build
+//! (`-DLEXER_SWITCH`), in both code unit widths. Builds are compared through
+//! their packed results, which hold every record, error offset and line start
+//! in one array.
+
+use std::ffi::c_void;
+use std::time::{Duration, Instant};
+
+mod gen;
+
+pub use gen::generate;
+
+type Allocate = unsafe extern "C" fn(bytes: u32, user_data: *mut c_void) -> *mut c_void;
+type ParsePacked<T> = unsafe extern "C" fn(
+  source: *const T,
+  source_len: u32,
+  options: u32,
+  alloc: Allocate,
+  user_data: *mut c_void,
+  packed_len: *mut u32,
+) -> *const i32;
+
+extern "C" {
+  fn parse_packed(
+    source: *const u8,
+    source_len: u32,
+    options: u32,
+    alloc: Allocate,
+    user_data: *mut c_void,
+    packed_len: *mut u32,
+  ) -> *const i32;
+  fn parse_packed_scalar(
+    source: *const u8,
+    source_len: u32,
+    options: u32,
+    alloc: Allocate,
+    user_data: *mut c_void,
+    packed_len: *mut u32,
+  ) -> *const i32;
+  fn parse_packed_switch(
+    source: *const u8,
+    source_len: u32,
+    options: u32,
+    alloc: Allocate,
+    user_data: *mut c_void,
+    packed_len: *mut u32,
+  ) -> *const i32;
+  fn parse_packed16(
+    source: *const u16,
+    source_len: u32,
+    options: u32,
+    alloc: Allocate,
+    user_data: *mut c_void,
+    packed_len: *mut u32,
+  ) -> *const i32;
+  fn parse_packed16_scalar(
+    source: *const u16,
+    source_len: u32,
+    options: u32,
+    alloc: Allocate,
+    user_data: *mut c_void,
+    packed_len: *mut u32,
+  ) -> *const i32;
+  fn parse_packed16_switch(
+    source: *const u16,
+    source_len: u32,
+    options: u32,
+    alloc: Allocate,
+    user_data: *mut c_void,
+    packed_len: *mut u32,
+  ) -> *const i32;
+}
+
+// ParseOption of lexer.h
+const LINE_STARTS: u32 = 1;
+const CJS_EXPORTS: u32 = 2;
+const FAST_REJECT: u32 = 4;
+const RECOVER: u32 = 8;
+const SPECIFIERS: u32 = 16;
+const FINGERPRINT: u32 = 32;
+const JSX: u32 = 64;
+const TYPESCRIPT: u32 = 128;
+
+/// The option sets each input is lexed with, covering every option and the
+/// default path.
+const OPTIONS: [u32; 4] = [
+  0,
+  LINE_STARTS | CJS_EXPORTS | RECOVER | SPECIFIERS | FINGERPRINT,
+  FAST_REJECT | CJS_EXPORTS,
+  JSX | TYPESCRIPT | RECOVER,
+];
+
+/// Lexes the source with the SIMD and both reference builds of both widths,
+/// panicking with the first packed field that differs. UTF-8 sources are lexed
+/// by the UTF-16 builds as JS would pass them, and other bytes as Latin-1.
+pub fn check(data: &[u8]) {
+  let utf8 = Source::new(data);
+  let units: Vec<u16> = match std::str::from_utf8(data) {
+    Ok(s) => s.encode_utf16().collect(),
+    Err(_) => data.iter().map(|&b| b as u16).collect(),
+  };
+  let utf16 = Source::new(&units);
+  for options in OPTIONS {
+    let simd = utf8.lex(parse_packed, options);
+    compare(
+      "UTF-8",
+      "scalar",
+      options,
+      &simd,
+      &utf8.lex(parse_packed_scalar, options),
+    );
+    compare(
+      "UTF-8",
+      "switch dispatch",
+      options,
+      &simd,
+      &utf8.lex(parse_packed_switch, options),
+    );
+    let simd = utf16.lex(parse_packed16, options);
+    compare(
+      "UTF-16",
+      "scalar",
+      options,
+      &simd,
+      &utf16.lex(parse_packed16_scalar, options),
+    );
+    compare(
+      "UTF-16",
+      "switch dispatch",
+      options,
+      &simd,
+      &utf16.lex(parse_packed16_switch, options),
+    );
+  }
+}
+
+fn compare(width: &str, reference: &str, options: u32, simd: &[i32], expected: &[i32]) {
+  if let Some(i) = (0..simd.len().max(expected.len())).find(|&i| simd.get(i) != expected.get(i)) {
+    panic!(
+      "{} SIMD build differs from the {} reference with options {:#x} at packed index {}: {:?} != {:?}",
+      width,
+      reference,
+      options,
+      i,
+      simd.get(i),
+      expected.get(i)
+    );
+  }
+}
+
+/// Inputs shorter than this are lexed too quickly to time reliably.
+const THROUGHPUT_MIN_LEN: usize = 4096;
+const THROUGHPUT_ROUNDS: u32 = 8;
+
+/// Times the SIMD and scalar reference builds on the source, panicking when
+/// the SIMD build is slower by more than the `LEXER_FUZZ_SLOWDOWN` factor
+/// (1.1 by default). Each build's best of several rounds is taken, and a
+/// slowdown must reproduce on a second measurement before it is reported, so
+/// scheduling noise isn't flagged.
+pub fn check_throughput(data: &[u8]) {
+  if data.len() < THROUGHPUT_MIN_LEN {
+    return;
+  }
+  let slowdown: f64 = std::env::var("LEXER_FUZZ_SLOWDOWN")
+    .ok()
+    .and_then(|s| s.parse().ok())
+    .unwrap_or(1.1);
+  let units: Vec<u16> = data.iter().map(|&b| b as u16).collect();
+  let utf8 = Source::new(data);
+  let utf16 = Source::new(&units);
+  let slower = |simd: &dyn Fn() -> Duration, scalar: &dyn Fn() -> Duration| {
+    (0..2).all(|_| simd().as_secs_f64() > scalar().as_secs_f64() * slowdown)
+  };
+  if slower(&|| utf8.time(parse_packed), &|| utf8.time(parse_packed_scalar)) {
+    panic!(
+      "UTF-8 SIMD build is more than {}x slower than the scalar reference",
+      slowdown
+    );
+  }
+  if slower(&|| utf16.time(parse_packed16), &|| utf16.time(parse_packed16_scalar)) {
+    panic!(
+      "UTF-16 SIMD build is more than {}x slower than the scalar reference",
+      slowdown
+    );
+  }
+}
+
+/// A source followed only by its zero terminator, in an allocation of exactly
+/// that size, so any lookahead past the terminator or before the start is an
+/// out of bounds read under ASan.
+struct Source<T> {
+  units: Box<[T]>,
+}
+
+impl<T: Copy + Default> Source<T> {
+  fn new(source: &[T]) -> Self {
+    let mut units = vec![T::default(); source.len() + 1].into_boxed_slice();
+    units[..source.len()].copy_from_slice(source);
+    Source { units }
+  }
+
+  fn len(&self) -> u32 {
+    (self.units.len() - 1) as u32
+  }
+
+  fn lex(&self, parse: ParsePacked<T>, options: u32) -> Vec<i32> {
+    let mut arena = Arena::default();
+    let mut packed_len = 0;
+    unsafe {
+      let packed = parse(
+        self.units.as_ptr(),
+        self.len(),
+        options,
+        alloc,
+        &mut arena as *mut Arena as *mut c_void,
+        &mut packed_len,
+      );
+      std::slice::from_raw_parts(packed, packed_len as usize).to_vec()
+    }
+  }
+
+  fn time(&self, parse: ParsePacked<T>) -> Duration {
+    (0..THROUGHPUT_ROUNDS)
+      .map(|_| {
+        let start = Instant::now();
+        std::hint::black_box(self.lex(parse, 0));
+        start.elapsed()
+      })
+      .min()
+      .unwrap()
+  }
+}
+
+/// Allocations of one parse, freed together when it's dropped.
+#[derive(Default)]
+struct Arena {
+  blocks: Vec<Box<[u64]>>,
+}
+
+unsafe extern "C" fn alloc(bytes: u32, user_data: *mut c_void) -> *mut c_void {
+  let arena = &mut *(user_data as *mut Arena);
+  let mut block = vec![0u64; (bytes as usize + 7) / 8].into_boxed_slice();
+  let ptr = block.as_mut_ptr() as *mut c_void;
+  arena.blocks.push(block);
+  ptr
+}
@@ -0,0 +1,70 @@
+import { createRequire } from 'module';
+import { parseOptionFlags, readParseResult, regionOffsets, setUnescape } from './lexer.js';
+import type { parse as wasmParse, ParseOptions, SourceText } from './lexer.js';
+
+export { lineCol, SpecifierKind } from './lexer.js';
+export type { ImportSpecifier, ImportBinding, ExportSpecifier, ParseOptions, ModuleMeta, ErrorRange } from './lexer.js';
+
+const addon: {
+  /** parse, returning the packed Int32Array results of the wasm API */
+  parse (source: string | Uint8Array, options: number): Int32Array;
+  /** parse on the libuv thread pool */
+  parseAsync (source: string | Uint8Array, options: number): Promise<Int32Array>;
+  /** parseRegions, returning the packed results of each region up to the first that failed */
+  parseRegions (source: string | Uint8Array, regions: Uint32Array, options: number): Int32Array[];
+  /** unescape, returning undefined for an invalid escape */
+  unescape (str: string): string | undefined;
+  /** the string of the UTF-8 bytes[start, end) */
+  decodeUtf8 (bytes: Uint8Array, start: number, end: number): string;
+} = createRequire(import.meta.url)('../build/Release/lexer.node');
+
+setUnescape(addon.unescape);
+
+// Uint8Array sources are lexed with each byte a code unit, so names are
+// decoded from their UTF-8 bytes between those offsets, on first read, from a
+// copy so the caller may reuse the array.
+function sourceText (source: string | Uint8Array): SourceText {
+  if (typeof source === 'string')
+    return source;
+  const bytes = Uint8Array.prototype.slice.call(source);
+  return {
+    slice: (start = 0, end = bytes.length) => addon.decodeUtf8(bytes, start, end),
+    charCodeAt: index => bytes[index]
+  };
+}
+
+/**
+ * `parse` of the main entry, lexing natively with the Node-API addon, which
+ * needs no `init`.
+ *
+ * The source may also be a `Buffer` or other `Uint8Array` of UTF-8, which is
+ * lexed with each byte a code unit, so offsets are byte offsets, and names are
+ * decoded as UTF-8. This matches parsing the string for ASCII sources.
+ */
+export function parse (source: string | Uint8Array, name = '@', options: ParseOptions = {}): ReturnType<typeof wasmParse> {
+  return readParseResult(sourceText(source), addon.parse(source, parseOptionFlags(options)), name, options);
+}
+
+/**
+ * Parses many sources in parallel on the libuv thread pool, resolving to their
+ * results in order, or rejecting with the first parse error.
+ *
+ * Sources are copied before this returns, so they may be modified while they
+ * are lexed.
+ */
+export async function parseMany (sources: ReadonlyArray<string | Uint8Array>, options: ParseOptions = {}): Promise<ReturnType<typeof wasmParse>[]> {
+  const flags = parseOptionFlags(options);
+  const texts = sources.map(sourceText);
+  const results = await Promise.all(sources.map(source => addon.parseAsync(source, flags)));
+  return results.map((result, i) => readParseResult(texts[i], result, '@', options));
+}
+
+/**
+ * `parseRegions` of the main entry, lexing natively with the Node-API addon.
+ * Regions of a `Uint8Array` source are in byte offsets, as are its results.
+ */
+export function parseRegions (source: string | Uint8Array, regions: ReadonlyArray<readonly [start: number, end: number]>, name = '@', options: ParseOptions = {}): ReturnType<typeof wasmParse>[] {
+  const text = sourceText(source);
+  const results = addon.parseRegions(source, regionOffsets(source.length, regions), parseOptionFlags(options));
+  return results.map(result => readParseResult(text, result, name, options));
+}
@@ -0,0 +1,315 @@
+// Node-API addon running the lexer natively, built by node-gyp from
+// binding.gyp and wrapped by src/addon.ts.
+//
+// Strings are copied out as UTF-16 and lexed by the UTF-16 build, since
+// Node-API has no access to the one-byte representation of a string. Buffers
+// and other Uint8Arrays are copied with a terminator and lexed by the one-byte
+// build, with each byte a code unit, and their names decoded as UTF-8. Either
+// way the results are the packed Int32Array of the wasm API (see packResult in
+// lexer.c), so the wrapper reads them with the same readParseResult.
+#include <node_api.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef void *(*Allocator)(uint32_t bytes, void *user_data);
+typedef struct {
+  uint32_t start;
+  uint32_t end;
+} Region;
+
+// src/lexer.c
+int32_t* parse_packed (unsigned char* source, uint32_t sourceLen, uint32_t options, Allocator alloc, void* user_data, uint32_t* packedLen);
+int32_t** parse_regions_packed (unsigned char* source, uint32_t sourceLen, const Region* regions, uint32_t regionCount, uint32_t options, Allocator alloc, void* user_data, uint32_t* packedCount, uint32_t* packedLens);
+// src/addon/lexer16.c
+int32_t* parse_packed16 (uint16_t* source, uint32_t sourceLen, uint32_t options, Allocator alloc, void* user_data, uint32_t* packedLen);
+int32_t** parse_regions_packed16 (uint16_t* source, uint32_t sourceLen, const Region* regions, uint32_t regionCount, uint32_t options, Allocator alloc, void* user_data, uint32_t* packedCount, uint32_t* packedLens);
+int32_t unescape16 (const uint16_t* start, const uint16_t* end, uint16_t* out);
+
+#define CHECK(call) if ((call) != napi_ok) return NULL
+
+// Analysis memory of one parse, in blocks freed together once the results
+// are copied out.
+typedef struct Block Block;
+struct Block {
+  Block* prev;
+  size_t used;
+  size_t size;
+};
+
+static void* arenaAlloc (uint32_t bytes, void* user_data) {
+  Block** head = user_data;
+  size_t size = ((size_t)bytes + 7) & ~(size_t)7;
+  Block* block = *head;
+  if (!block || block->used + size > block->size) {
+    size_t blockSize = size > 65536 ? size : 65536;
+    block = malloc(sizeof(Block) + blockSize);
+    if (!block)
+      napi_fatal_error("es-module-lexer", NAPI_AUTO_LENGTH, "out of memory", NAPI_AUTO_LENGTH);
+    block->prev = *head;
+    block->used = 0;
+    block->size = blockSize;
+    *head = block;
+  }
+  void* ptr = (uint8_t*)(block + 1) + block->used;
+  block->used += size;
+  return ptr;
+}
+
+static void arenaFree (Block* head) {
+  while (head) {
+    Block* prev = head->prev;
+    free(head);
+    head = prev;
+  }
+}
+
+typedef struct {
+  // UTF-16 copied out of a string, or the bytes copied out of a Uint8Array,
+  // followed by the terminator the lexer reads
+  void* source;
+  uint32_t sourceLen;
+  bool utf16;
+  uint32_t options;
+  Block* arena;
+  int32_t* packed;
+  uint32_t packedLen;
+  napi_async_work work;
+  napi_deferred deferred;
+} Job;
+
+static napi_status readSource (napi_env env, napi_value value, Job* job) {
+  napi_valuetype type;
+  napi_status status = napi_typeof(env, value, &type);
+  if (status != napi_ok)
+    return status;
+  if (type == napi_string) {
+    size_t len;
+    if ((status = napi_get_value_string_utf16(env, value, NULL, 0, &len)) != napi_ok)
+      return status;
+    job->source = malloc((len + 1) * sizeof(uint16_t));
+    if (!job->source)
+      napi_fatal_error("es-module-lexer", NAPI_AUTO_LENGTH, "out of memory", NAPI_AUTO_LENGTH);
+    job->sourceLen = len;
+    job->utf16 = true;
+    return napi_get_value_string_utf16(env, value, job->source, len + 1, &len);
+  }
+  bool isTypedArray = false;
+  if (type == napi_object && (status = napi_is_typedarray(env, value, &isTypedArray)) != napi_ok)
+    return status;
+  if (isTypedArray) {
+    napi_typedarray_type arrayType;
+    size_t len;
+    void* data;
+    if ((status = napi_get_typedarray_info(env, value, &arrayType, &len, &data, NULL, NULL)) != napi_ok)
+      return status;
+    if (arrayType == napi_uint8_array) {
+      job->source = malloc(len + 1);
+      if (!job->source)
+        napi_fatal_error("es-module-lexer", NAPI_AUTO_LENGTH, "out of memory", NAPI_AUTO_LENGTH);
+      // an empty array may have no backing store
+      if (len)
+        memcpy(job->source, data, len);
+      ((unsigned char*)job->source)[len] = '\0';
+      job->sourceLen = len;
+      job->utf16 = false;
+      return napi_ok;
+    }
+  }
+  napi_throw_type_error(env, NULL, "The source must be a string or Uint8Array");
+  return napi_pending_exception;
+}
+
+static void lex (Job* job) {
+  job->packed = job->utf16
+      ? parse_packed16(job->source, job->sourceLen, job->options, arenaAlloc, &job->arena, &job->packedLen)
+      : parse_packed(job->source, job->sourceLen, job->options, arenaAlloc, &job->arena, &job->packedLen);
+}
+
+static napi_value packedArray (napi_env env, Job* job) {
+  napi_value buffer, array;
+  void* data;
+  CHECK(napi_create_arraybuffer(env, job->packedLen * sizeof(int32_t), &data, &buffer));
+  memcpy(data, job->packed, job->packedLen * sizeof(int32_t));
+  CHECK(napi_create_typedarray(env, napi_int32_array, job->packedLen, buffer, 0, &array));
+  return array;
+}
+
+static void freeJob (Job* job) {
+  arenaFree(job->arena);
+  free(job->source);
+}
+
+static bool readArgs (napi_env env, napi_callback_info info, Job* job, napi_value* source) {
+  size_t argc = 2;
+  napi_value argv[2];
+  if (napi_get_cb_info(env, info, &argc, argv, NULL, NULL) != napi_ok)
+    return false;
+  if (argc < 2) {
+    napi_throw_type_error(env, NULL, "Expected a source and option flags");
+    return false;
+  }
+  *source = argv[0];
+  return napi_get_value_uint32(env, argv[1], &job->options) == napi_ok && readSource(env, argv[0], job) == napi_ok;
+}
+
+// parse (source, options), returning the packed results
+static napi_value Parse (napi_env env, napi_callback_info info) {
+  Job job = { 0 };
+  napi_value source, result = NULL;
+  if (readArgs(env, info, &job, &source)) {
+    lex(&job);
+    result = packedArray(env, &job);
+  }
+  freeJob(&job);
+  return result;
+}
+
+// parseRegions (source, regions, options), returning the packed results of
+// each region up to the first that failed, with the regions a Uint32Array of
+// start and end pairs
+static napi_value ParseRegions (napi_env env, napi_callback_info info) {
+  size_t argc = 3, regionsLen;
+  napi_value argv[3], result = NULL;
+  napi_typedarray_type regionsType;
+  void* regionsData;
+  bool isTypedArray = false;
+  Job job = { 0 };
+  CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  if (argc < 3 || napi_is_typedarray(env, argv[1], &isTypedArray) != napi_ok || !isTypedArray ||
+      napi_get_typedarray_info(env, argv[1], &regionsType, &regionsLen, &regionsData, NULL, NULL) != napi_ok ||
+      regionsType != napi_uint32_array) {
+    napi_throw_type_error(env, NULL, "Expected a source, a Uint32Array of regions and option flags");
+    return NULL;
+  }
+  CHECK(napi_get_value_uint32(env, argv[2], &job.options));
+  if (readSource(env, argv[0], &job) != napi_ok) {
+    freeJob(&job);
+    return NULL;
+  }
+  const Region* regions = regionsData;
+  uint32_t regionCount = regionsLen / 2, packedCount = 0;
+  for (uint32_t i = 0; i < regionCount; i++) {
+    if (regions[i].start > regions[i].end || regions[i].end > job.sourceLen) {
+      napi_throw_range_error(env, NULL, "Regions must lie within the source");
+      freeJob(&job);
+      return NULL;
+    }
+  }
+  uint32_t* packedLens = arenaAlloc(regionCount * sizeof(uint32_t), &job.arena);
+  int32_t** packed = job.utf16
+      ? parse_regions_packed16(job.source, job.sourceLen, regions, regionCount, job.options, arenaAlloc, &job.arena, &packedCount, packedLens)
+      : parse_regions_packed(job.source, job.sourceLen, regions, regionCount, job.options, arenaAlloc, &job.arena, &packedCount, packedLens);
+  if (napi_create_array_with_length(env, packedCount, &result) != napi_ok)
+    result = NULL;
+  for (uint32_t i = 0; i < packedCount && result; i++) {
+    job.packed = packed[i];
+    job.packedLen = packedLens[i];
+    napi_value array = packedArray(env, &job);
+    if (!array || napi_set_element(env, result, i, array) != napi_ok)
+      result = NULL;
+  }
+  freeJob(&job);
+  return result;
+}
+
+static void executeParse (napi_env env, void* data) {
+  lex(data);
+}
+
+static void completeParse (napi_env env, napi_status status, void* data) {
+  Job* job = data;
+  napi_value result;
+  if (status == napi_ok && (result = packedArray(env, job)) != NULL) {
+    napi_resolve_deferred(env, job->deferred, result);
+  }
+  else {
+    napi_value message, error;
+    napi_create_string_utf8(env, "Lexing was cancelled", NAPI_AUTO_LENGTH, &message);
+    napi_create_error(env, NULL, message, &error);
+    napi_reject_deferred(env, job->deferred, error);
+  }
+  napi_delete_async_work(env, job->work);
+  freeJob(job);
+  free(job);
+}
+
+// parseAsync (source, options), resolving to the packed results once lexed on
+// the libuv thread pool
+static napi_value ParseAsync (napi_env env, napi_callback_info info) {
+  Job* job = calloc(1, sizeof(Job));
+  napi_value source, name, promise;
+  if (!job)
+    napi_fatal_error("es-module-lexer", NAPI_AUTO_LENGTH, "out of memory", NAPI_AUTO_LENGTH);
+  if (!readArgs(env, info, job, &source) ||
+      napi_create_string_utf8(env, "es-module-lexer:parse", NAPI_AUTO_LENGTH, &name) != napi_ok ||
+      napi_create_async_work(env, NULL, name, executeParse, completeParse, job, &job->work) != napi_ok) {
+    freeJob(job);
+    free(job);
+    return NULL;
+  }
+  if (napi_create_promise(env, &job->deferred, &promise) != napi_ok || napi_queue_async_work(env, job->work) != napi_ok) {
+    napi_delete_async_work(env, job->work);
+    freeJob(job);
+    free(job);
+    return NULL;
+  }
+  return promise;
+}
+
+// unescape (str), decoding string literal contents, or undefined for an
+// invalid escape
+static napi_value Unescape (napi_env env, napi_callback_info info) {
+  size_t argc = 1, len;
+  napi_value arg, result;
+  CHECK(napi_get_cb_info(env, info, &argc, &arg, NULL, NULL));
+  CHECK(napi_get_value_string_utf16(env, arg, NULL, 0, &len));
+  uint16_t stackBuf[256];
+  uint16_t* buf = len < 256 ? stackBuf : malloc((len + 1) * sizeof(uint16_t));
+  if (!buf)
+    napi_fatal_error("es-module-lexer", NAPI_AUTO_LENGTH, "out of memory", NAPI_AUTO_LENGTH);
+  napi_status status = napi_get_value_string_utf16(env, arg, buf, len + 1, &len);
+  if (status == napi_ok) {
+    int32_t outLen = unescape16(buf, buf + len, buf);
+    status = outLen == -1 ? napi_get_undefined(env, &result) : napi_create_string_utf16(env, buf, outLen, &result);
+  }
+  if (buf != stackBuf)
+    free(buf);
+  return status == napi_ok ? result : NULL;
+}
+
+// decodeUtf8 (bytes, start, end), the string of the UTF-8 bytes[start, end), for
+// names read from a Uint8Array source
+static napi_value DecodeUtf8 (napi_env env, napi_callback_info info) {
+  size_t argc = 3, len;
+  napi_value argv[3], result;
+  napi_typedarray_type type;
+  void* data;
+  uint32_t start, end;
+  CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  CHECK(napi_get_typedarray_info(env, argv[0], &type, &len, &data, NULL, NULL));
+  CHECK(napi_get_value_uint32(env, argv[1], &start));
+  CHECK(napi_get_value_uint32(env, argv[2], &end));
+  if (type != napi_uint8_array || end > len) {
+    napi_throw_range_error(env, NULL, "Expected a span of a Uint8Array");
+    return NULL;
+  }
+  // empty when start is past end, as for String.prototype.slice
+  CHECK(napi_create_string_utf8(env, (const char*)data + start, start < end ? end - start : 0, &result));
+  return result;
+}
+
+static napi_value Init (napi_env env, napi_value exports) {
+  napi_property_descriptor properties[] = {
+    { "parse", NULL, Parse, NULL, NULL, NULL, napi_enumerable, NULL },
+    { "parseAsync", NULL, ParseAsync, NULL, NULL, NULL, napi_enumerable, NULL },
+    { "parseRegions", NULL, ParseRegions, NULL, NULL, NULL, napi_enumerable, NULL },
+    { "unescape", NULL, Unescape, NULL, NULL, NULL, napi_enumerable, NULL },
+    { "decodeUtf8", NULL, DecodeUtf8, NULL, NULL, NULL, napi_enumerable, NULL }
+  };
+  CHECK(napi_define_properties(env, exports, sizeof(properties) / sizeof(properties[0]), properties));
+  return exports;
+}
+
+NAPI_MODULE(NODE_GYP_MODULE_NAME, Init)
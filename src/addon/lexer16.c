@@ -0,0 +1,13 @@
+// The UTF-16 build of the lexer for the native addon, which lexes JS strings
+// copied out as UTF-16. src/lexer.c itself is compiled as the one-byte build,
+// so the external symbols are renamed here to link both into one binary.
+#define LEXER_UTF16
+#define parse parse16
+#define parse_init parse_init16
+#define parse_step parse_step16
+#define parse_regions parse_regions16
+#define parse_packed parse_packed16
+#define parse_regions_packed parse_regions_packed16
+#define unescape unescape16
+
+#include "../lexer.c"
@@ -0,0 +1,34 @@
+//! Serves lex requests on a Unix domain socket until a client shuts it down.
+//!
+//! Usage: es-module-lexer-daemon <socket> [--threads <n>] [--max-cache-bytes <n>]
+
+use es_module_lexer::daemon::{Daemon, DaemonOptions};
+use std::{env, path::PathBuf, process};
+
+fn usage() -> ! {
+  eprintln!("Usage: es-module-lexer-daemon <socket> [--threads <n>] [--max-cache-bytes <n>]");
+  process::exit(2);
+}
+
+fn main() {
+  let mut args = env::args().skip(1);
+  let mut socket: Option<PathBuf> = None;
+  let mut options = DaemonOptions::default();
+  while let Some(arg) = args.next() {
+    match arg.as_str() {
+      "--threads" => options.threads = args.next().and_then(|n| n.parse().ok()).unwrap_or_else(|| usage()),
+      "--max-cache-bytes" => {
+        options.max_cache_bytes = args.next().and_then(|n| n.parse().ok()).unwrap_or_else(|| usage())
+      }
+      _ if socket.is_none() && !arg.starts_with("--") => socket = Some(PathBuf::from(arg)),
+      _ => usage(),
+    }
+  }
+  let socket = socket.unwrap_or_else(|| usage());
+
+  let result = Daemon::bind(&socket, &options).and_then(|daemon| daemon.run());
+  if let Err(err) = result {
+    eprintln!("es-module-lexer-daemon: {}", err);
+    process::exit(1);
+  }
+}
@@ -0,0 +1,469 @@
+//! Binary serialization of lex results, for sending them between processes.
+//!
+//! The format is a sequence of little-endian `u32` words, so it can be read in
+//! place from any byte slice, including a shared memory mapping, without
+//! alignment requirements or deserializing:
+//!
+//! - a header of `HEADER_WORDS` words: magic, version, flags, import count,
+//!   export count, line count, string pool byte length and total byte length,
+//! - `IMPORT_WORDS` words per import: start, end, statement start, statement
+//!   end, assert index, kind and the string pool offset and length of the
+//!   decoded specifier,
+//! - `EXPORT_WORDS` words per export: start, end, local start, local end, cjs
+//!   and the string pool offsets and lengths of the decoded exported and local
+//!   names,
+//! - the line starts, when lexed with `LexOptions::line_starts`,
+//! - the optional UTF-8 string pool, padded to a word.
+//!
+//! All offsets are byte offsets into the source, and absent values are `NONE`.
+//! Strings that aren't in the pool, or that are absent, have a `NONE` offset.
+
+use crate::{line_col, unescape, ExportOffsets, Import, ImportKind, ImportOffsets, LexResult};
+use std::{borrow::Cow, fmt};
+
+pub const MAGIC: u32 = u32::from_le_bytes(*b"ESML");
+pub const VERSION: u32 = 1;
+pub const NONE: u32 = u32::MAX;
+
+const HEADER_WORDS: usize = 8;
+const IMPORT_WORDS: usize = 8;
+const EXPORT_WORDS: usize = 9;
+
+const FLAG_FAST_REJECTED: u32 = 1;
+const FLAG_LINE_STARTS: u32 = 2;
+const FLAG_STRINGS: u32 = 4;
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum FormatError {
+  /// The buffer is shorter than the length it declares, or than its tables.
+  Truncated,
+  BadMagic,
+  UnsupportedVersion(u32),
+  /// A record holds an out of range value.
+  Invalid,
+}
+
+impl fmt::Display for FormatError {
+  fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+    match self {
+      FormatError::Truncated => write!(f, "Truncated lex result"),
+      FormatError::BadMagic => write!(f, "Not a serialized lex result"),
+      FormatError::UnsupportedVersion(version) => write!(f, "Unsupported lex result version {}", version),
+      FormatError::Invalid => write!(f, "Invalid lex result"),
+    }
+  }
+}
+
+impl std::error::Error for FormatError {}
+
+fn kind_to_u32(kind: ImportKind) -> u32 {
+  match kind {
+    ImportKind::Standard => 0,
+    ImportKind::DynamicString => 1,
+    ImportKind::DynamicExpression => 2,
+    ImportKind::Meta => 3,
+  }
+}
+
+fn opt(offset: Option<usize>) -> u32 {
+  offset.map_or(NONE, |offset| offset as u32)
+}
+
+// decoded string of an exported or local name, which may be a string literal
+fn decode_name(name: &str) -> Cow<'_, str> {
+  match name.as_bytes().first() {
+    Some(b'"' | b'\'') if name.len() >= 2 => {
+      let body = &name[1..name.len() - 1];
+      unescape(body).unwrap_or(Cow::Borrowed(body))
+    }
+    _ => Cow::Borrowed(name),
+  }
+}
+
+fn import_specifier<'a>(import: &Import<'a>) -> Option<Cow<'a, str>> {
+  match import.kind() {
+    ImportKind::Standard | ImportKind::DynamicString if !import.end.is_null() => Some(import.specifier()),
+    _ => None,
+  }
+}
+
+struct Writer<'b> {
+  buf: &'b mut [u8],
+  pos: usize,
+  strings_start: usize,
+  strings_pos: usize,
+}
+
+impl<'b> Writer<'b> {
+  fn word(&mut self, value: u32) {
+    self.buf[self.pos..self.pos + 4].copy_from_slice(&value.to_le_bytes());
+    self.pos += 4;
+  }
+
+  fn string(&mut self, s: Option<&str>) {
+    match s {
+      Some(s) => {
+        self.word((self.strings_pos - self.strings_start) as u32);
+        self.word(s.len() as u32);
+        self.buf[self.strings_pos..self.strings_pos + s.len()].copy_from_slice(s.as_bytes());
+        self.strings_pos += s.len();
+      }
+      None => {
+        self.word(NONE);
+        self.word(0);
+      }
+    }
+  }
+}
+
+impl<'a> LexResult<'a> {
+  fn strings_len(&'a self) -> usize {
+    let imports: usize = self.imports().filter_map(|i| import_specifier(i)).map(|s| s.len()).sum();
+    let exports: usize = self
+      .exports()
+      .map(|e| decode_name(e.exported()).len() + e.local().map_or(0, |l| decode_name(l).len()))
+      .sum();
+    imports + exports
+  }
+
+  fn tables_len(&'a self) -> usize {
+    let words = HEADER_WORDS
+      + self.imports().count() * IMPORT_WORDS
+      + self.exports().count() * EXPORT_WORDS
+      + self.line_starts().map_or(0, |l| l.len());
+    words * 4
+  }
+
+  /// Byte length of the serialized result, with or without the string pool.
+  pub fn serialized_len(&'a self, strings: bool) -> usize {
+    self.tables_len() + if strings { (self.strings_len() + 3) & !3 } else { 0 }
+  }
+
+  /// Serializes the result into the start of the buffer, returning the number
+  /// of bytes written, or `Err` with the required length if the buffer is too
+  /// small. With `strings`, decoded import specifiers and export names are
+  /// included so they can be read without the source.
+  pub fn serialize_into(&'a self, buf: &mut [u8], strings: bool) -> Result<usize, usize> {
+    let strings_start = self.tables_len();
+    let len = strings_start + if strings { (self.strings_len() + 3) & !3 } else { 0 };
+    if buf.len() < len {
+      return Err(len);
+    }
+    let import_count = self.imports().count();
+    let export_count = self.exports().count();
+    let line_starts = self.line_starts();
+
+    let mut w = Writer {
+      buf,
+      pos: 0,
+      strings_start,
+      strings_pos: strings_start,
+    };
+    w.word(MAGIC);
+    w.word(VERSION);
+    w.word(
+      (if self.fast_rejected { FLAG_FAST_REJECTED } else { 0 })
+        | (if line_starts.is_some() { FLAG_LINE_STARTS } else { 0 })
+        | (if strings { FLAG_STRINGS } else { 0 }),
+    );
+    w.word(import_count as u32);
+    w.word(export_count as u32);
+    w.word(line_starts.map_or(0, |l| l.len() as u32));
+    w.word((len - strings_start) as u32);
+    w.word(len as u32);
+
+    for import in self.imports() {
+      let offsets = self.import_offsets(import);
+      w.word(offsets.start as u32);
+      w.word(offsets.end as u32);
+      w.word(offsets.statement_start as u32);
+      w.word(opt(offsets.statement_end));
+      w.word(opt(offsets.assert_index));
+      w.word(kind_to_u32(import.kind()));
+      w.string(strings.then(|| import_specifier(import)).flatten().as_deref());
+    }
+    for export in self.exports() {
+      let offsets = self.export_offsets(export);
+      w.word(offsets.start as u32);
+      w.word(offsets.end as u32);
+      w.word(opt(offsets.local_start));
+      w.word(opt(offsets.local_end));
+      w.word(export.is_cjs() as u32);
+      w.string(strings.then(|| decode_name(export.exported())).as_deref());
+      w.string(strings.then(|| export.local().map(decode_name)).flatten().as_deref());
+    }
+    for &line_start in line_starts.unwrap_or(&[]) {
+      w.word(line_start);
+    }
+    w.buf[w.strings_pos..len].fill(0);
+    Ok(len)
+  }
+
+  /// Serializes the result into a new buffer, see `serialize_into`.
+  pub fn serialize(&'a self, strings: bool) -> Vec<u8> {
+    let mut buf = vec![0; self.serialized_len(strings)];
+    self.serialize_into(&mut buf, strings).unwrap();
+    buf
+  }
+}
+
+fn read(bytes: &[u8], word: usize) -> u32 {
+  u32::from_le_bytes(bytes[word * 4..word * 4 + 4].try_into().unwrap())
+}
+
+fn read_opt(bytes: &[u8], word: usize) -> Option<usize> {
+  match read(bytes, word) {
+    NONE => None,
+    value => Some(value as usize),
+  }
+}
+
+/// A serialized lex result, read in place.
+#[derive(Clone, Copy)]
+pub struct LexResultView<'b> {
+  bytes: &'b [u8],
+  flags: u32,
+  import_count: usize,
+  export_count: usize,
+  line_count: usize,
+  strings: &'b [u8],
+}
+
+impl<'b> LexResultView<'b> {
+  /// Validates the header and table lengths of a serialized result. Trailing
+  /// bytes past its declared length are ignored.
+  pub fn from_bytes(bytes: &'b [u8]) -> Result<Self, FormatError> {
+    if bytes.len() < HEADER_WORDS * 4 {
+      return Err(FormatError::Truncated);
+    }
+    if read(bytes, 0) != MAGIC {
+      return Err(FormatError::BadMagic);
+    }
+    let version = read(bytes, 1);
+    if version != VERSION {
+      return Err(FormatError::UnsupportedVersion(version));
+    }
+    let flags = read(bytes, 2);
+    let import_count = read(bytes, 3) as usize;
+    let export_count = read(bytes, 4) as usize;
+    let line_count = read(bytes, 5) as usize;
+    let strings_len = read(bytes, 6) as usize;
+    let len = read(bytes, 7) as usize;
+    if len > bytes.len() {
+      return Err(FormatError::Truncated);
+    }
+    let tables_len = (HEADER_WORDS + import_count * IMPORT_WORDS + export_count * EXPORT_WORDS + line_count) * 4;
+    if tables_len.checked_add(strings_len) != Some(len) {
+      return Err(FormatError::Invalid);
+    }
+    Ok(LexResultView {
+      bytes: &bytes[..tables_len],
+      flags,
+      import_count,
+      export_count,
+      line_count,
+      strings: &bytes[tables_len..len],
+    })
+  }
+
+  pub fn fast_rejected(&self) -> bool {
+    self.flags & FLAG_FAST_REJECTED != 0
+  }
+
+  /// Whether decoded strings were serialized.
+  pub fn has_strings(&self) -> bool {
+    self.flags & FLAG_STRINGS != 0
+  }
+
+  pub fn import_count(&self) -> usize {
+    self.import_count
+  }
+
+  pub fn export_count(&self) -> usize {
+    self.export_count
+  }
+
+  pub fn import(&self, index: usize) -> Option<ImportView<'b>> {
+    (index < self.import_count).then(|| ImportView {
+      view: *self,
+      word: HEADER_WORDS + index * IMPORT_WORDS,
+    })
+  }
+
+  pub fn export(&self, index: usize) -> Option<ExportView<'b>> {
+    (index < self.export_count).then(|| ExportView {
+      view: *self,
+      word: HEADER_WORDS + self.import_count * IMPORT_WORDS + index * EXPORT_WORDS,
+    })
+  }
+
+  pub fn imports(&self) -> impl Iterator<Item = ImportView<'b>> + '_ {
+    (0..self.import_count).map(|i| self.import(i).unwrap())
+  }
+
+  pub fn exports(&self) -> impl Iterator<Item = ExportView<'b>> + '_ {
+    (0..self.export_count).map(|i| self.export(i).unwrap())
+  }
+
+  /// Byte offsets of the start of every line, when lexed with
+  /// `LexOptions::line_starts`. Copies, as the words may be unaligned.
+  pub fn line_starts(&self) -> Option<Vec<u32>> {
+    if self.flags & FLAG_LINE_STARTS == 0 {
+      return None;
+    }
+    let first = HEADER_WORDS + self.import_count * IMPORT_WORDS + self.export_count * EXPORT_WORDS;
+    Some((first..first + self.line_count).map(|word| read(self.bytes, word)).collect())
+  }
+
+  /// Line and byte column of a byte offset, see `line_col`.
+  pub fn line_col(&self, offset: usize) -> Option<(usize, usize)> {
+    self.line_starts().map(|line_starts| line_col(&line_starts, offset))
+  }
+
+  fn string(&self, word: usize) -> Option<&'b str> {
+    let start = read_opt(self.bytes, word)?;
+    let len = read(self.bytes, word + 1) as usize;
+    let bytes = self.strings.get(start..start.checked_add(len)?)?;
+    std::str::from_utf8(bytes).ok()
+  }
+}
+
+#[derive(Clone, Copy)]
+pub struct ImportView<'b> {
+  view: LexResultView<'b>,
+  word: usize,
+}
+
+impl<'b> ImportView<'b> {
+  fn read(&self, field: usize) -> u32 {
+    read(self.view.bytes, self.word + field)
+  }
+
+  pub fn offsets(&self) -> ImportOffsets {
+    ImportOffsets {
+      start: self.read(0) as usize,
+      end: self.read(1) as usize,
+      statement_start: self.read(2) as usize,
+      statement_end: read_opt(self.view.bytes, self.word + 3),
+      assert_index: read_opt(self.view.bytes, self.word + 4),
+    }
+  }
+
+  pub fn kind(&self) -> Result<ImportKind, FormatError> {
+    match self.read(5) {
+      0 => Ok(ImportKind::Standard),
+      1 => Ok(ImportKind::DynamicString),
+      2 => Ok(ImportKind::DynamicExpression),
+      3 => Ok(ImportKind::Meta),
+      _ => Err(FormatError::Invalid),
+    }
+  }
+
+  /// The decoded specifier of a `Standard` or `DynamicString` import, when
+  /// serialized with strings.
+  pub fn specifier(&self) -> Option<&'b str> {
+    self.view.string(self.word + 6)
+  }
+}
+
+#[derive(Clone, Copy)]
+pub struct ExportView<'b> {
+  view: LexResultView<'b>,
+  word: usize,
+}
+
+impl<'b> ExportView<'b> {
+  pub fn offsets(&self) -> ExportOffsets {
+    let bytes = self.view.bytes;
+    ExportOffsets {
+      start: read(bytes, self.word) as usize,
+      end: read(bytes, self.word + 1) as usize,
+      local_start: read_opt(bytes, self.word + 2),
+      local_end: read_opt(bytes, self.word + 3),
+    }
+  }
+
+  pub fn is_cjs(&self) -> bool {
+    read(self.view.bytes, self.word + 4) != 0
+  }
+
+  /// The decoded exported name, when serialized with strings.
+  pub fn exported(&self) -> Option<&'b str> {
+    self.view.string(self.word + 5)
+  }
+
+  /// The decoded local name, when serialized with strings.
+  pub fn local(&self) -> Option<&'b str> {
+    self.view.string(self.word + 7)
+  }
+}
+
+#[cfg(test)]
+mod tests {
+  use super::*;
+  use crate::{lex, lex_with_options, LexOptions};
+
+  #[test]
+  fn round_trip() {
+    let source =
+      "import a from './\\x61.js';\nexport { a as 'b\\u0063' };\nimport(x);\nexport const d = import.meta;";
+    let res = lex_with_options(
+      source,
+      &LexOptions {
+        line_starts: true,
+        ..Default::default()
+      },
+    )
+    .unwrap();
+
+    let mut buf = vec![0xff; res.serialized_len(true) + 3];
+    let len = res.serialize_into(&mut buf[3..], true).unwrap();
+    assert_eq!(len, buf.len() - 3);
+    assert_eq!(res.serialize_into(&mut buf[..len - 1], true), Err(len));
+
+    // unaligned, as from a shared memory offset
+    let view = LexResultView::from_bytes(&buf[3..]).unwrap();
+    assert!(view.has_strings() && !view.fast_rejected());
+    assert_eq!(view.import_count(), res.imports().count());
+    for (import, stored) in res.imports().zip(view.imports()) {
+      assert_eq!(stored.offsets(), res.import_offsets(import));
+      assert_eq!(stored.kind(), Ok(import.kind()));
+    }
+    let specifiers: Vec<Option<&str>> = view.imports().map(|i| i.specifier()).collect();
+    assert_eq!(specifiers, vec![Some("./a.js"), None, None]);
+    for (export, stored) in res.exports().zip(view.exports()) {
+      assert_eq!(stored.offsets(), res.export_offsets(export));
+    }
+    let names: Vec<(Option<&str>, Option<&str>)> = view.exports().map(|e| (e.exported(), e.local())).collect();
+    assert_eq!(names, vec![(Some("bc"), Some("a")), (Some("d"), Some("d"))]);
+    assert_eq!(view.line_starts().as_deref(), res.line_starts());
+    assert_eq!(view.line_col(source.len()), res.line_col(source.len()));
+
+    let bytes = lex(source).unwrap().serialize(false);
+    let view = LexResultView::from_bytes(&bytes).unwrap();
+    assert_eq!(view.line_starts(), None);
+    assert_eq!(view.export(0).unwrap().exported(), None);
+    assert!(view.export(2).is_none());
+  }
+
+  #[test]
+  fn malformed() {
+    let bytes = lex("import 'a';").unwrap().serialize(true);
+    assert_eq!(
+      LexResultView::from_bytes(&bytes[..bytes.len() - 1]).err(),
+      Some(FormatError::Truncated)
+    );
+    let mut bad = bytes.clone();
+    bad[0] = 0;
+    assert_eq!(LexResultView::from_bytes(&bad).err(), Some(FormatError::BadMagic));
+    let mut bad = bytes.clone();
+    bad[4] = 2;
+    assert_eq!(
+      LexResultView::from_bytes(&bad).err(),
+      Some(FormatError::UnsupportedVersion(2))
+    );
+    let mut bad = bytes.clone();
+    bad[12] = 9;
+    assert_eq!(LexResultView::from_bytes(&bad).err(), Some(FormatError::Invalid));
+  }
+}
@@ -0,0 +1,651 @@
+//! Lexing daemon and client over a Unix domain socket.
+//!
+//! The daemon keeps lex results cached in memory, keyed by path and options,
+//! so short-lived tool processes can share the work of a long-running one.
+//! A cached result is reused while the file's mtime and length are unchanged,
+//! and after a change when the content hash still matches. Batches are lexed
+//! on an internal worker pool, and results are returned in the `binary` format
+//! with decoded strings, to be read in place with `LexResultView`.
+//!
+//! The protocol is a sequence of frames, each a little-endian `u32` byte
+//! length and a payload whose first word is the op:
+//!
+//! - `OP_LEX`: option flags, path count, then each absolute path as a length
+//!   and its bytes, replied to with one `STATUS_*` word per path in order,
+//!   followed by the serialized result, parse error offset or error message,
+//! - `OP_STATS`: replied to with the cache entry count, hits and misses,
+//! - `OP_SHUTDOWN`: replied to with an empty frame, then the daemon exits.
+
+use crate::{lex_with_options, LexOptions};
+use std::{
+  collections::HashMap,
+  fmt, fs,
+  io::{self, Read, Write},
+  os::unix::{
+    fs::FileTypeExt,
+    net::{UnixListener, UnixStream},
+  },
+  panic::{self, AssertUnwindSafe},
+  path::{Path, PathBuf},
+  sync::{
+    atomic::{AtomicBool, AtomicU64, Ordering},
+    mpsc, Arc, Mutex,
+  },
+  thread,
+  time::SystemTime,
+};
+
+const OP_LEX: u32 = 1;
+const OP_STATS: u32 = 2;
+const OP_SHUTDOWN: u32 = 3;
+
+const STATUS_OK: u32 = 0;
+const STATUS_PARSE_ERROR: u32 = 1;
+const STATUS_IO_ERROR: u32 = 2;
+
+// option flags of an OP_LEX request
+const FLAG_LINE_STARTS: u32 = 1;
+const FLAG_CJS_EXPORTS: u32 = 2;
+const FLAG_FAST_REJECT: u32 = 4;
+
+// frames beyond this are rejected rather than allocated
+const MAX_FRAME: usize = 1 << 30;
+
+pub struct DaemonOptions {
+  /// Number of worker threads, 0 to use the available parallelism.
+  pub threads: usize,
+  /// Upper bound on the total size of cached results, beyond which the least
+  /// recently used are evicted.
+  pub max_cache_bytes: usize,
+}
+
+impl Default for DaemonOptions {
+  fn default() -> Self {
+    DaemonOptions {
+      threads: 0,
+      max_cache_bytes: 256 * 1024 * 1024,
+    }
+  }
+}
+
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub enum FileError {
+  /// The file couldn't be read or isn't UTF-8, or lexing it panicked.
+  Io(String),
+  /// Lexer error at the given byte offset.
+  Parse(usize),
+}
+
+impl fmt::Display for FileError {
+  fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+    match self {
+      FileError::Io(message) => write!(f, "{}", message),
+      FileError::Parse(offset) => write!(f, "Parse error at {}", offset),
+    }
+  }
+}
+
+/// Serialized lex result of a file, see `LexResultView::from_bytes`.
+pub type FileResult = Result<Arc<Vec<u8>>, FileError>;
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub struct CacheStats {
+  pub entries: usize,
+  pub hits: u64,
+  pub misses: u64,
+}
+
+fn option_flags(options: &LexOptions) -> u32 {
+  (if options.line_starts { FLAG_LINE_STARTS } else { 0 })
+    | (if options.cjs_exports { FLAG_CJS_EXPORTS } else { 0 })
+    | (if options.fast_reject { FLAG_FAST_REJECT } else { 0 })
+}
+
+fn lex_options(flags: u32) -> LexOptions {
+  LexOptions {
+    line_starts: flags & FLAG_LINE_STARTS != 0,
+    cjs_exports: flags & FLAG_CJS_EXPORTS != 0,
+    fast_reject: flags & FLAG_FAST_REJECT != 0,
+    ..Default::default()
+  }
+}
+
+// FNV-1a
+fn content_hash(bytes: &[u8]) -> u64 {
+  let mut hash: u64 = 0xcbf29ce484222325;
+  for &b in bytes {
+    hash = (hash ^ b as u64).wrapping_mul(0x100000001b3);
+  }
+  hash
+}
+
+fn read_frame(stream: &mut UnixStream) -> io::Result<Option<Vec<u8>>> {
+  let mut len = [0; 4];
+  match stream.read_exact(&mut len) {
+    Err(err) if err.kind() == io::ErrorKind::UnexpectedEof => return Ok(None),
+    result => result?,
+  }
+  let len = u32::from_le_bytes(len) as usize;
+  if len > MAX_FRAME {
+    return Err(io::Error::new(io::ErrorKind::InvalidData, "Frame too large"));
+  }
+  let mut frame = vec![0; len];
+  stream.read_exact(&mut frame)?;
+  Ok(Some(frame))
+}
+
+fn write_frame(stream: &mut UnixStream, frame: &[u8]) -> io::Result<()> {
+  stream.write_all(&(frame.len() as u32).to_le_bytes())?;
+  stream.write_all(frame)
+}
+
+// reads the words and byte strings of a frame
+struct FrameReader<'f> {
+  frame: &'f [u8],
+  pos: usize,
+}
+
+impl<'f> FrameReader<'f> {
+  fn word(&mut self) -> io::Result<u32> {
+    Ok(u32::from_le_bytes(self.bytes(4)?.try_into().unwrap()))
+  }
+
+  fn bytes(&mut self, len: usize) -> io::Result<&'f [u8]> {
+    let bytes = self
+      .frame
+      .get(self.pos..self.pos.saturating_add(len))
+      .ok_or_else(|| io::Error::new(io::ErrorKind::InvalidData, "Truncated frame"))?;
+    self.pos += len;
+    Ok(bytes)
+  }
+
+  fn string(&mut self) -> io::Result<&'f str> {
+    let len = self.word()? as usize;
+    std::str::from_utf8(self.bytes(len)?).map_err(|err| io::Error::new(io::ErrorKind::InvalidData, err))
+  }
+}
+
+fn push_word(frame: &mut Vec<u8>, word: u32) {
+  frame.extend_from_slice(&word.to_le_bytes());
+}
+
+fn push_bytes(frame: &mut Vec<u8>, bytes: &[u8]) {
+  push_word(frame, bytes.len() as u32);
+  frame.extend_from_slice(bytes);
+}
+
+struct CacheEntry {
+  mtime: SystemTime,
+  len: u64,
+  hash: u64,
+  result: FileResult,
+  last_used: u64,
+}
+
+impl CacheEntry {
+  fn size(&self) -> usize {
+    match &self.result {
+      Ok(bytes) => bytes.len(),
+      Err(_) => 0,
+    }
+  }
+}
+
+struct Cache {
+  entries: HashMap<(PathBuf, u32), CacheEntry>,
+  bytes: usize,
+  clock: u64,
+}
+
+struct Shared {
+  cache: Mutex<Cache>,
+  max_cache_bytes: usize,
+  hits: AtomicU64,
+  misses: AtomicU64,
+}
+
+impl Shared {
+  fn lex_file(&self, path: &Path, flags: u32) -> FileResult {
+    // a relative path would resolve against the daemon's working directory,
+    // not the client's
+    if path.is_relative() {
+      return Err(FileError::Io("Path is not absolute".to_string()));
+    }
+    let key = (path.to_path_buf(), flags);
+    let metadata = fs::metadata(path).map_err(|err| FileError::Io(err.to_string()))?;
+    let mtime = metadata.modified().map_err(|err| FileError::Io(err.to_string()))?;
+    let mut cached_hash = None;
+    {
+      let mut cache = self.cache.lock().unwrap();
+      cache.clock += 1;
+      let clock = cache.clock;
+      if let Some(entry) = cache.entries.get_mut(&key) {
+        if entry.mtime == mtime && entry.len == metadata.len() {
+          entry.last_used = clock;
+          self.hits.fetch_add(1, Ordering::Relaxed);
+          return entry.result.clone();
+        }
+        cached_hash = Some(entry.hash);
+      }
+    }
+
+    let source = fs::read(path).map_err(|err| FileError::Io(err.to_string()))?;
+    let hash = content_hash(&source);
+    let result = if cached_hash == Some(hash) {
+      // touched but unchanged, unless evicted since
+      let cache = self.cache.lock().unwrap();
+      cache.entries.get(&key).map(|entry| entry.result.clone())
+    } else {
+      None
+    };
+    if result.is_some() {
+      self.hits.fetch_add(1, Ordering::Relaxed);
+    }
+    let result = result.unwrap_or_else(|| {
+      self.misses.fetch_add(1, Ordering::Relaxed);
+      let source =
+        std::str::from_utf8(&source).map_err(|err| FileError::Io(format!("{}: {}", path.display(), err)))?;
+      match lex_with_options(source, &lex_options(flags)) {
+        Ok(res) => Ok(Arc::new(res.serialize(true))),
+        Err(offset) => Err(FileError::Parse(offset)),
+      }
+    });
+
+    let mut cache = self.cache.lock().unwrap();
+    cache.clock += 1;
+    let entry = CacheEntry {
+      mtime,
+      len: source.len() as u64,
+      hash,
+      result: result.clone(),
+      last_used: cache.clock,
+    };
+    cache.bytes += entry.size();
+    if let Some(old) = cache.entries.insert(key, entry) {
+      cache.bytes -= old.size();
+    }
+    if cache.bytes > self.max_cache_bytes {
+      self.evict(&mut cache);
+    }
+    result
+  }
+
+  // evicts the least recently used entries down to 3/4 of the budget
+  fn evict(&self, cache: &mut Cache) {
+    let mut by_use: Vec<(u64, (PathBuf, u32))> = cache
+      .entries
+      .iter()
+      .map(|(key, entry)| (entry.last_used, key.clone()))
+      .collect();
+    by_use.sort_unstable_by_key(|(last_used, _)| *last_used);
+    for (_, key) in by_use {
+      if cache.bytes <= self.max_cache_bytes / 4 * 3 {
+        break;
+      }
+      let entry = cache.entries.remove(&key).unwrap();
+      cache.bytes -= entry.size();
+    }
+  }
+}
+
+type Job = Box<dyn FnOnce() + Send>;
+
+// fixed set of threads running jobs from a shared queue
+struct WorkerPool {
+  sender: Mutex<mpsc::Sender<Job>>,
+}
+
+impl WorkerPool {
+  fn new(threads: usize) -> Self {
+    let (sender, receiver) = mpsc::channel::<Job>();
+    let receiver = Arc::new(Mutex::new(receiver));
+    for _ in 0..threads {
+      let receiver = receiver.clone();
+      thread::spawn(move || loop {
+        let job = match receiver.lock().unwrap().recv() {
+          Ok(job) => job,
+          Err(_) => return,
+        };
+        // a panicking job doesn't take its worker down with it
+        let _ = panic::catch_unwind(AssertUnwindSafe(job));
+      });
+    }
+    WorkerPool {
+      sender: Mutex::new(sender),
+    }
+  }
+
+  fn run(&self, job: Job) {
+    self.sender.lock().unwrap().send(job).unwrap();
+  }
+}
+
+pub struct Daemon {
+  listener: UnixListener,
+  path: PathBuf,
+  shared: Arc<Shared>,
+  pool: Arc<WorkerPool>,
+  shutdown: Arc<AtomicBool>,
+}
+
+impl Daemon {
+  /// Binds the socket, replacing a stale socket file that nothing is listening
+  /// on. Any other file at the path is left alone and fails with `AddrInUse`.
+  pub fn bind(path: &Path, options: &DaemonOptions) -> io::Result<Daemon> {
+    match fs::symlink_metadata(path) {
+      Ok(metadata) if !metadata.file_type().is_socket() => {
+        return Err(io::Error::new(
+          io::ErrorKind::AddrInUse,
+          format!("{} exists and is not a socket", path.display()),
+        ));
+      }
+      Ok(_) if UnixStream::connect(path).is_err() => fs::remove_file(path)?,
+      _ => {}
+    }
+    let listener = UnixListener::bind(path)?;
+    let threads = match options.threads {
+      0 => thread::available_parallelism().map_or(1, |n| n.get()),
+      n => n,
+    };
+    Ok(Daemon {
+      listener,
+      path: path.to_path_buf(),
+      shared: Arc::new(Shared {
+        cache: Mutex::new(Cache {
+          entries: HashMap::new(),
+          bytes: 0,
+          clock: 0,
+        }),
+        max_cache_bytes: options.max_cache_bytes,
+        hits: AtomicU64::new(0),
+        misses: AtomicU64::new(0),
+      }),
+      pool: Arc::new(WorkerPool::new(threads)),
+      shutdown: Arc::new(AtomicBool::new(false)),
+    })
+  }
+
+  /// Serves connections until a client sends a shutdown, then removes the
+  /// socket file.
+  pub fn run(self) -> io::Result<()> {
+    for stream in self.listener.incoming() {
+      if self.shutdown.load(Ordering::SeqCst) {
+        break;
+      }
+      let stream = match stream {
+        Ok(stream) => stream,
+        Err(_) => continue,
+      };
+      let shared = self.shared.clone();
+      let pool = self.pool.clone();
+      let shutdown = self.shutdown.clone();
+      let path = self.path.clone();
+      thread::spawn(move || {
+        // a broken connection only affects its client
+        let _ = serve_connection(stream, &shared, &pool, &shutdown, &path);
+      });
+    }
+    fs::remove_file(&self.path)
+  }
+}
+
+fn serve_connection(
+  mut stream: UnixStream,
+  shared: &Arc<Shared>,
+  pool: &WorkerPool,
+  shutdown: &AtomicBool,
+  path: &Path,
+) -> io::Result<()> {
+  while let Some(frame) = read_frame(&mut stream)? {
+    let mut reader = FrameReader { frame: &frame, pos: 0 };
+    let mut reply = Vec::new();
+    match reader.word()? {
+      OP_LEX => {
+        let flags = reader.word()?;
+        let count = reader.word()? as usize;
+        let (sender, receiver) = mpsc::channel();
+        for index in 0..count {
+          let file = PathBuf::from(reader.string()?);
+          let shared = shared.clone();
+          let sender = sender.clone();
+          pool.run(Box::new(move || {
+            let result = panic::catch_unwind(AssertUnwindSafe(|| shared.lex_file(&file, flags)))
+              .unwrap_or_else(|payload| Err(FileError::Io(panic_message(&file, payload))));
+            let _ = sender.send((index, result));
+          }));
+        }
+        drop(sender);
+        let mut results: Vec<Option<FileResult>> = vec![None; count];
+        for (index, result) in receiver {
+          results[index] = Some(result);
+        }
+        for result in results {
+          match result.unwrap_or_else(|| Err(FileError::Io("Lexing job was lost".to_string()))) {
+            Ok(bytes) => {
+              push_word(&mut reply, STATUS_OK);
+              push_bytes(&mut reply, &bytes);
+            }
+            Err(FileError::Parse(offset)) => {
+              push_word(&mut reply, STATUS_PARSE_ERROR);
+              push_word(&mut reply, offset as u32);
+            }
+            Err(FileError::Io(message)) => {
+              push_word(&mut reply, STATUS_IO_ERROR);
+              push_bytes(&mut reply, message.as_bytes());
+            }
+          }
+        }
+      }
+      OP_STATS => {
+        push_word(&mut reply, shared.cache.lock().unwrap().entries.len() as u32);
+        reply.extend_from_slice(&shared.hits.load(Ordering::Relaxed).to_le_bytes());
+        reply.extend_from_slice(&shared.misses.load(Ordering::Relaxed).to_le_bytes());
+      }
+      OP_SHUTDOWN => {
+        shutdown.store(true, Ordering::SeqCst);
+        write_frame(&mut stream, &reply)?;
+        // wake the accept loop so it sees the flag
+        let _ = UnixStream::connect(path);
+        return Ok(());
+      }
+      _ => return Err(io::Error::new(io::ErrorKind::InvalidData, "Unknown op")),
+    }
+    write_frame(&mut stream, &reply)?;
+  }
+  Ok(())
+}
+
+fn panic_message(path: &Path, payload: Box<dyn std::any::Any + Send>) -> String {
+  let message = match payload.downcast_ref::<&str>() {
+    Some(message) => message.to_string(),
+    None => payload.downcast_ref::<String>().cloned().unwrap_or_default(),
+  };
+  format!("{}: lexing panicked: {}", path.display(), message)
+}
+
+/// A connection to a daemon. Requests on one connection are served in order.
+pub struct Client {
+  stream: UnixStream,
+}
+
+impl Client {
+  pub fn connect(path: &Path) -> io::Result<Client> {
+    Ok(Client {
+      stream: UnixStream::connect(path)?,
+    })
+  }
+
+  fn request(&mut self, frame: &[u8]) -> io::Result<Vec<u8>> {
+    write_frame(&mut self.stream, frame)?;
+    read_frame(&mut self.stream)?
+      .ok_or_else(|| io::Error::new(io::ErrorKind::UnexpectedEof, "Daemon disconnected"))
+  }
+
+  /// Lexes a batch of files, returning their results in order. Only the
+  /// `line_starts`, `cjs_exports` and `fast_reject` options apply. Paths are
+  /// canonicalized, so relative paths resolve against this process's working
+  /// directory and different paths to a file share its cache entry.
+  pub fn lex(&mut self, paths: &[&Path], options: &LexOptions) -> io::Result<Vec<FileResult>> {
+    let mut frame = Vec::new();
+    push_word(&mut frame, OP_LEX);
+    push_word(&mut frame, option_flags(options));
+    push_word(&mut frame, paths.len() as u32);
+    for path in paths {
+      let path = match fs::canonicalize(path) {
+        Ok(path) => path,
+        // missing files are left for the daemon to report
+        Err(_) => std::env::current_dir()?.join(path),
+      };
+      let path = path
+        .to_str()
+        .ok_or_else(|| io::Error::new(io::ErrorKind::InvalidInput, "Path is not UTF-8"))?;
+      push_bytes(&mut frame, path.as_bytes());
+    }
+
+    let reply = self.request(&frame)?;
+    let mut reader = FrameReader { frame: &reply, pos: 0 };
+    let mut results = Vec::with_capacity(paths.len());
+    for _ in paths {
+      results.push(match reader.word()? {
+        STATUS_OK => {
+          let len = reader.word()? as usize;
+          Ok(Arc::new(reader.bytes(len)?.to_vec()))
+        }
+        STATUS_PARSE_ERROR => Err(FileError::Parse(reader.word()? as usize)),
+        _ => Err(FileError::Io(reader.string()?.to_string())),
+      });
+    }
+    Ok(results)
+  }
+
+  pub fn stats(&mut self) -> io::Result<CacheStats> {
+    let reply = self.request(&OP_STATS.to_le_bytes())?;
+    let mut reader = FrameReader { frame: &reply, pos: 0 };
+    Ok(CacheStats {
+      entries: reader.word()? as usize,
+      hits: u64::from_le_bytes(reader.bytes(8)?.try_into().unwrap()),
+      misses: u64::from_le_bytes(reader.bytes(8)?.try_into().unwrap()),
+    })
+  }
+
+  /// Asks the daemon to exit once it has replied.
+  pub fn shutdown(mut self) -> io::Result<()> {
+    self.request(&OP_SHUTDOWN.to_le_bytes()).map(|_| ())
+  }
+}
+
+#[cfg(test)]
+mod tests {
+  use super::*;
+  use crate::binary::LexResultView;
+
+  #[test]
+  fn daemon_cache() {
+    let dir = std::env::temp_dir().join(format!("es-module-lexer-daemon-{}", std::process::id()));
+    fs::create_dir_all(&dir).unwrap();
+    let a = dir.join("a.js");
+    let b = dir.join("b.js");
+    fs::write(&a, "import './\\x62.js';\nexport const a = 1;").unwrap();
+    fs::write(&b, "import {").unwrap();
+    let socket = dir.join("daemon.sock");
+
+    // a file that isn't a socket is never replaced
+    fs::write(&socket, "not a socket").unwrap();
+    let err = Daemon::bind(&socket, &DaemonOptions::default()).err().unwrap();
+    assert_eq!(err.kind(), io::ErrorKind::AddrInUse);
+    assert_eq!(fs::read_to_string(&socket).unwrap(), "not a socket");
+    fs::remove_file(&socket).unwrap();
+
+    let daemon = Daemon::bind(
+      &socket,
+      &DaemonOptions {
+        threads: 2,
+        ..Default::default()
+      },
+    )
+    .unwrap();
+    let server = thread::spawn(move || daemon.run());
+
+    let mut client = Client::connect(&socket).unwrap();
+    let missing = dir.join("missing.js");
+    let options = LexOptions::default();
+    let results = client.lex(&[&a, &b, &missing], &options).unwrap();
+    let bytes = results[0].as_ref().unwrap();
+    let view = LexResultView::from_bytes(bytes).unwrap();
+    assert_eq!(view.import(0).unwrap().specifier(), Some("./b.js"));
+    assert_eq!(view.export(0).unwrap().exported(), Some("a"));
+    assert_eq!(results[1], Err(FileError::Parse(7)));
+    assert!(matches!(results[2], Err(FileError::Io(_))));
+
+    // a second client is served from the cache
+    let mut other = Client::connect(&socket).unwrap();
+    let again = other.lex(&[&a, &b], &options).unwrap();
+    assert_eq!(again[0].as_ref().unwrap(), bytes);
+    assert_eq!(
+      client.stats().unwrap(),
+      CacheStats {
+        entries: 2,
+        hits: 2,
+        misses: 2
+      }
+    );
+
+    // changes are picked up, and options are cached separately
+    fs::write(&a, "export const a = 1;\nexport const b = 2;").unwrap();
+    let filetime = SystemTime::now() + std::time::Duration::from_secs(10);
+    fs::File::options()
+      .write(true)
+      .open(&a)
+      .unwrap()
+      .set_modified(filetime)
+      .unwrap();
+    let results = client.lex(&[&a], &options).unwrap();
+    let view = LexResultView::from_bytes(results[0].as_ref().unwrap()).unwrap();
+    assert_eq!(view.export_count(), 2);
+    let options = LexOptions {
+      line_starts: true,
+      ..Default::default()
+    };
+    let results = client.lex(&[&a], &options).unwrap();
+    let view = LexResultView::from_bytes(results[0].as_ref().unwrap()).unwrap();
+    assert_eq!(view.line_starts(), Some(vec![0, 20]));
+    assert_eq!(client.stats().unwrap().entries, 3);
+
+    // relative paths resolve against the client's working directory, to the
+    // same entry, and are rejected from other clients
+    let cwd = std::env::current_dir().unwrap();
+    let relative: PathBuf = cwd
+      .components()
+      .skip(1)
+      .map(|_| Path::new(".."))
+      .collect::<PathBuf>()
+      .join(a.strip_prefix("/").unwrap());
+    let results = client.lex(&[&relative], &options).unwrap();
+    assert_eq!(
+      LexResultView::from_bytes(results[0].as_ref().unwrap()).unwrap().export_count(),
+      2
+    );
+    assert_eq!(client.stats().unwrap().entries, 3);
+    let mut frame = Vec::new();
+    push_word(&mut frame, OP_LEX);
+    push_word(&mut frame, 0);
+    push_word(&mut frame, 1);
+    push_bytes(&mut frame, b"a.js");
+    let reply = client.request(&frame).unwrap();
+    assert_eq!(reply[..4], STATUS_IO_ERROR.to_le_bytes());
+
+    client.shutdown().unwrap();
+    server.join().unwrap().unwrap();
+    assert!(!socket.exists());
+    fs::remove_dir_all(&dir).unwrap();
+  }
+
+  #[test]
+  fn worker_survives_panic() {
+    let pool = WorkerPool::new(1);
+    let (sender, receiver) = mpsc::channel();
+    pool.run(Box::new(|| panic!("job panicked")));
+    pool.run(Box::new(move || sender.send(1).unwrap()));
+    assert_eq!(receiver.recv(), Ok(1));
+  }
+}
@@ -0,0 +1,395 @@
+//! Parallel module graph crawler.
+//!
+//! Starting from a set of entry points, every module is read and lexed, each
+//! `Standard` and `DynamicString` import is passed through a user resolver, and
+//! newly discovered modules are lexed concurrently while the frontier is still
+//! growing. Modules are deduplicated by resolved path, so cycles terminate.
+//!
+//! Scheduling uses one deque per worker: a worker pushes the modules it discovers
+//! onto its own deque and pops from the back (depth first, keeping the importer's
+//! directory hot), while idle workers steal from the front of other deques.
+
+use crate::{lex, ImportKind};
+use std::{
+  collections::{HashMap, VecDeque},
+  fmt, fs, io,
+  path::{Path, PathBuf},
+  sync::{
+    atomic::{AtomicBool, Ordering},
+    Arc, Condvar, Mutex,
+  },
+  thread,
+};
+
+pub struct CrawlOptions {
+  /// Number of worker threads, 0 to use the available parallelism.
+  pub threads: usize,
+  /// Upper bound on the total size of sources read and not yet recorded in the
+  /// graph. A single source larger than the budget is still processed, on its own.
+  pub max_in_flight_bytes: usize,
+  /// Crawling stops with `CrawlError::Cancelled` once this flag is set.
+  pub cancel: Option<Arc<AtomicBool>>,
+}
+
+impl Default for CrawlOptions {
+  fn default() -> Self {
+    CrawlOptions {
+      threads: 0,
+      max_in_flight_bytes: 64 * 1024 * 1024,
+      cancel: None,
+    }
+  }
+}
+
+#[derive(Debug)]
+pub enum CrawlError {
+  Io(io::Error),
+  /// Lexer error at the given byte offset.
+  Parse(usize),
+  Cancelled,
+}
+
+impl fmt::Display for CrawlError {
+  fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+    match self {
+      CrawlError::Io(err) => write!(f, "{}", err),
+      CrawlError::Parse(offset) => write!(f, "Parse error at {}", offset),
+      CrawlError::Cancelled => write!(f, "Crawl cancelled"),
+    }
+  }
+}
+
+impl std::error::Error for CrawlError {}
+
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct Dependency {
+  pub specifier: String,
+  pub kind: ImportKind,
+  /// Index into `ModuleGraph::modules`, when the resolver returned a path.
+  pub resolved: Option<usize>,
+}
+
+#[derive(Debug)]
+pub struct Module {
+  pub path: PathBuf,
+  /// Every import of the module, in source order, including dynamic
+  /// expressions and `import.meta` which are never resolved.
+  pub dependencies: Vec<Dependency>,
+  pub exports: Vec<String>,
+  /// Set when the module could not be read or lexed.
+  pub error: Option<CrawlError>,
+}
+
+#[derive(Debug, Default)]
+pub struct ModuleGraph {
+  pub modules: Vec<Module>,
+  /// Indices of the entry modules, in the order given.
+  pub entries: Vec<usize>,
+  index: HashMap<PathBuf, usize>,
+}
+
+impl ModuleGraph {
+  pub fn get(&self, path: &Path) -> Option<usize> {
+    self.index.get(path).copied()
+  }
+
+  /// Resolved dependency indices of a module.
+  pub fn edges(&self, module: usize) -> impl Iterator<Item = usize> + '_ {
+    self.modules[module].dependencies.iter().filter_map(|dep| dep.resolved)
+  }
+}
+
+struct Queues {
+  deques: Vec<Mutex<VecDeque<usize>>>,
+  pending: Mutex<Pending>,
+  wakeup: Condvar,
+}
+
+#[derive(Default)]
+struct Pending {
+  // modules discovered but not yet finished
+  modules: usize,
+  // bumped after every push, so an idle worker can tell that work arrived
+  // between its failed steal and its wait
+  pushes: usize,
+}
+
+struct Budget {
+  in_flight: Mutex<usize>,
+  released: Condvar,
+  max: usize,
+}
+
+impl Budget {
+  // The returned charge is held until the module is recorded in the graph.
+  fn acquire(&self, bytes: usize, cancelled: &dyn Fn() -> bool) -> Option<Charge<'_>> {
+    let mut in_flight = self.in_flight.lock().unwrap();
+    while *in_flight > 0 && *in_flight + bytes > self.max {
+      if cancelled() {
+        return None;
+      }
+      in_flight = self.released.wait(in_flight).unwrap();
+    }
+    *in_flight += bytes;
+    Some(Charge { budget: self, bytes })
+  }
+}
+
+struct Charge<'b> {
+  budget: &'b Budget,
+  bytes: usize,
+}
+
+impl Drop for Charge<'_> {
+  fn drop(&mut self) {
+    *self.budget.in_flight.lock().unwrap() -= self.bytes;
+    self.budget.released.notify_all();
+  }
+}
+
+struct Crawl<'r, R> {
+  resolver: &'r R,
+  queues: Queues,
+  budget: Budget,
+  cancel: Option<Arc<AtomicBool>>,
+  paths: Mutex<(Vec<PathBuf>, HashMap<PathBuf, usize>)>,
+  results: Mutex<Vec<Option<Module>>>,
+}
+
+impl<'r, R> Crawl<'r, R>
+where
+  R: Fn(&str, &Path) -> Option<PathBuf> + Sync,
+{
+  fn cancelled(&self) -> bool {
+    self.cancel.as_ref().map_or(false, |cancel| cancel.load(Ordering::Relaxed))
+  }
+
+  // Returns the module index, and whether it was newly discovered.
+  fn intern(&self, path: PathBuf) -> (usize, bool) {
+    let mut paths = self.paths.lock().unwrap();
+    if let Some(&id) = paths.1.get(&path) {
+      return (id, false);
+    }
+    let id = paths.0.len();
+    paths.0.push(path.clone());
+    paths.1.insert(path, id);
+    (id, true)
+  }
+
+  fn push(&self, worker: usize, id: usize) {
+    // counted before it can be stolen, so `modules` never drops to 0 early
+    self.queues.pending.lock().unwrap().modules += 1;
+    self.queues.deques[worker].lock().unwrap().push_back(id);
+    self.queues.pending.lock().unwrap().pushes += 1;
+    self.queues.wakeup.notify_one();
+  }
+
+  fn pop(&self, worker: usize) -> Option<usize> {
+    if let Some(id) = self.queues.deques[worker].lock().unwrap().pop_back() {
+      return Some(id);
+    }
+    let n = self.queues.deques.len();
+    (1..n).find_map(|i| self.queues.deques[(worker + i) % n].lock().unwrap().pop_front())
+  }
+
+  fn run(&self, worker: usize) {
+    loop {
+      if self.cancelled() {
+        self.queues.wakeup.notify_all();
+        return;
+      }
+      let pushes = self.queues.pending.lock().unwrap().pushes;
+      if let Some(id) = self.pop(worker) {
+        self.visit(worker, id);
+        let mut pending = self.queues.pending.lock().unwrap();
+        pending.modules -= 1;
+        if pending.modules == 0 {
+          self.queues.wakeup.notify_all();
+        }
+        continue;
+      }
+      let mut pending = self.queues.pending.lock().unwrap();
+      // a module still being visited either pushes more work or finishes the
+      // crawl, and a cancelled worker wakes everyone on its way out
+      while pending.modules > 0 && pending.pushes == pushes && !self.cancelled() {
+        pending = self.queues.wakeup.wait(pending).unwrap();
+      }
+      if pending.modules == 0 {
+        return;
+      }
+    }
+  }
+
+  fn visit(&self, worker: usize, id: usize) {
+    let path = self.paths.lock().unwrap().0[id].clone();
+    let mut module = Module {
+      path,
+      dependencies: Vec::new(),
+      exports: Vec::new(),
+      error: None,
+    };
+
+    let size = fs::metadata(&module.path).map_or(0, |meta| meta.len() as usize);
+    let charge = match self.budget.acquire(size, &|| self.cancelled()) {
+      Some(charge) => charge,
+      None => return,
+    };
+    match fs::read_to_string(&module.path) {
+      Ok(source) => match lex(&source) {
+        Ok(res) => {
+          for import in res.imports() {
+            let kind = import.kind();
+            let specifier = import.specifier().into_owned();
+            let resolved = match kind {
+              ImportKind::Standard | ImportKind::DynamicString => (self.resolver)(&specifier, &module.path),
+              _ => None,
+            };
+            let resolved = resolved.map(|resolved| {
+              let (dep, new) = self.intern(resolved);
+              if new {
+                self.push(worker, dep);
+              }
+              dep
+            });
+            module.dependencies.push(Dependency {
+              specifier,
+              kind,
+              resolved,
+            });
+          }
+          module.exports = res.exports().map(|export| export.exported().to_owned()).collect();
+        }
+        Err(offset) => module.error = Some(CrawlError::Parse(offset)),
+      },
+      Err(err) => module.error = Some(CrawlError::Io(err)),
+    }
+
+    let mut results = self.results.lock().unwrap();
+    if results.len() <= id {
+      results.resize_with(id + 1, || None);
+    }
+    results[id] = Some(module);
+    drop(results);
+    drop(charge);
+  }
+}
+
+/// Crawls the module graph reachable from `entries`.
+///
+/// `resolver` is called with each `Standard` and `DynamicString` specifier and
+/// the path of the importing module, returning the resolved path or `None` to
+/// leave the dependency unresolved. It is called concurrently from all workers.
+pub fn crawl<R>(entries: &[PathBuf], resolver: R, options: &CrawlOptions) -> Result<ModuleGraph, CrawlError>
+where
+  R: Fn(&str, &Path) -> Option<PathBuf> + Sync,
+{
+  let threads = if options.threads == 0 {
+    thread::available_parallelism().map_or(1, |n| n.get())
+  } else {
+    options.threads
+  };
+
+  let crawl = Crawl {
+    resolver: &resolver,
+    queues: Queues {
+      deques: (0..threads).map(|_| Mutex::new(VecDeque::new())).collect(),
+      pending: Mutex::new(Pending::default()),
+      wakeup: Condvar::new(),
+    },
+    budget: Budget {
+      in_flight: Mutex::new(0),
+      released: Condvar::new(),
+      max: options.max_in_flight_bytes,
+    },
+    cancel: options.cancel.clone(),
+    paths: Mutex::new((Vec::new(), HashMap::new())),
+    results: Mutex::new(Vec::new()),
+  };
+
+  let mut entry_ids = Vec::with_capacity(entries.len());
+  for (i, entry) in entries.iter().enumerate() {
+    let (id, new) = crawl.intern(entry.clone());
+    if new {
+      crawl.push(i % threads, id);
+    }
+    entry_ids.push(id);
+  }
+
+  thread::scope(|scope| {
+    for worker in 1..threads {
+      let crawl = &crawl;
+      scope.spawn(move || crawl.run(worker));
+    }
+    crawl.run(0);
+  });
+
+  if crawl.cancelled() {
+    return Err(CrawlError::Cancelled);
+  }
+
+  let (_, index) = crawl.paths.into_inner().unwrap();
+  let modules = crawl
+    .results
+    .into_inner()
+    .unwrap()
+    .into_iter()
+    .map(|module| module.unwrap())
+    .collect();
+  Ok(ModuleGraph {
+    modules,
+    entries: entry_ids,
+    index,
+  })
+}
+
+#[cfg(test)]
+mod tests {
+  use super::*;
+
+  #[test]
+  fn crawl_cycle() {
+    let dir = std::env::temp_dir().join(format!("es-module-lexer-graph-{}", std::process::id()));
+    fs::create_dir_all(&dir).unwrap();
+    fs::write(
+      dir.join("a.js"),
+      "import { b } from './b.js';\nimport('./c.js');\nexport const a = 1;",
+    )
+    .unwrap();
+    fs::write(
+      dir.join("b.js"),
+      "import './a.js';\nimport 'external';\nexport function b () {}",
+    )
+    .unwrap();
+    fs::write(dir.join("c.js"), "import(foo);\nexport default 1;").unwrap();
+
+    let resolver = |specifier: &str, importer: &Path| {
+      if specifier.starts_with("./") {
+        Some(importer.parent().unwrap().join(&specifier[2..]))
+      } else {
+        None
+      }
+    };
+    let options = CrawlOptions {
+      threads: 4,
+      // smaller than any of the sources, so they are lexed one at a time
+      max_in_flight_bytes: 1,
+      ..Default::default()
+    };
+    let graph = crawl(&[dir.join("a.js")], resolver, &options).unwrap();
+    fs::remove_dir_all(&dir).unwrap();
+
+    assert_eq!(graph.modules.len(), 3);
+    let a = graph.get(&dir.join("a.js")).unwrap();
+    let b = graph.get(&dir.join("b.js")).unwrap();
+    let c = graph.get(&dir.join("c.js")).unwrap();
+    assert_eq!(graph.entries, vec![a]);
+    assert_eq!(graph.edges(a).collect::<Vec<_>>(), vec![b, c]);
+    assert_eq!(graph.edges(b).collect::<Vec<_>>(), vec![a]);
+    assert_eq!(graph.modules[b].dependencies[1].specifier, "external");
+    assert_eq!(graph.modules[b].dependencies[1].resolved, None);
+    assert_eq!(graph.modules[c].dependencies[0].kind, ImportKind::DynamicExpression);
+    assert_eq!(graph.modules[a].exports, vec!["a"]);
+    assert_eq!(graph.modules[c].exports, vec!["default"]);
+    assert!(graph.modules.iter().all(|module| module.error.is_none()));
+  }
+}
@@ -37,31 +37,64 @@ export function parse (_source, _name = '@') {
 
   copy(source, new Uint16Array(asmBuffer, addr, len));
 
-  if (!asm.p()) {
-    acornPos = asm.e();
+  const result = new Int32Array(asmBuffer, asm.p(0));
+  const importCount = result[0], exportCount = result[1], facade = result[2] & 1, err = result[3];
+  if (err !== -1) {
+    acornPos = err;
     syntaxError();
   }
 
   const imports = [], exports = [];
-  while (asm.ri()) {
-    const s = asm.is(), e = asm.ie(), a = asm.ai(), d = asm.id(), ss = asm.ss(), se = asm.se();
-    let n;
-    if (asm.ip())
+  let i = 14, attribute = 14 + importCount * 15 + exportCount * 9, binding = attribute + result[5] * 4;
+  for (const importEnd = i + importCount * 15; i < importEnd; i += 15) {
+    const s = result[i], e = result[i + 1], ss = result[i + 2], se = result[i + 3], a = result[i + 4], d = result[i + 5];
+    let n, at = null, b = null;
+    if (result[i + 6])
       n = readString(d === -1 ? s : s + 1, source.charCodeAt(d === -1 ? s - 1 : s));
-    imports.push({ n, s, e, ss, se, d, a });
+    for (const attributesEnd = attribute + result[i + 7] * 4; attribute < attributesEnd; attribute += 4) {
+      const ks = result[attribute], ke = result[attribute + 1], vs = result[attribute + 2];
+      const kch = source.charCodeAt(ks - 1);
+      (at = at || []).push([
+        (kch === 34 || kch === 39) ? readString(ks, kch) : source.slice(ks, ke),
+        readAttributeValue(vs, source.charCodeAt(vs - 1))
+      ]);
+    }
+    for (const bindingsEnd = binding + result[i + 8] * 5; binding < bindingsEnd; binding += 5) {
+      const s = result[binding], e = result[binding + 1], ls = result[binding + 2], le = result[binding + 3], flags = result[binding + 4];
+      const ch = s >= 0 ? source.charCodeAt(s) : -1;
+      (b = b || []).push({
+        s, e, ls, le, d: (flags & 1) !== 0, ns: (flags & 2) !== 0, ph: (flags & 4) !== 0,
+        n: s < 0 ? undefined : (ch === 34 || ch === 39) ? readString(s + 1, ch) : source.slice(s, e),
+        ln: source.slice(ls, le)
+      });
+    }
+    imports.push({ n, s, e, ss, se, d, a, at, b, star: result[i + 9] !== 0 });
   }
-  while (asm.re()) {
-    const s = asm.es(), e = asm.ee(), ls = asm.els(), le = asm.ele();
+  for (const exportEnd = i + exportCount * 9; i < exportEnd; i += 9) {
+    const s = result[i], e = result[i + 1], ls = result[i + 2], le = result[i + 3], ri = result[i + 5], rs = result[i + 6], re = result[i + 7];
     const ch = source.charCodeAt(s);
     const lch = ls >= 0 ? source.charCodeAt(ls) : -1;
+    const rch = rs >= 0 ? source.charCodeAt(rs) : -1;
     exports.push({
-      s, e, ls, le,
+      s, e, ls, le, cjs: result[i + 4] !== 0, ri, rs, re,
       n: (ch === 34 || ch === 39) ? readString(s + 1, ch) : source.slice(s, e),
       ln: ls < 0 ? undefined : (lch === 34 || lch === 39) ? readString(ls + 1, lch) : source.slice(ls, le),
+      rn: rs < 0 ? undefined : (rch === 34 || rch === 39) ? readString(rs + 1, rch) : source.slice(rs, re),
     });
   }
 
-  return [imports, exports, !!asm.f()];
+  return [imports, exports, !!facade];
+}
+
+// invalid escapes in attribute values are undefined rather than parse errors,
+// as in the wasm build
+function readAttributeValue (start, quote) {
+  try {
+    return readString(start, quote);
+  }
+  catch (e) {
+    return undefined;
+  }
 }
 
 /*
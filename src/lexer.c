@@ -10,6 +10,8 @@ static const char16_t LASS[] = { 'l', 'a', 's', 's' };
 static const char16_t FROM[] = { 'f', 'r', 'o', 'm' };
 static const char16_t ETA[] = { 'e', 't', 'a' };
 static const char16_t SSERT[] = { 's', 's', 'e', 'r', 't' };
+static const char16_t ITH[] = { 'i', 't', 'h' };
+static const char16_t DEFAULT[] = { 'd', 'e', 'f', 'a', 'u', 'l', 't' };
 static const char16_t VO[] = { 'v', 'o' };
 static const char16_t YIE[] = { 'y', 'i', 'e' };
 static const char16_t DELE[] = { 'd', 'e', 'l', 'e' };
@@ -18,227 +20,766 @@ static const char16_t TY[] = { 't', 'y' };
 static const char16_t RETUR[] = { 'r', 'e', 't', 'u', 'r' };
 static const char16_t DEBUGGE[] = { 'd', 'e', 'b', 'u', 'g', 'g', 'e' };
 static const char16_t AWAI[] = { 'a', 'w', 'a', 'i' };
+static const char16_t WAIT[] = { 'w', 'a', 'i', 't' };
 static const char16_t THR[] = { 't', 'h', 'r' };
 static const char16_t WHILE[] = { 'w', 'h', 'i', 'l', 'e' };
 static const char16_t FOR[] = { 'f', 'o', 'r' };
 static const char16_t IF[] = { 'i', 'f' };
 static const char16_t CATC[] = { 'c', 'a', 't', 'c' };
+static const char16_t SWITC[] = { 's', 'w', 'i', 't', 'c' };
+static const char16_t WIT[] = { 'w', 'i', 't' };
 static const char16_t FINALL[] = { 'f', 'i', 'n', 'a', 'l', 'l' };
 static const char16_t ELS[] = { 'e', 'l', 's' };
 static const char16_t BREA[] = { 'b', 'r', 'e', 'a' };
 static const char16_t CONTIN[] = { 'c', 'o', 'n', 't', 'i', 'n' };
 static const char16_t SYNC[] = {'s', 'y', 'n', 'c'};
 static const char16_t UNCTION[] = {'u', 'n', 'c', 't', 'i', 'o', 'n'};
+static const char16_t XPORTS[] = { 'x', 'p', 'o', 'r', 't', 's' };
+static const char16_t ODULE[] = { 'o', 'd', 'u', 'l', 'e' };
+static const char16_t BJECT[] = { 'b', 'j', 'e', 'c', 't' };
+static const char16_t DEFINEPROPERTY[] = { 'd', 'e', 'f', 'i', 'n', 'e', 'P', 'r', 'o', 'p', 'e', 'r', 't', 'y' };
+static const char16_t USE_STRICT[] = { 'u', 's', 'e', ' ', 's', 't', 'r', 'i', 'c', 't' };
+static const char16_t YPE[] = { 'y', 'p', 'e' };
+static const char16_t NTERFACE[] = { 'n', 't', 'e', 'r', 'f', 'a', 'c', 'e' };
+static const char16_t NUM[] = { 'n', 'u', 'm' };
+static const char16_t ONST[] = { 'o', 'n', 's', 't' };
+static const char16_t AMESPACE[] = { 'a', 'm', 'e', 's', 'p', 'a', 'c', 'e' };
+static const char16_t ECLARE[] = { 'e', 'c', 'l', 'a', 'r', 'e' };
+static const char16_t BSTRACT[] = { 'b', 's', 't', 'r', 'a', 'c', 't' };
+static const char16_t XTENDS[] = { 'x', 't', 'e', 'n', 'd', 's' };
 
 // Note: parsing is based on the _assumption_ that the source is already valid
-bool parse (char16_t *source, uint32_t sourceLen, Allocator alloc, void *user_data, ParseResult *result) {
+bool parse (char16_t *source, uint32_t sourceLen, uint32_t options, Allocator alloc, void *user_data, ParseResult *result) {
   // stack allocations
   // these are done here to avoid data section \0\0\0 repetition bloat
   // (while gzip fixes this, still better to have ~10KiB ungzipped over ~20KiB)
   OpenToken openTokenStack_[1024];
   Import* dynamicImportStack_[512];
 
-  State state = {
+  State state;
+  if (!initState(&state, source, sourceLen, options, alloc, user_data, result, &openTokenStack_[0], &dynamicImportStack_[0]))
+    return true;
+  do lexSlice(&state, state.end);
+  while (recoverError(&state));
+  return finishParse(&state);
+}
+
+ParseContext* parse_init (char16_t *source, uint32_t sourceLen, uint32_t options, Allocator alloc, void *user_data, ParseResult *result) {
+  ParseContext* ctx = alloc(sizeof(ParseContext), user_data);
+  // fast rejected sources are done without lexing
+  ctx->done = !initState(&ctx->state, source, sourceLen, options, alloc, user_data, result, &ctx->openTokenStack[0], &ctx->dynamicImportStack[0]);
+  ctx->ok = true;
+  return ctx;
+}
+
+enum ParseStatus parse_step (ParseContext* ctx, uint32_t maxLen) {
+  State* state = &ctx->state;
+  if (!ctx->done) {
+    // at least one code unit per step, so every step makes progress
+    char16_t* sliceEnd = (uint32_t)(state->end - state->pos) > maxLen ? state->pos + (maxLen ? maxLen : 1) : state->end;
+    if (!lexSlice(state, sliceEnd) || recoverError(state))
+      return ParsePending;
+    ctx->done = true;
+    ctx->ok = finishParse(state);
+  }
+  return ctx->ok ? ParseOk : ParseFailed;
+}
+
+uint32_t parse_regions (char16_t* source, uint32_t sourceLen, const Region* regions, uint32_t regionCount, uint32_t options, Allocator alloc, void* user_data, ParseResult* results) {
+  // collected once over the whole source rather than per region
+  uint32_t* lineStarts = NULL;
+  uint32_t lineCount = 0;
+  if (options & LineStarts)
+    lineStarts = collectLineStarts(source, source + sourceLen, alloc, user_data, &lineCount);
+  for (uint32_t i = 0; i < regionCount; i++) {
+    ParseResult* result = &results[i];
+    *result = (ParseResult){ 0 };
+    bool ok = parse(source + regions[i].start, regions[i].end - regions[i].start, options & ~LineStarts, alloc, user_data, result);
+    if (!ok) {
+      result->parse_error += regions[i].start;
+      if (!lineStarts)
+        lineStarts = collectLineStarts(source, source + sourceLen, alloc, user_data, &lineCount);
+    }
+    result->line_starts = lineStarts;
+    result->line_count = lineCount;
+    if (!ok)
+      return i;
+  }
+  return regionCount;
+}
+
+// Returns false when there is nothing to lex, after the FastReject search.
+static bool initState (State *state, char16_t *source, uint32_t sourceLen, uint32_t options, Allocator alloc, void *user_data, ParseResult *result, OpenToken* openTokenStack, Import** dynamicImportStack) {
+  *state = (State){
     .facade = true,
     .dynamicImportStackDepth = 0,
     .openTokenDepth = 0,
     .lastTokenPos = (char16_t*)EMPTY_CHAR,
     .lastSlashWasDivision = false,
     .has_error = false,
-    .openTokenStack = &openTokenStack_[0],
-    .dynamicImportStack = &dynamicImportStack_[0],
+    .openTokenStack = openTokenStack,
+    .dynamicImportStack = dynamicImportStack,
     .nextBraceIsClass = false,
+    .mainParse = false,
+    .error_write_head = NULL,
+    .resumePos = source,
     .source = source,
+    .options = options,
     .alloc = alloc,
     .user_data = user_data,
     .result = result,
   };
 
-  state.pos = (char16_t*)(source - 1);
+  state->end = (char16_t*)(source - 1) + sourceLen;
+
+  // lexing starts after any hashbang and directives, so they don't end the
+  // facade
+  result->meta = (ModuleMeta){ 0 };
+  result->first_error = NULL;
+  state->pos = readDirectives(source, source + sourceLen, &result->meta) - 1;
+
+  if ((options & FastReject) && !hasModuleKeyword(source, source + sourceLen)) {
+    result->fast_rejected = true;
+    return false;
+  }
+
+  // only for sources that will be lexed
+  if (options & LineStarts)
+    result->line_starts = collectLineStarts(source, source + sourceLen, alloc, user_data, &result->line_count);
+  return true;
+}
+
+// Reads a hashbang line and the directive prologue, returning where the
+// statements after them start. A string continued as an expression on the
+// next line isn't a directive.
+static char16_t* readDirectives (const char16_t* source, const char16_t* end, ModuleMeta* meta) {
+  const char16_t* pos = source;
+  if (end - pos >= 2 && pos[0] == '#' && pos[1] == '!') {
+    meta->hashbang = true;
+    while (pos < end && !isBr(*pos))
+      pos++;
+  }
+  const char16_t* bodyStart = pos;
+  while (true) {
+    bool br = false;
+    pos = skipCommentWhitespace(pos, end, &br);
+    if (pos == end || !isQuote(*pos))
+      break;
+    char16_t quote = *pos;
+    const char16_t* str = ++pos;
+    while (pos < end && *pos != quote && !isBr(*pos))
+      pos += *pos == '\\' ? 2 : 1;
+    if (pos >= end || *pos != quote)
+      break;
+    const char16_t* strEnd = pos++;
+    br = false;
+    const char16_t* next = skipCommentWhitespace(pos, end, &br);
+    if (next < end && *next == ';')
+      pos = next + 1;
+    else if (next < end && (!br || (isPunctuator(*next) && *next != '!' && *next != '~' && *next != '{')))
+      break;
+    if (strEnd - str == 10 && memcmp(str, &USE_STRICT[0], 10 * sizeof(char16_t)) == 0)
+      meta->use_strict = true;
+    bodyStart = pos;
+  }
+  return (char16_t*)bodyStart;
+}
+
+// Skips whitespace and comments outside of the lexer state, noting any line
+// break passed.
+static const char16_t* skipCommentWhitespace (const char16_t* pos, const char16_t* end, bool* br) {
+  while (pos < end) {
+    if (isBr(*pos)) {
+      *br = true;
+      pos++;
+    }
+    else if (isBrOrWs(*pos)) {
+      pos++;
+    }
+    else if (*pos == '/' && pos + 1 < end && pos[1] == '/') {
+      while (pos < end && !isBr(*pos))
+        pos++;
+    }
+    else if (*pos == '/' && pos + 1 < end && pos[1] == '*') {
+      for (pos += 2; pos < end && !(*pos == '*' && pos + 1 < end && pos[1] == '/'); pos++) {
+        if (isBr(*pos))
+          *br = true;
+      }
+      if (pos == end)
+        return end;
+      pos += 2;
+    }
+    else {
+      break;
+    }
+  }
+  return pos;
+}
+
+// The action of each code unit in the facade and main modes of lexSlice, with
+// and without the CjsExports and Jsx options, as constant expressions the
+// action tables are built from at compile time.
+#define FACADE_ACTION(c, cjs, jsx) ( \
+    (c) == ' ' || ((c) >= 9 && (c) <= 13) ? ActSkip : \
+    (c) == 'e' ? (cjs) ? ActFacadeCjsExports : ActFacadeExport : \
+    (c) == 'i' ? ActFacadeImport : \
+    (c) == 'r' ? ActFacadeRequire : \
+    (c) == ';' ? ActToken : \
+    (c) == '/' ? ActFacadeSlash : \
+    ActLeaveFacade)
+#define MAIN_ACTION(c, cjs, jsx) ( \
+    (c) == ' ' || ((c) >= 9 && (c) <= 13) ? ActInertSpace : \
+    (c) == 'e' ? (cjs) ? ActCjsExports : ActExport : \
+    (c) == 'm' && (cjs) ? ActModule : \
+    (c) == 'O' && (cjs) ? ActObject : \
+    (c) == 'i' ? ActImport : \
+    (c) == 'r' ? ActRequire : \
+    (c) == 'a' ? ActAwait : \
+    (c) == 'c' ? ActClass : \
+    (c) == '(' ? ActParenOpen : \
+    (c) == ')' ? ActParenClose : \
+    (c) == '{' ? ActBraceOpen : \
+    (c) == '}' ? ActBraceClose : \
+    (c) == '<' && (jsx) ? ActJsx : \
+    (c) == '\'' || (c) == '"' ? ActString : \
+    (c) == '/' ? ActSlash : \
+    (c) == '`' ? ActTemplate : \
+    ActInertToken)
+#define ACTIONS4(A, c, cjs, jsx) A(c, cjs, jsx), A(c + 1, cjs, jsx), A(c + 2, cjs, jsx), A(c + 3, cjs, jsx)
+#define ACTIONS16(A, c, cjs, jsx) ACTIONS4(A, c, cjs, jsx), ACTIONS4(A, c + 4, cjs, jsx), ACTIONS4(A, c + 8, cjs, jsx), ACTIONS4(A, c + 12, cjs, jsx)
+#define ACTIONS64(A, c, cjs, jsx) ACTIONS16(A, c, cjs, jsx), ACTIONS16(A, c + 16, cjs, jsx), ACTIONS16(A, c + 32, cjs, jsx), ACTIONS16(A, c + 48, cjs, jsx)
+#define ACTIONS256(A, cjs, jsx) { ACTIONS64(A, 0, cjs, jsx), ACTIONS64(A, 64, cjs, jsx), ACTIONS64(A, 128, cjs, jsx), ACTIONS64(A, 192, cjs, jsx) }
+
+// One table per mode, indexed by actionTable. Code units past 255 share the
+// action of 255, as all non-ASCII code units act alike.
+static const uint8_t actionTables[8][256] = {
+  ACTIONS256(FACADE_ACTION, 0, 0),
+  ACTIONS256(FACADE_ACTION, 0, 1),
+  ACTIONS256(FACADE_ACTION, 1, 0),
+  ACTIONS256(FACADE_ACTION, 1, 1),
+  ACTIONS256(MAIN_ACTION, 0, 0),
+  ACTIONS256(MAIN_ACTION, 0, 1),
+  ACTIONS256(MAIN_ACTION, 1, 0),
+  ACTIONS256(MAIN_ACTION, 1, 1),
+};
+
+#ifdef LEXER_UTF16
+#define lexAction(actions, ch) (actions)[(ch) > 255 ? 255 : (ch)]
+#else
+#define lexAction(actions, ch) (actions)[ch]
+#endif
+
+static const uint8_t* actionTable (State *state) {
+  return actionTables[(state->mainParse ? 4 : 0) | (state->options & CjsExports ? 2 : 0) | (state->options & Jsx ? 1 : 0)];
+}
+
+// lexSlice dispatches with computed goto where the compiler has it, for a
+// separately predicted jump per action, and with a switch otherwise, or when
+// built with -DLEXER_SWITCH. Actions sharing code fall through to the next one
+// in both.
+#if defined(__GNUC__) && !defined(LEXER_SWITCH)
+#define LEXER_COMPUTED_GOTO
+#define DISPATCH(action) goto *dispatch[action];
+#define ACTION(name) name:
+#else
+#define DISPATCH(action) switch (action)
+#define ACTION(name) case name:
+#endif
+
+// Skips from an inert code unit of the main loop to the next one it acts on,
+// when there is one to skip to.
+#ifdef LEXER_SIMD
+#define SKIP_INERT { \
+    char16_t* next = skipInert(state, state->pos); \
+    if (next != state->pos) { \
+      state->pos = next - 1; \
+      continue; \
+    } \
+  }
+#else
+#define SKIP_INERT
+#endif
+
+// Lexes tokens until the end of the source, or until the first token starting
+// past sliceEnd, returning whether the end was reached. The source starts out
+// lexed by a pure "module-only" facade, switching to the main tables at the
+// first non-module token.
+static bool lexSlice (State *state, char16_t* sliceEnd) {
+#ifdef LEXER_COMPUTED_GOTO
+  static const void* const dispatch[] = {
+    [ActSkip] = &&ActSkip,
+    [ActToken] = &&ActToken,
+    [ActFacadeCjsExports] = &&ActFacadeCjsExports,
+    [ActFacadeExport] = &&ActFacadeExport,
+    [ActFacadeImport] = &&ActFacadeImport,
+    [ActFacadeRequire] = &&ActFacadeRequire,
+    [ActFacadeSlash] = &&ActFacadeSlash,
+    [ActLeaveFacade] = &&ActLeaveFacade,
+    [ActInertSpace] = &&ActInertSpace,
+    [ActInertToken] = &&ActInertToken,
+    [ActCjsExports] = &&ActCjsExports,
+    [ActExport] = &&ActExport,
+    [ActModule] = &&ActModule,
+    [ActObject] = &&ActObject,
+    [ActImport] = &&ActImport,
+    [ActRequire] = &&ActRequire,
+    [ActAwait] = &&ActAwait,
+    [ActClass] = &&ActClass,
+    [ActParenOpen] = &&ActParenOpen,
+    [ActParenClose] = &&ActParenClose,
+    [ActBraceOpen] = &&ActBraceOpen,
+    [ActBraceClose] = &&ActBraceClose,
+    [ActJsx] = &&ActJsx,
+    [ActString] = &&ActString,
+    [ActSlash] = &&ActSlash,
+    [ActTemplate] = &&ActTemplate,
+  };
+#endif
+  const uint8_t* actions = actionTable(state);
   char16_t ch = '\0';
-  state.end = state.pos + sourceLen;
 
-  // start with a pure "module-only" parser
-  while (state.pos++ < state.end) {
-    ch = *state.pos;
+  while (state->pos++ < state->end) {
+    if (state->pos > sliceEnd)
+      return state->pos--, false;
+    ch = *state->pos;
 
-    if (ch == 32 || ch < 14 && ch > 8)
-      continue;
+    DISPATCH(lexAction(actions, ch)) {
+      ACTION(ActSkip)
+        continue;
+      ACTION(ActToken)
+        goto nextToken;
 
-    switch (ch) {
-      case 'e':
-        if (state.openTokenDepth == 0 && keywordStart(&state) && memcmp(state.pos + 1, &XPORT[0], 5 * sizeof(char16_t)) == 0) {
-          tryParseExportStatement(&state);
+      ACTION(ActFacadeCjsExports)
+        if (keywordStart(state) && memcmp(state->pos + 1, &XPORTS[0], 6 * sizeof(char16_t)) == 0) {
+          endPrologue(state, state->pos);
+          tryParseCjsExports(state);
+        }
+        // fallthrough
+      ACTION(ActFacadeExport)
+        if (state->openTokenDepth == 0 && keywordStart(state) && memcmp(state->pos + 1, &XPORT[0], 5 * sizeof(char16_t)) == 0) {
+          char16_t* startPos = state->pos;
+          tryParseExportStatement(state);
           // export might have been a non-pure declaration
-          if (!state.facade) {
-            state.lastTokenPos = state.pos;
-            goto mainparse;
+          if (!state->facade) {
+            endPrologue(state, startPos);
+            state->lastTokenPos = state->pos;
+            state->mainParse = true;
+            actions = actionTable(state);
+            continue;
           }
         }
-        break;
-      case 'i':
-        if (keywordStart(&state) && memcmp(state.pos + 1, &MPORT[0], 5 * sizeof(char16_t)) == 0)
-          tryParseImportStatement(&state);
-        break;
-      case 'r':
-        tryParseRequire(&state);
-        break;
-      case ';':
-        break;
-      case '/': {
-        char16_t next_ch = *(state.pos + 1);
+        goto nextToken;
+      ACTION(ActFacadeImport)
+        if (keywordStart(state) && memcmp(state->pos + 1, &MPORT[0], 5 * sizeof(char16_t)) == 0) {
+          char16_t* startPos = state->pos;
+          uint32_t importCount = state->import_count;
+          tryParseImportStatement(state);
+          // dynamic import and import.meta are expressions
+          if (state->import_count != importCount && state->import_write_head->dynamic != STANDARD_IMPORT)
+            endPrologue(state, startPos);
+        }
+        goto nextToken;
+      ACTION(ActFacadeRequire) {
+        char16_t* startPos = state->pos;
+        uint32_t importCount = state->import_count;
+        tryParseRequire(state);
+        if (state->import_count != importCount)
+          endPrologue(state, startPos);
+        goto nextToken;
+      }
+      ACTION(ActFacadeSlash) {
+        char16_t next_ch = *(state->pos + 1);
         if (next_ch == '/') {
-          lineComment(&state);
+          lineComment(state);
           // dont update lastToken
           continue;
         }
         else if (next_ch == '*') {
-          blockComment(&state, true);
+          blockComment(state, true);
           // dont update lastToken
           continue;
         }
-        // fallthrough
       }
-      default:
+        // fallthrough
+      ACTION(ActLeaveFacade) {
         // as soon as we hit a non-module token, we go to main parser
-        state.facade = false;
-        state.pos--;
-        goto mainparse; // oh yeahhh
-    }
-    state.lastTokenPos = state.pos;
-  }
-
-  if (state.has_error)
-    return false;
-
-  mainparse: while (state.pos++ < state.end) {
-    ch = *state.pos;
-
-    if (ch == 32 || ch < 14 && ch > 8)
-      continue;
+        state->facade = false;
+        // from the start of an identifier passed over by the keyword cases
+        char16_t* startPos = state->pos;
+        while (startPos > state->source && isIdentifierChar(*(startPos - 1)))
+          startPos--;
+        endPrologue(state, startPos);
+        // relex the token with the main tables
+        state->pos--;
+        state->mainParse = true;
+        actions = actionTable(state);
+        continue;
+      }
 
-    switch (ch) {
-      case 'e':
-        if (state.openTokenDepth == 0 && keywordStart(&state) && memcmp(state.pos + 1, &XPORT[0], 5 * sizeof(char16_t)) == 0)
-          tryParseExportStatement(&state);
-        break;
-      case 'i':
-        if (keywordStart(&state) && memcmp(state.pos + 1, &MPORT[0], 5 * sizeof(char16_t)) == 0)
-          tryParseImportStatement(&state);
-        break;
-      case 'r':
-        tryParseRequire(&state);
-        break;
-      case 'c':
-        if (keywordStart(&state) && memcmp(state.pos + 1, &LASS[0], 4 * sizeof(char16_t)) == 0 && isBrOrWs(*(state.pos + 5)))
-          state.nextBraceIsClass = true;
-        break;
-      case '(':
-        state.openTokenStack[state.openTokenDepth].token = AnyParen;
-        state.openTokenStack[state.openTokenDepth++].pos = state.lastTokenPos;
-        break;
-      case ')':
-        if (state.openTokenDepth == 0)
-          return syntaxError(&state), false;
-        state.openTokenDepth--;
-        if (state.dynamicImportStackDepth > 0 && state.dynamicImportStack[state.dynamicImportStackDepth - 1]->dynamic == state.openTokenStack[state.openTokenDepth].pos) {
-          Import* cur_dynamic_import = state.dynamicImportStack[state.dynamicImportStackDepth - 1];
+      ACTION(ActInertSpace)
+        SKIP_INERT
+        continue;
+      ACTION(ActInertToken)
+        SKIP_INERT
+        goto nextToken;
+      ACTION(ActCjsExports)
+        if (keywordStart(state) && memcmp(state->pos + 1, &XPORTS[0], 6 * sizeof(char16_t)) == 0)
+          tryParseCjsExports(state);
+        // fallthrough
+      ACTION(ActExport)
+        if (state->openTokenDepth == 0 && keywordStart(state) && memcmp(state->pos + 1, &XPORT[0], 5 * sizeof(char16_t)) == 0)
+          tryParseExportStatement(state);
+        goto nextToken;
+      ACTION(ActModule)
+        if (keywordStart(state) && memcmp(state->pos + 1, &ODULE[0], 5 * sizeof(char16_t)) == 0)
+          tryParseCjsExports(state);
+        goto nextToken;
+      ACTION(ActObject)
+        if (keywordStart(state) && memcmp(state->pos + 1, &BJECT[0], 5 * sizeof(char16_t)) == 0)
+          tryParseDefineProperty(state);
+        goto nextToken;
+      ACTION(ActImport)
+        if (keywordStart(state) && memcmp(state->pos + 1, &MPORT[0], 5 * sizeof(char16_t)) == 0)
+          tryParseImportStatement(state);
+        goto nextToken;
+      ACTION(ActRequire)
+        tryParseRequire(state);
+        goto nextToken;
+      ACTION(ActAwait)
+        if (!state->result->meta.top_level_await && keywordStart(state) && memcmp(state->pos + 1, &WAIT[0], 4 * sizeof(char16_t)) == 0)
+          tryParseAwait(state);
+        goto nextToken;
+      ACTION(ActClass)
+        if (keywordStart(state) && memcmp(state->pos + 1, &LASS[0], 4 * sizeof(char16_t)) == 0 && isBrOrWs(*(state->pos + 5)))
+          state->nextBraceIsClass = true;
+        goto nextToken;
+      ACTION(ActParenOpen)
+        state->openTokenStack[state->openTokenDepth].token = AnyParen;
+        state->openTokenStack[state->openTokenDepth++].pos = state->lastTokenPos;
+        goto nextToken;
+      ACTION(ActParenClose)
+        if (state->openTokenDepth == 0)
+          return syntaxError(state), true;
+        state->openTokenDepth--;
+        if (state->dynamicImportStackDepth > 0 && state->dynamicImportStack[state->dynamicImportStackDepth - 1]->dynamic == state->openTokenStack[state->openTokenDepth].pos) {
+          Import* cur_dynamic_import = state->dynamicImportStack[state->dynamicImportStackDepth - 1];
           if (cur_dynamic_import->end == 0)
-            cur_dynamic_import->end = state.pos;
-          cur_dynamic_import->statement_end = state.pos + 1;
-          state.dynamicImportStackDepth--;
+            cur_dynamic_import->end = state->pos;
+          cur_dynamic_import->statement_end = state->pos + 1;
+          state->dynamicImportStackDepth--;
         }
-        break;
-      case '{':
+        goto nextToken;
+      ACTION(ActBraceOpen)
         // dynamic import followed by { is not a dynamic import (so remove)
         // this is a sneaky way to get around { import () {} } v { import () }
         // block / object ambiguity without a parser (assuming source is valid)
-        if (*state.lastTokenPos == ')' && state.import_write_head && state.import_write_head->end == state.lastTokenPos) {
-          state.import_write_head = state.import_write_head_last;
-          if (state.import_write_head)
-            state.import_write_head->next = NULL;
+        if (*state->lastTokenPos == ')' && state->import_write_head && state->import_write_head->end == state->lastTokenPos) {
+          state->import_write_head = state->import_write_head_last;
+          state->import_count--;
+          if (state->import_write_head)
+            state->import_write_head->next = NULL;
           else
-            state.result->first_import = NULL;
+            state->result->first_import = NULL;
         }
-        state.openTokenStack[state.openTokenDepth].token = state.nextBraceIsClass ? ClassBrace : AnyBrace;
-        state.openTokenStack[state.openTokenDepth++].pos = state.lastTokenPos;
-        state.nextBraceIsClass = false;
-        break;
-      case '}':
-        if (state.openTokenDepth == 0)
-          return syntaxError(&state), false;
-        if (state.openTokenStack[--state.openTokenDepth].token == TemplateBrace) {
-          templateString(&state);
-        }
-        break;
-      case '\'':
-        stringLiteral(&state, ch);
-        break;
-      case '"':
-        stringLiteral(&state, ch);
-        break;
-      case '/': {
-        char16_t next_ch = *(state.pos + 1);
+        state->openTokenStack[state->openTokenDepth].token = state->nextBraceIsClass ? ClassBrace : AnyBrace;
+        state->openTokenStack[state->openTokenDepth++].pos = state->lastTokenPos;
+        state->nextBraceIsClass = false;
+        goto nextToken;
+      ACTION(ActBraceClose) {
+        if (state->openTokenDepth == 0)
+          return syntaxError(state), true;
+        enum OpenTokenState token = state->openTokenStack[--state->openTokenDepth].token;
+        if (token == TemplateBrace)
+          templateString(state);
+        else if (token == JsxAttributeBrace || token == JsxChildBrace)
+          jsx(state, token == JsxAttributeBrace);
+        goto nextToken;
+      }
+      ACTION(ActJsx)
+        if (isJsxStart(state))
+          jsxElement(state);
+        goto nextToken;
+      ACTION(ActString)
+        stringLiteral(state, ch);
+        goto nextToken;
+      ACTION(ActSlash) {
+        char16_t next_ch = *(state->pos + 1);
         if (next_ch == '/') {
-          lineComment(&state);
+          lineComment(state);
           // dont update lastToken
           continue;
         }
         else if (next_ch == '*') {
-          blockComment(&state, true);
+          blockComment(state, true);
           // dont update lastToken
           continue;
         }
-        else {
-          // Division / regex ambiguity handling based on checking backtrack analysis of:
-          // - what token came previously (lastToken)
-          // - if a closing brace or paren, what token came before the corresponding
-          //   opening brace or paren (lastOpenTokenIndex)
-          char16_t lastToken = *state.lastTokenPos;
-          if (isExpressionPunctuator(lastToken) &&
-              !(lastToken == '.' && (*(state.lastTokenPos - 1) >= '0' && *(state.lastTokenPos - 1) <= '9')) &&
-              !(lastToken == '+' && *(state.lastTokenPos - 1) == '+') && !(lastToken == '-' && *(state.lastTokenPos - 1) == '-') ||
-              lastToken == ')' && isParenKeyword(&state, state.openTokenStack[state.openTokenDepth].pos) ||
-              lastToken == '}' && (isExpressionTerminator(&state, state.openTokenStack[state.openTokenDepth].pos) || state.openTokenStack[state.openTokenDepth].token == ClassBrace) ||
-              isExpressionKeyword(&state, state.lastTokenPos) ||
-              lastToken == '/' && state.lastSlashWasDivision ||
-              !lastToken) {
-            regularExpression(&state);
-            state.lastSlashWasDivision = false;
-          }
-          else {
-            // Final check - if the last token was "break x" or "continue x"
-            while (state.lastTokenPos > source && !isBrOrWsOrPunctuatorNotDot(*(--state.lastTokenPos)));
-            if (isWsNotBr(*state.lastTokenPos)) {
-              while (state.lastTokenPos > source && isWsNotBr(*(--state.lastTokenPos)));
-              if (isBreakOrContinue(&state, state.lastTokenPos)) {
-                regularExpression(&state);
-                state.lastSlashWasDivision = false;
-                break;
-              }
-            }
-            state.lastSlashWasDivision = true;
+        // Division / regex ambiguity handling based on checking backtrack analysis of:
+        // - what token came previously (lastToken)
+        // - if a closing brace or paren, what token came before the corresponding
+        //   opening brace or paren (lastOpenTokenIndex)
+        char16_t lastToken = *state->lastTokenPos;
+        if ((isExpressionPunctuator(lastToken) &&
+            !(lastToken == '.' && (beforeLastToken(state) >= '0' && beforeLastToken(state) <= '9')) &&
+            !(lastToken == '+' && beforeLastToken(state) == '+') && !(lastToken == '-' && beforeLastToken(state) == '-') &&
+            !(lastToken == '!' && (state->options & Typescript) && isNonNullAssertion(state, state->lastTokenPos))) ||
+            (lastToken == ')' && isParenKeyword(state, state->openTokenStack[state->openTokenDepth].pos)) ||
+            (lastToken == '}' && (isExpressionTerminator(state, state->openTokenStack[state->openTokenDepth].pos) || state->openTokenStack[state->openTokenDepth].token == ClassBrace)) ||
+            isExpressionKeyword(state, state->lastTokenPos) ||
+            (lastToken == '/' && state->lastSlashWasDivision) ||
+            !lastToken) {
+          regularExpression(state);
+          state->lastSlashWasDivision = false;
+          goto nextToken;
+        }
+        // Final check - if the last token was "break x" or "continue x"
+        while (state->lastTokenPos > state->source && !isBrOrWsOrPunctuatorNotDot(*(--state->lastTokenPos)));
+        if (isWsNotBr(*state->lastTokenPos)) {
+          while (state->lastTokenPos > state->source && isWsNotBr(*(--state->lastTokenPos)));
+          if (isBreakOrContinue(state, state->lastTokenPos)) {
+            regularExpression(state);
+            state->lastSlashWasDivision = false;
+            goto nextToken;
           }
         }
-        break;
+        state->lastSlashWasDivision = true;
+        goto nextToken;
       }
-      case '`':
-        state.openTokenStack[state.openTokenDepth].pos = state.lastTokenPos;
-        state.openTokenStack[state.openTokenDepth++].token = Template;
-        templateString(&state);
-        break;
+      ACTION(ActTemplate)
+        state->openTokenStack[state->openTokenDepth].pos = state->lastTokenPos;
+        state->openTokenStack[state->openTokenDepth++].token = Template;
+        templateString(state);
+        goto nextToken;
     }
-    state.lastTokenPos = state.pos;
+  nextToken:
+    state->lastTokenPos = state->pos;
+#ifdef LEXER_SIMD
+    // a token followed by whitespace or an identifier, as is common outside of
+    // minified code, is skipped from without dispatching on the next unit. A
+    // token cut off by the end of the source leaves pos past the end.
+    if (state->pos < state->end && (uint8_t)(lexAction(actions, state->pos[1]) - ActInertSpace) <= ActClass - ActInertSpace)
+      state->pos = skipInert(state, state->pos + 1) - 1;
+#endif
   }
 
-  if (state.openTokenDepth || state.has_error || state.dynamicImportStackDepth)
+  return true;
+}
+
+static bool finishParse (State *state) {
+  if (state->openTokenDepth || state->has_error || state->dynamicImportStackDepth)
     return false;
 
   // succeess
+  state->result->facade = state->facade;
+  endPrologue(state, state->end + 1);
+  if (state->options & Fingerprint)
+    fingerprintShape(state);
+  return true;
+}
+
+#define FNV_OFFSET 0xcbf29ce484222325
+#define FNV_PRIME 0x100000001b3
+
+// FNV-1a of the UTF-8 encoding of code units, so both builds hash names alike
+static uint64_t hashUnits (uint64_t hash, const char16_t* pos, const char16_t* end) {
+  for (; pos < end; pos++) {
+#ifdef LEXER_UTF16
+    uint32_t c = *pos;
+    if (c >= 0x80) {
+      if (c >= 0xD800 && c <= 0xDBFF && end - pos > 1 && (pos[1] >= 0xDC00 && pos[1] <= 0xDFFF))
+        c = 0x10000 + ((c - 0xD800) << 10) + (*++pos - 0xDC00);
+      int shift = c < 0x800 ? 6 : c < 0x10000 ? 12 : 18;
+      hash = (hash ^ ((c < 0x800 ? 0xC0 : c < 0x10000 ? 0xE0 : 0xF0) | c >> shift)) * FNV_PRIME;
+      while ((shift -= 6) >= 0)
+        hash = (hash ^ (0x80 | (c >> shift & 0x3F))) * FNV_PRIME;
+      continue;
+    }
+#endif
+    hash = (hash ^ *pos) * FNV_PRIME;
+  }
+  return hash;
+}
+
+// Hashes the decoded value of string literal contents, or the contents as
+// written when an escape is invalid.
+static uint64_t hashString (State *state, uint64_t hash, const char16_t* start, const char16_t* end) {
+  const char16_t* pos = start;
+  while (pos < end && *pos != '\\')
+    pos++;
+  if (pos == end)
+    return hashUnits(hash, start, end);
+  // decoding never lengthens
+  char16_t stackBuf[256];
+  char16_t* out = end - start <= 256 ? stackBuf : state->alloc((end - start) * sizeof(char16_t), state->user_data);
+  int32_t len = unescape(start, end, out);
+  return len == -1 ? hashUnits(hash, start, end) : hashUnits(hash, out, out + len);
+}
+
+// the MurmurHash3 finalizer, so sums of hashes don't cancel out
+static uint64_t mix64 (uint64_t hash) {
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccd;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53;
+  return hash ^ hash >> 33;
+}
+
+// Hashes a name, which is decoded when it is a string literal.
+static uint64_t hashName (State *state, uint64_t hash, const char16_t* start, const char16_t* end) {
+  return isQuote(*start) ? hashString(state, hash, start + 1, end - 1) : hashUnits(hash, start, end);
+}
+
+// Hashes each import, import binding and export on its own, and sums the mixed
+// hashes, so the fingerprint doesn't depend on their order, as if they were
+// sorted.
+static void fingerprintShape (State *state) {
+  uint64_t fingerprint = 0;
+  for (Import* import = state->result->first_import; import; import = import->next) {
+    // static, dynamic with a string, dynamic with an expression or import.meta,
+    // and whether it's of an export * from
+    uint8_t kind = import->dynamic == STANDARD_IMPORT ? 1 : import->dynamic == IMPORT_META ? 4 : import->safe ? 2 : 3;
+    uint64_t hash = (FNV_OFFSET ^ (kind | import->star_reexport << 3)) * FNV_PRIME;
+    if (kind == 1)
+      hash = hashString(state, hash, import->start, import->end);
+    else if (kind == 2 && isQuote(*import->start))
+      hash = hashString(state, hash, import->start + 1, import->end - 1);
+    else if (kind == 2)
+      hash = hashUnits(hash, import->start + 1, import->end - 1);
+    // 0xFF separators never appear in UTF-8
+    for (Attribute* attribute = import->attributes; attribute; attribute = attribute->next) {
+      hash = (hash ^ 0xFF) * FNV_PRIME;
+      hash = attribute->key_quote ? hashString(state, hash, attribute->key_start, attribute->key_end) : hashUnits(hash, attribute->key_start, attribute->key_end);
+      hash = (hash ^ 0xFF) * FNV_PRIME;
+      hash = attribute->value_len == -1 ? hashUnits(hash, attribute->value_start, attribute->value_end) : hashUnits(hash, attribute->value, attribute->value + attribute->value_len);
+    }
+    fingerprint += mix64(hash);
+    // each binding with its flags, imported name and local name, following the
+    // hash of its import
+    for (ImportBinding* binding = import->bindings; binding; binding = binding->next) {
+      uint64_t bindingHash = (hash ^ 0xFF) * FNV_PRIME;
+      bindingHash = (bindingHash ^ binding->flags) * FNV_PRIME;
+      if (binding->imported_start)
+        bindingHash = hashName(state, bindingHash, binding->imported_start, binding->imported_end);
+      bindingHash = (bindingHash ^ 0xFF) * FNV_PRIME;
+      bindingHash = hashUnits(bindingHash, binding->local_start, binding->local_end);
+      fingerprint += mix64(bindingHash);
+    }
+  }
+  for (Export* export = state->result->first_export; export; export = export->next) {
+    uint64_t hash = (FNV_OFFSET ^ ((export->cjs ? 6 : 5) | export->kind << 3)) * FNV_PRIME;
+    hash = hashName(state, hash, export->start, export->end);
+    // the name a named re-export imports
+    if (export->imported_start) {
+      hash = (hash ^ 0xFF) * FNV_PRIME;
+      hash = hashName(state, hash, export->imported_start, export->imported_end);
+    }
+    fingerprint += mix64(hash);
+  }
+  state->result->meta.fingerprint = fingerprint;
+}
+
+// With the Recover option, records the error range of a syntax error or of
+// brackets left open at the end, and resumes lexing from the next line that
+// starts with an import or export statement, returning whether it resumed.
+static bool recoverError (State *state) {
+  if (!(state->options & Recover) || (!state->has_error && !state->openTokenDepth && !state->dynamicImportStackDepth))
+    return false;
+  const char16_t* error = state->has_error ? state->source + state->result->parse_error : state->end + 1;
+  // dynamic imports still open never had their end read
+  while (state->dynamicImportStackDepth)
+    dropImport(state, state->dynamicImportStack[--state->dynamicImportStackDepth]);
+  // records so far are kept, so lines before them aren't revisited
+  const char16_t* start = state->resumePos;
+  Import* import = state->import_write_head;
+  if (import && (import->statement_end > import->start ? import->statement_end : import->start) > start)
+    start = import->statement_end > import->start ? import->statement_end : import->start;
+  if (state->export_write_head && state->export_write_head->end > start)
+    start = state->export_write_head->end;
+  if (start > error)
+    start = error;
+  const char16_t* resumePos = findStatementLine(start, state->end + 1);
+
+  ErrorRange* range = state->alloc(sizeof(ErrorRange), state->user_data);
+  if (state->error_write_head == NULL)
+    state->result->first_error = range;
+  else
+    state->error_write_head->next = range;
+  state->error_write_head = range;
+  range->start = start;
+  range->end = resumePos ? resumePos : state->end + 1;
+  range->error = error;
+  range->next = NULL;
+
+  endPrologue(state, start);
+  state->facade = false;
+  state->has_error = false;
+  state->result->parse_error = 0;
+  state->openTokenDepth = 0;
+  if (!resumePos)
+    return false;
+
+  state->pos = (char16_t*)resumePos - 1;
+  state->resumePos = resumePos;
+  state->lastTokenPos = (char16_t*)EMPTY_CHAR;
+  state->lastSlashWasDivision = false;
+  state->nextBraceIsClass = false;
+  state->mainParse = true;
   return true;
 }
 
-void tryParseImportStatement (State *state) {
+// Unlinks an import from the result, renumbering the re-exports of the imports
+// after it.
+static void dropImport (State *state, Import* drop) {
+  Import* prev = NULL;
+  int32_t index = 0;
+  Import* import = state->result->first_import;
+  while (import && import != drop) {
+    prev = import;
+    import = import->next;
+    index++;
+  }
+  if (!import)
+    return;
+  if (prev)
+    prev->next = drop->next;
+  else
+    state->result->first_import = drop->next;
+  state->import_count--;
+  for (Export* exprt = state->result->first_export; exprt; exprt = exprt->next) {
+    if (exprt->import_index > index)
+      exprt->import_index--;
+  }
+  state->import_write_head = state->import_write_head_last = NULL;
+  for (import = state->result->first_import; import; import = import->next) {
+    state->import_write_head_last = state->import_write_head;
+    state->import_write_head = import;
+  }
+}
+
+// Finds the next line starting with an import or export statement, ignoring
+// dynamic import and import.meta, or returns NULL.
+static const char16_t* findStatementLine (const char16_t* pos, const char16_t* end) {
+  while (pos < end) {
+    if (*pos++ != '\n')
+      continue;
+    while (pos < end && isWsNotBr(*pos))
+      pos++;
+    if (end - pos > 6 && ((*pos == 'i' && memcmp(pos + 1, &MPORT[0], 5 * sizeof(char16_t)) == 0) ||
+        (*pos == 'e' && memcmp(pos + 1, &XPORT[0], 5 * sizeof(char16_t)) == 0))) {
+      char16_t ch = pos[6];
+      if (isBrOrWs(ch) || ch == '{' || ch == '*' || isQuote(ch))
+        return pos;
+    }
+  }
+  return NULL;
+}
+
+static void endPrologue (State *state, const char16_t* pos) {
+  if (!state->result->meta.prologue_end)
+    state->result->meta.prologue_end = pos;
+}
+
+static void tryParseImportStatement (State *state) {
   char16_t* startPos = state->pos;
 
   state->pos += 6;
@@ -269,6 +810,9 @@ void tryParseImportStatement (State *state) {
         state->pos--;
         return;
       }
+      // a specifier cut off by the end of the source has errored
+      if (state->pos > state->end)
+        return;
       state->pos++;
       char16_t* endPos = state->pos;
       ch = commentWhitespace(state, true);
@@ -278,6 +822,9 @@ void tryParseImportStatement (State *state) {
         state->import_write_head->end = endPos;
         state->import_write_head->assert_index = state->pos;
         state->import_write_head->safe = true;
+        readSpecifier(state, state->import_write_head);
+        if (ch == '{')
+          tryParseDynamicImportAttributes(state);
         state->pos--;
       }
       else if (ch == ')') {
@@ -285,6 +832,7 @@ void tryParseImportStatement (State *state) {
         state->import_write_head->end = endPos;
         state->import_write_head->statement_end = state->pos + 1;
         state->import_write_head->safe = true;
+        readSpecifier(state, state->import_write_head);
         state->dynamicImportStackDepth--;
       }
       else {
@@ -306,6 +854,7 @@ void tryParseImportStatement (State *state) {
         state->pos--;
         break;
       }
+      // fallthrough
     case '"':
     case '\'':
     case '*': {
@@ -314,10 +863,29 @@ void tryParseImportStatement (State *state) {
         state->pos--;
         return;
       }
+      // import type X from, import type { A } from, import type * as ns from
+      bool typeOnly = ch == 't' && skipTypeModifier(state);
+      if (typeOnly)
+        ch = *state->pos;
+      ImportBinding* bindings = NULL;
+      if (!isQuote(ch) && state->pos <= state->end) {
+        bindings = readImportBindings(state, ch);
+        // a clause cut off by the end of the source errors at its last code unit
+        if (state->pos > state->end)
+          state->pos = state->end;
+        // import x = require('a') and import x = ns.x, left to the require
+        // lexing and as an expression
+        if (*state->pos == '=' && (state->options & Typescript)) {
+          state->pos--;
+          return;
+        }
+      }
       while (state->pos < state->end) {
         ch = *state->pos;
         if (isQuote(ch)) {
           readImportString(state, startPos, ch);
+          state->import_write_head->bindings = bindings;
+          state->import_write_head->type_only = typeOnly;
           return;
         }
         state->pos++;
@@ -333,18 +901,9 @@ void tryParseImportStatement (State *state) {
         return;
       }
 
-      while (state->pos < state->end) {
-        ch = commentWhitespace(state, true);
-
-        if (isQuote(ch)) {
-          stringLiteral(state, ch);
-        } else if (ch == '}') {
-          state->pos++;
-          break;
-        }
-
-        state->pos++;
-      }
+      ImportBinding* bindings = NULL;
+      ImportBinding** tail = &bindings;
+      readNamedImports(state, &tail);
 
       ch = commentWhitespace(state, true);
       if (memcmp(state->pos, &FROM[0], 4 * sizeof(char16_t)) != 0) {
@@ -360,13 +919,138 @@ void tryParseImportStatement (State *state) {
       }
 
       readImportString(state, startPos, ch);
+      state->import_write_head->bindings = bindings;
 
       break;
     }
   }
 }
 
-void tryParseRequire (State *state) {
+// Reads the bindings of an import clause from its first token, stopping at
+// the `from` or at anything unexpected, where the caller's search for the
+// specifier carries on.
+static ImportBinding* readImportBindings (State *state, char16_t ch) {
+  ImportBinding* first = NULL;
+  ImportBinding** tail = &first;
+  uint32_t phase = 0;
+  if (ch != '*' && ch != '{') {
+    char16_t* startPos = state->pos;
+    ch = readImportName(state, ch);
+    char16_t* endPos = state->pos;
+    ch = commentWhitespace(state, true);
+    // import source x from
+    if (ch != '*' && !isPunctuator(ch) && !isQuote(ch) && !(ch == 'f' && memcmp(state->pos + 1, &FROM[1], 3 * sizeof(char16_t)) == 0)) {
+      phase = BindingPhase;
+      startPos = state->pos;
+      ch = readImportName(state, ch);
+      endPos = state->pos;
+      ch = commentWhitespace(state, true);
+    }
+    // import defer * as ns from
+    if (ch == '*') {
+      phase = BindingPhase;
+    }
+    else {
+      if (endPos == startPos)
+        return first;
+      addBinding(state, &tail, NULL, NULL, startPos, endPos, phase ? phase : BindingDefault);
+      if (ch != ',')
+        return first;
+      state->pos++;
+      ch = commentWhitespace(state, true);
+    }
+  }
+  if (ch == '*') {
+    state->pos++;
+    ch = commentWhitespace(state, true);
+    if (ch == 'a' && *(state->pos + 1) == 's' && isBrOrWsOrPunctuatorNotDot(*(state->pos + 2))) {
+      state->pos += 2;
+      ch = commentWhitespace(state, true);
+      char16_t* localStartPos = state->pos;
+      readImportName(state, ch);
+      if (state->pos != localStartPos)
+        addBinding(state, &tail, NULL, NULL, localStartPos, state->pos, BindingNamespace | phase);
+    }
+  }
+  else if (ch == '{') {
+    readNamedImports(state, &tail);
+  }
+  return first;
+}
+
+// Reads the `a as b` bindings of an import clause's braces, from the `{` to
+// just past the `}`.
+static void readNamedImports (State *state, ImportBinding*** tail) {
+  // a `{` ending the source is left as the syntax error position
+  if (state->pos >= state->end)
+    return;
+  state->pos++;
+  while (state->pos < state->end) {
+    char16_t ch = commentWhitespace(state, true);
+    if (ch == '}') {
+      state->pos++;
+      return;
+    }
+
+    // import { type A } from
+    uint32_t typeFlag = 0;
+    if (ch == 't' && skipTypeModifier(state)) {
+      typeFlag = BindingType;
+      ch = *state->pos;
+    }
+
+    char16_t* importedStartPos = state->pos;
+    // import { "string name" as x } from
+    if (isQuote(ch)) {
+      stringLiteral(state, ch);
+      // a name cut off by the end of the source has errored
+      if (state->pos > state->end)
+        return;
+      state->pos++;
+    }
+    else {
+      readImportName(state, ch);
+    }
+    char16_t* importedEndPos = state->pos;
+    // a comma or unexpected punctuator
+    if (importedEndPos == importedStartPos) {
+      state->pos++;
+      continue;
+    }
+
+    char16_t* localStartPos = importedStartPos;
+    char16_t* localEndPos = importedEndPos;
+    ch = commentWhitespace(state, true);
+    if (ch == 'a' && *(state->pos + 1) == 's' && isBrOrWsOrPunctuatorNotDot(*(state->pos + 2))) {
+      state->pos += 2;
+      ch = commentWhitespace(state, true);
+      localStartPos = state->pos;
+      readImportName(state, ch);
+      localEndPos = state->pos;
+      if (localEndPos == localStartPos)
+        continue;
+    }
+
+    // default as x, or "default" as x
+    const char16_t* name = isQuote(*importedStartPos) ? importedStartPos + 1 : importedStartPos;
+    uint32_t nameLen = isQuote(*importedStartPos) ? importedEndPos - importedStartPos - 2 : importedEndPos - importedStartPos;
+    bool isDefault = nameLen == 7 && memcmp(name, &DEFAULT[0], 7 * sizeof(char16_t)) == 0;
+    addBinding(state, tail, importedStartPos, importedEndPos, localStartPos, localEndPos, (isDefault ? BindingDefault : 0) | typeFlag);
+  }
+  // unterminated, so the caller errors at the last code unit
+  if (state->pos > state->end)
+    state->pos = state->end;
+}
+
+// Like readToWsOrPunctuator, but also stopping at a quote, so a malformed
+// clause can't hide the specifier from the caller's search.
+static char16_t readImportName (State *state, char16_t ch) {
+  while (ch && !isBrOrWs(ch) && !isPunctuator(ch) && !isQuote(ch))
+    ch = *(++state->pos);
+  return ch;
+}
+
+static void tryParseRequire (State *state) {
   char16_t* startPos = state->pos;
   // require('...')
   if (keywordStart(state) && memcmp(state->pos + 1, &EQUIRE[0], 6 * sizeof(char16_t)) == 0) {
@@ -379,6 +1063,8 @@ void tryParseRequire (State *state) {
       state->pos++;
       ch = commentWhitespace(state, true);
       addImport(state, startPos, state->pos, 0, dynamicPos);
+      if (!state->result->meta.require)
+        state->result->meta.require = startPos;
       state->dynamicImportStack[state->dynamicImportStackDepth++] = state->import_write_head;
       if (ch == '\'' || ch == '"') {
         stringLiteral(state, ch);
@@ -390,6 +1076,9 @@ void tryParseRequire (State *state) {
         state->pos--;
         return;
       }
+      // a specifier cut off by the end of the source has errored
+      if (state->pos > state->end)
+        return;
       state->pos++;
       char16_t* endPos = state->pos;
       ch = commentWhitespace(state, true);
@@ -398,6 +1087,7 @@ void tryParseRequire (State *state) {
         state->import_write_head->end = endPos;
         state->import_write_head->statement_end = state->pos + 1;
         state->import_write_head->safe = true;
+        readSpecifier(state, state->import_write_head);
         state->dynamicImportStackDepth--;
       } else {
         state->pos--;
@@ -405,14 +1095,274 @@ void tryParseRequire (State *state) {
       return;
     } else if (ch != ':' && ch != '.' && !isIdentifierChar(nextChar(state))) {
       addImport(state, startPos, state->pos, state->pos, state->pos);
+      if (!state->result->meta.require)
+        state->result->meta.require = startPos;
     }
     state->pos = startPos;
   }
 }
 
-void tryParseExportStatement (State *state) {
+// Records the first await outside of any function, which makes the module
+// async to evaluate. Function bodies are told from blocks by what comes before
+// their braces, with arrow expression bodies found by scanning back.
+static void tryParseAwait (State *state) {
+  char16_t* pos = state->pos + 5;
+  if (pos <= state->end && isIdentifierChar(*pos))
+    return;
+  while (pos <= state->end && isWsNotBr(*pos))
+    pos++;
+  // await as an identifier or property name, in scripts
+  if (pos <= state->end && (*pos == ':' || *pos == ',' || *pos == ')' || *pos == '=' || *pos == ';' || *pos == ']' || *pos == '}'))
+    return;
+  for (uint16_t i = state->openTokenDepth; i-- > 0;) {
+    OpenToken* openToken = &state->openTokenStack[i];
+    if (openToken->token == ClassBrace || (openToken->token == AnyBrace && isFunctionBrace(state, openToken->pos)))
+      return;
+  }
+  if (!inArrowBody(state, state->pos))
+    state->result->meta.top_level_await = state->pos;
+}
+
+// Scans back from pos for a => whose expression body contains it, through
+// the brackets enclosing pos, until reaching the start of the statement. A ,
+// or ; or a line break not continuing an expression ends an arrow body at its
+// level. Brackets in comments and regular expressions aren't skipped.
+static bool inArrowBody (State *state, char16_t* pos) {
+  uint32_t nesting = 0;
+  // past the end of any arrow body at this level
+  bool ended = false;
+  while (pos-- > state->source) {
+    char16_t ch = *pos;
+    switch (ch) {
+      case ')':
+      case ']':
+      case '}':
+        nesting++;
+        break;
+      case '(':
+      case '[':
+        if (nesting)
+          nesting--;
+        else
+          ended = false;
+        break;
+      case '{': {
+        if (nesting) {
+          nesting--;
+          break;
+        }
+        char16_t* prev = pos;
+        while (prev > state->source && isBrOrWs(*(prev - 1)))
+          prev--;
+        ch = prev > state->source ? *(prev - 1) : '\0';
+        // a template substitution, continuing before the template
+        if (ch == '$') {
+          while (--pos > state->source && *pos != '`');
+          ended = false;
+          break;
+        }
+        // an object literal can be in an arrow body, a block can't
+        if (ch != '(' && ch != '[' && ch != ',' && ch != ':' && ch != '=' && ch != '?' && ch != '|' && ch != '&')
+          return false;
+        ended = false;
+        break;
+      }
+      case ',':
+      case ';':
+        if (!nesting)
+          ended = true;
+        break;
+      case '\n':
+      case '\r': {
+        if (nesting || ended)
+          break;
+        char16_t* prev = pos;
+        while (prev > state->source && isBrOrWs(*(prev - 1)))
+          prev--;
+        if (prev == state->source || !isExpressionPunctuator(*(prev - 1)))
+          ended = true;
+        break;
+      }
+      case '>':
+        if (!nesting && !ended && pos > state->source && *(pos - 1) == '=')
+          return true;
+        break;
+      case '\'':
+      case '"': {
+        char16_t* quotePos = pos;
+        while (--pos > state->source && !(*pos == ch && *(pos - 1) != '\\')) {
+          if (isBr(*pos)) {
+            pos = quotePos;
+            break;
+          }
+        }
+        break;
+      }
+      case '`':
+        while (--pos > state->source && *pos != '`');
+        break;
+    }
+  }
+  return false;
+}
+
+// Reads the rest of `exports` or `module.exports` from its first character,
+// returning the character after it.
+static char16_t readCjsExportsObject (State *state) {
+  if (*state->pos == 'm') {
+    state->pos += 6;
+    char16_t ch = commentWhitespace(state, true);
+    if (ch != '.')
+      return '\0';
+    state->pos++;
+    ch = commentWhitespace(state, true);
+    if (ch != 'e' || memcmp(state->pos + 1, &XPORTS[0], 6 * sizeof(char16_t)) != 0)
+      return '\0';
+  }
+  state->pos += 7;
+  if (isIdentifierChar(*state->pos))
+    return '\0';
+  return commentWhitespace(state, true);
+}
+
+static void addCjsExport (State *state, const char16_t* start, const char16_t* end) {
+  addExport(state, start, end, NULL, NULL);
+  state->export_write_head->cjs = true;
+}
+
+// exports.a = ..., exports['a'] = ..., module.exports.a = ...,
+// module.exports = { a, b: c }
+//
+// Only looks ahead, leaving the position for the main loop to lex the
+// statement as usual.
+static void tryParseCjsExports (State *state) {
+  char16_t* startPos = state->pos;
+  char16_t ch = readCjsExportsObject(state);
+  const char16_t* nameStart = NULL;
+  const char16_t* nameEnd = NULL;
+
+  if (ch == '.') {
+    state->pos++;
+    ch = commentWhitespace(state, true);
+    nameStart = state->pos;
+    ch = readToWsOrPunctuator(state, ch);
+    nameEnd = state->pos;
+    ch = commentWhitespace(state, true);
+  }
+  else if (ch == '[') {
+    state->pos++;
+    ch = commentWhitespace(state, true);
+    if (ch == '\'' || ch == '"') {
+      nameStart = state->pos;
+      stringLiteral(state, ch);
+      // a name cut off by the end of the source has errored
+      if (state->pos > state->end)
+        return;
+      nameEnd = ++state->pos;
+      ch = commentWhitespace(state, true);
+      if (ch == ']') {
+        state->pos++;
+        ch = commentWhitespace(state, true);
+      }
+      else {
+        nameStart = NULL;
+      }
+    }
+  }
+  else if (ch == '=' && *startPos == 'm' && *(state->pos + 1) != '=') {
+    state->pos++;
+    ch = commentWhitespace(state, true);
+    if (ch == '{') {
+      state->pos++;
+      while (!state->has_error) {
+        ch = commentWhitespace(state, true);
+        const char16_t* keyStart = state->pos;
+        if (ch == '\'' || ch == '"') {
+          stringLiteral(state, ch);
+          if (state->pos > state->end)
+            return;
+          state->pos++;
+        }
+        else {
+          ch = readToWsOrPunctuator(state, ch);
+        }
+        const char16_t* keyEnd = state->pos;
+        if (keyEnd == keyStart)
+          break;
+        ch = commentWhitespace(state, true);
+        // { a: b }, with an identifier value only
+        if (ch == ':') {
+          state->pos++;
+          ch = commentWhitespace(state, true);
+          const char16_t* valueStart = state->pos;
+          ch = readToWsOrPunctuator(state, ch);
+          if (state->pos == valueStart)
+            break;
+          ch = commentWhitespace(state, true);
+        }
+        else if (*keyStart == '\'' || *keyStart == '"') {
+          break;
+        }
+        if (ch != ',' && ch != '}')
+          break;
+        addCjsExport(state, keyStart, keyEnd);
+        if (ch == '}')
+          break;
+        state->pos++;
+      }
+    }
+  }
+
+  if (nameStart && nameEnd > nameStart && ch == '=' && *(state->pos + 1) != '=')
+    addCjsExport(state, nameStart, nameEnd);
+
+  if (!state->has_error)
+    state->pos = startPos;
+}
+
+// Object.defineProperty(exports, 'a', ...), including the __esModule marker
+static void tryParseDefineProperty (State *state) {
+  char16_t* startPos = state->pos;
+  state->pos += 6;
+  char16_t ch = commentWhitespace(state, true);
+  if (ch == '.') {
+    state->pos++;
+    ch = commentWhitespace(state, true);
+    if (memcmp(state->pos, &DEFINEPROPERTY[0], 14 * sizeof(char16_t)) == 0) {
+      state->pos += 14;
+      ch = commentWhitespace(state, true);
+      if (ch == '(') {
+        state->pos++;
+        ch = commentWhitespace(state, true);
+        if ((ch == 'e' && memcmp(state->pos + 1, &XPORTS[0], 6 * sizeof(char16_t)) == 0) ||
+            (ch == 'm' && memcmp(state->pos + 1, &ODULE[0], 5 * sizeof(char16_t)) == 0)) {
+          ch = readCjsExportsObject(state);
+          if (ch == ',') {
+            state->pos++;
+            ch = commentWhitespace(state, true);
+            if (ch == '\'' || ch == '"') {
+              const char16_t* nameStart = state->pos;
+              stringLiteral(state, ch);
+              // a name cut off by the end of the source has errored
+              if (state->pos > state->end)
+                return;
+              const char16_t* nameEnd = ++state->pos;
+              if (commentWhitespace(state, true) == ',')
+                addCjsExport(state, nameStart, nameEnd);
+            }
+          }
+        }
+      }
+    }
+  }
+  if (!state->has_error)
+    state->pos = startPos;
+}
+
+static void tryParseExportStatement (State *state) {
   char16_t* sStartPos = state->pos;
   Export* prev_export_write_head = state->export_write_head;
+  enum ExportKind reexportKind = ReexportNamed;
 
   state->pos += 6;
 
@@ -423,11 +1373,33 @@ void tryParseExportStatement (State *state) {
   if (state->pos == curPos && !isPunctuator(ch))
     return;
 
+  // export type { A }
+  // export type * from
+  bool typeOnly = false;
+  if (ch == 't') {
+    char16_t* typePos = state->pos;
+    if (skipTypeModifier(state)) {
+      ch = *state->pos;
+      typeOnly = ch == '{' || ch == '*';
+      if (!typeOnly) {
+        state->pos = typePos;
+        ch = 't';
+      }
+    }
+  }
+
   if (ch == '{') {
     state->pos++;
     ch = commentWhitespace(state, true);
     while (true) {
+      // export { type A }
+      bool typeName = typeOnly;
+      if (ch == 't' && skipTypeModifier(state)) {
+        typeName = true;
+        ch = *state->pos;
+      }
       char16_t* startPos = state->pos;
+      Export* prevExport = state->export_write_head;
 
       if (!isQuote(ch)) {
         ch = readToWsOrPunctuator(state, ch);
@@ -443,12 +1415,17 @@ void tryParseExportStatement (State *state) {
       // export { "%notid" } from
       else {
         stringLiteral(state, ch);
+        // a name cut off by the end of the source has errored
+        if (state->pos > state->end)
+          return;
         state->pos++;
       }
 
       char16_t* endPos = state->pos;
       commentWhitespace(state, true);
       ch = readExportAs(state, startPos, endPos);
+      if (typeName && state->export_write_head != prevExport)
+        state->export_write_head->type_only = true;
       // ,
       if (ch == ',') {
         state->pos++;
@@ -467,20 +1444,41 @@ void tryParseExportStatement (State *state) {
   // export *
   // export * as X
   else if (ch == '*') {
+    reexportKind = ReexportNamespace;
     state->pos++;
     commentWhitespace(state, true);
+    Export* prevExport = state->export_write_head;
     ch = readExportAs(state, state->pos, state->pos);
+    if (typeOnly && state->export_write_head != prevExport)
+      state->export_write_head->type_only = true;
     ch = commentWhitespace(state, true);
   }
   else {
     state->facade = false;
+    if ((state->options & Typescript) && tryParseTypeExport(state))
+      return;
+    ch = *state->pos;
     switch (ch) {
       // export default ...
       case 'd': {
         const char16_t* startPos = state->pos;
         state->pos += 7;
+        // a keyword cut off by the end of the source
+        if (state->pos > state->end)
+          return;
         ch = commentWhitespace(state, true);
         bool localName = false;
+        // export default interface name {}
+        if (ch == 'i' && (state->options & Typescript) && isWordAt(state->pos, &NTERFACE[0], 8)) {
+          state->pos += 9;
+          ch = commentWhitespace(state, true);
+          const char16_t* localStartPos = state->pos;
+          readToWsOrPunctuator(state, ch);
+          addExport(state, startPos, startPos + 7, localStartPos, state->pos);
+          state->export_write_head->type_only = true;
+          state->pos--;
+          return;
+        }
         // export default async? function*? name? (){}
         if (ch == 'a' && keywordStart(state) &&  memcmp(state->pos + 1, &SYNC[0], 4 * sizeof(char16_t)) == 0 && isWsNotBr(*(state->pos + 5))) {
           state->pos += 5;
@@ -526,10 +1524,14 @@ void tryParseExportStatement (State *state) {
       // export async? function*? name () {
       case 'a':
         state->pos += 5;
+        if (state->pos > state->end)
+          return;
         commentWhitespace(state, true);
       // fallthrough
       case 'f':
         state->pos += 8;
+        if (state->pos > state->end)
+          return;
         ch = commentWhitespace(state, true);
         if (ch == '*') {
           state->pos++;
@@ -561,6 +1563,8 @@ void tryParseExportStatement (State *state) {
         // destructured initializations not currently supported (skipped for { or [)
         // also, lexing names after variable equals is skipped (export var p = function () { ... }, q = 5 skips "q")
         state->pos += 2;
+        if (state->pos > state->end)
+          return;
         state->facade = false;
         do {
           state->pos++;
@@ -583,6 +1587,9 @@ void tryParseExportStatement (State *state) {
         return;
 
       default:
+        // a punctuator is lexed as usual, so a closing one is matched
+        if (isPunctuator(ch))
+          state->pos--;
         return;
     }
   }
@@ -591,9 +1598,21 @@ void tryParseExportStatement (State *state) {
   if (ch == 'f' && memcmp(state->pos + 1, &FROM[1], 3 * sizeof(char16_t)) == 0) {
     state->pos += 4;
     readImportString(state, sStartPos, commentWhitespace(state, true));
-
-    // There were no local names.
-    for (Export* exprt = prev_export_write_head == NULL ? state->result->first_export : prev_export_write_head->next; exprt != NULL; exprt = exprt->next) {
+    if (state->has_error)
+      return;
+    state->import_write_head->type_only = typeOnly;
+
+    Export* first_reexport = prev_export_write_head == NULL ? state->result->first_export : prev_export_write_head->next;
+    // export * from
+    if (first_reexport == NULL && reexportKind == ReexportNamespace)
+      state->import_write_head->star_reexport = true;
+
+    // There were no local names, only names imported from the module.
+    for (Export* exprt = first_reexport; exprt != NULL; exprt = exprt->next) {
+      exprt->kind = reexportKind;
+      exprt->import_index = state->import_count - 1;
+      exprt->imported_start = exprt->local_start;
+      exprt->imported_end = exprt->local_end;
       exprt->local_start = exprt->local_end = NULL;
     }
   }
@@ -602,7 +1621,7 @@ void tryParseExportStatement (State *state) {
   }
 }
 
-char16_t readExportAs (State *state, char16_t* startPos, char16_t* endPos) {
+static char16_t readExportAs (State *state, char16_t* startPos, char16_t* endPos) {
   char16_t ch = *state->pos;
   char16_t* localStartPos = startPos == endPos ? NULL : startPos;
   char16_t* localEndPos = startPos == endPos ? NULL : endPos;
@@ -629,15 +1648,178 @@ char16_t readExportAs (State *state, char16_t* startPos, char16_t* endPos) {
 
     endPos = state->pos;
 
-    ch = commentWhitespace(state, true);
+    ch = commentWhitespace(state, true);
+  }
+
+  if (state->pos != startPos)
+    addExport(state, startPos, endPos, localStartPos, localEndPos);
+  return ch;
+}
+
+// With the Typescript option, skips a `type` modifier of an import or export
+// clause or of one of its names, returning whether there was one. The `type`
+// is a name itself when followed by a comma, brace, `=`, `as`, or `from` and
+// a specifier, as in `import { type as t }` or `import type from 'a'`.
+static bool skipTypeModifier (State *state) {
+  char16_t* typePos = state->pos;
+  if (!(state->options & Typescript) || !isWordAt(state->pos, &YPE[0], 3))
+    return false;
+  state->pos += 4;
+  char16_t ch = commentWhitespace(state, true);
+  bool modifier = state->pos < state->end && (ch == '{' || ch == '*' || !isPunctuator(ch)) &&
+      !(ch == 'a' && *(state->pos + 1) == 's' && isBrOrWsOrPunctuatorNotDot(*(state->pos + 2)));
+  if (modifier && ch == 'f' && memcmp(state->pos + 1, &FROM[1], 3 * sizeof(char16_t)) == 0) {
+    char16_t* fromPos = state->pos;
+    state->pos += 4;
+    modifier = !isQuote(commentWhitespace(state, true));
+    state->pos = fromPos;
+  }
+  if (!modifier)
+    state->pos = typePos;
+  return modifier;
+}
+
+// With the Typescript option, lexes the TypeScript declarations an export can
+// be of from after the `export`, returning whether it did. Type aliases and
+// interfaces are type-only exports, enums, namespaces and `export import x =`
+// are exports, and `export as namespace` and ambient `declare module 'a'`
+// export nothing. Otherwise `declare` and `abstract` modifiers are skipped,
+// leaving the rest of the declaration to the caller.
+static bool tryParseTypeExport (State *state) {
+  char16_t ch = *state->pos;
+  while ((ch == 'd' && isWordAt(state->pos, &ECLARE[0], 6)) || (ch == 'a' && isWordAt(state->pos, &BSTRACT[0], 7))) {
+    state->pos += ch == 'd' ? 7 : 8;
+    ch = commentWhitespace(state, true);
+  }
+  bool typeOnly = false;
+  switch (ch) {
+    // export as namespace X
+    case 'a':
+      return *(state->pos + 1) == 's' && isBrOrWs(*(state->pos + 2));
+    // export type X = ...
+    case 't':
+      if (!isWordAt(state->pos, &YPE[0], 3))
+        return false;
+      typeOnly = true;
+      state->pos += 4;
+      break;
+    // export interface X {}
+    // export import x = ns.x
+    case 'i':
+      if (isWordAt(state->pos, &NTERFACE[0], 8)) {
+        typeOnly = true;
+        state->pos += 9;
+      }
+      else if (isWordAt(state->pos, &MPORT[0], 5))
+        state->pos += 6;
+      else
+        return false;
+      break;
+    // export const enum E {}
+    case 'c': {
+      char16_t* constPos = state->pos;
+      if (!isWordAt(state->pos, &ONST[0], 4))
+        return false;
+      state->pos += 5;
+      if (commentWhitespace(state, true) != 'e' || !isWordAt(state->pos, &NUM[0], 3)) {
+        state->pos = constPos;
+        return false;
+      }
+    }
+    // fallthrough
+    // export enum E {}
+    case 'e':
+      if (!isWordAt(state->pos, &NUM[0], 3))
+        return false;
+      state->pos += 4;
+      break;
+    // export namespace N {}
+    case 'n':
+      if (!isWordAt(state->pos, &AMESPACE[0], 8))
+        return false;
+      state->pos += 9;
+      break;
+    // export module N {}
+    // export declare module 'a' {}
+    case 'm':
+      if (!isWordAt(state->pos, &ODULE[0], 5))
+        return false;
+      state->pos += 6;
+      break;
+    default:
+      return false;
+  }
+  ch = commentWhitespace(state, true);
+  const char16_t* startPos = state->pos;
+  if (!isQuote(ch))
+    readToWsOrPunctuator(state, ch);
+  if (state->pos != startPos) {
+    addExport(state, startPos, state->pos, startPos, state->pos);
+    state->export_write_head->type_only = typeOnly;
+  }
+  state->pos--;
+  return true;
+}
+
+// With the Specifiers option, classifies a string specifier and hashes it, so
+// resolvers can look it up without reading it again. Specifiers with escapes
+// are left unclassified, since their value isn't their source text.
+static void readSpecifier (State *state, Import* import) {
+  if (!(state->options & Specifiers))
+    return;
+  const char16_t* start = import->start;
+  const char16_t* end = import->end;
+  if (import->dynamic != STANDARD_IMPORT) {
+    if (!isQuote(*start))
+      return;
+    start++;
+    end--;
   }
+  for (const char16_t* pos = start; pos < end; pos++) {
+    if (*pos == '\\')
+      return;
+  }
+  import->hash = hashUnits(FNV_OFFSET, start, end);
 
-  if (state->pos != startPos)
-    addExport(state, startPos, endPos, localStartPos, localEndPos);
-  return ch;
+  size_t len = end - start;
+  char16_t ch = len ? *start : '\0';
+  if (ch == '.' && (len == 1 || start[1] == '/' || (start[1] == '.' && (len == 2 || start[2] == '/')))) {
+    import->specifier_kind = SpecifierRelative;
+    return;
+  }
+  if (ch == '/') {
+    import->specifier_kind = SpecifierAbsolute;
+    return;
+  }
+  if (ch == '#') {
+    import->specifier_kind = SpecifierImports;
+    return;
+  }
+  // a scheme of at least two characters, so Windows drive letters aren't URLs
+  if ((ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z')) {
+    const char16_t* pos = start + 1;
+    while (pos < end && ((*pos >= 'a' && *pos <= 'z') || (*pos >= 'A' && *pos <= 'Z') || (*pos >= '0' && *pos <= '9') || *pos == '+' || *pos == '-' || *pos == '.'))
+      pos++;
+    if (pos < end && *pos == ':' && pos - start >= 2) {
+      import->specifier_kind = SpecifierUrl;
+      return;
+    }
+  }
+  import->specifier_kind = SpecifierBare;
+  const char16_t* pos = start;
+  // the package name of a scoped package includes its first /
+  if (ch == '@') {
+    while (pos < end && *pos != '/')
+      pos++;
+    if (pos < end)
+      pos++;
+  }
+  while (pos < end && *pos != '/')
+    pos++;
+  import->subpath_start = pos;
 }
 
-void readImportString (State *state, const char16_t* ss, char16_t ch) {
+static void readImportString (State *state, const char16_t* ss, char16_t ch) {
   const char16_t* startPos = state->pos + 1;
   if (ch == '\'') {
     stringLiteral(state, ch);
@@ -650,71 +1832,135 @@ void readImportString (State *state, const char16_t* ss, char16_t ch) {
     return;
   }
   addImport(state, ss, startPos, state->pos, STANDARD_IMPORT);
+  readSpecifier(state, state->import_write_head);
+  // a specifier cut off by the end of the source has errored
+  if (state->pos > state->end)
+    return;
   state->pos++;
   ch = commentWhitespace(state, false);
-  if (ch != 'a' || memcmp(state->pos + 1, &SSERT[0], 5 * sizeof(char16_t)) != 0) {
+  char16_t* assertIndex = state->pos;
+  if (ch == 'a' && memcmp(state->pos + 1, &SSERT[0], 5 * sizeof(char16_t)) == 0)
+    state->pos += 6;
+  else if (ch == 'w' && memcmp(state->pos + 1, &ITH[0], 3 * sizeof(char16_t)) == 0)
+    state->pos += 4;
+  else {
     state->pos--;
     return;
   }
-  char16_t* assertIndex = state->pos;
-  state->pos += 6;
+  char16_t* keywordEnd = state->pos - 1;
   ch = commentWhitespace(state, true);
   if (ch != '{') {
     state->pos = assertIndex;
     return;
   }
   const char16_t* assertStart = state->pos;
+  Attribute* attributes;
+  if (!readImportAttributes(state, &attributes)) {
+    state->pos = assertIndex;
+    return;
+  }
+  state->import_write_head->assert_index = assertStart;
+  state->import_write_head->attributes = attributes;
+  state->import_write_head->statement_end = state->pos + 1;
+  // the closing brace is left as the last token, so its opening brace is
+  // recorded as the main loop would have, for the regex check after it
+  state->openTokenStack[state->openTokenDepth].token = AnyBrace;
+  state->openTokenStack[state->openTokenDepth].pos = keywordEnd;
+}
+
+// Reads the `key: 'value'` pairs of an import attributes object, from its
+// opening brace to its closing brace, returning false if it isn't one.
+static bool readImportAttributes (State *state, Attribute** first) {
+  Attribute** next = first;
+  *first = NULL;
+  char16_t ch;
   do {
     state->pos++;
     ch = commentWhitespace(state, true);
-    if (ch == '\'') {
-      stringLiteral(state, ch);
-      state->pos++;
-      ch = commentWhitespace(state, true);
-    }
-    else if (ch == '"') {
+    if (ch == '}')
+      return true;
+    const char16_t* keyStart = state->pos;
+    const char16_t* keyEnd;
+    char16_t keyQuote = 0;
+    if (ch == '\'' || ch == '"') {
+      keyQuote = ch;
+      keyStart++;
       stringLiteral(state, ch);
-      state->pos++;
-      ch = commentWhitespace(state, true);
+      keyEnd = state->pos++;
     }
     else {
-      ch = readToWsOrPunctuator(state, ch);
-    }
-    if (ch != ':') {
-      state->pos = assertIndex;
-      return;
+      readToWsOrPunctuator(state, ch);
+      keyEnd = state->pos;
+      if (keyEnd == keyStart)
+        return false;
     }
-    state->pos++;
     ch = commentWhitespace(state, true);
-    if (ch == '\'') {
-      stringLiteral(state, ch);
-    }
-    else if (ch == '"') {
-      stringLiteral(state, ch);
-    }
-    else {
-      state->pos = assertIndex;
-      return;
-    }
+    if (ch != ':')
+      return false;
     state->pos++;
     ch = commentWhitespace(state, true);
-    if (ch == ',') {
-      state->pos++;
-      ch = commentWhitespace(state, true);
-      if (ch == '}')
+    if (ch != '\'' && ch != '"')
+      return false;
+    const char16_t* valueStart = state->pos + 1;
+    stringLiteral(state, ch);
+    if (state->has_error)
+      return false;
+
+    Attribute* attribute = state->alloc(sizeof(Attribute), state->user_data);
+    attribute->key_start = keyStart;
+    attribute->key_end = keyEnd;
+    attribute->key_quote = keyQuote;
+    attribute->value_start = valueStart;
+    attribute->value_end = state->pos;
+    attribute->value_quote = ch;
+    attribute->value = valueStart;
+    attribute->value_len = state->pos - valueStart;
+    for (const char16_t* pos = valueStart; pos < state->pos; pos++) {
+      if (*pos == '\\') {
+        // decoding never lengthens a string
+        char16_t* value = state->alloc(attribute->value_len * sizeof(char16_t), state->user_data);
+        attribute->value = value;
+        attribute->value_len = unescape(valueStart, state->pos, value);
         break;
-      continue;
+      }
     }
-    if (ch == '}')
-      break;
-    state->pos = assertIndex;
+    attribute->next = NULL;
+    *next = attribute;
+    next = &attribute->next;
+
+    state->pos++;
+    ch = commentWhitespace(state, true);
+  } while (ch == ',');
+  return ch == '}';
+}
+
+// Reads the attributes of a dynamic import's `{ with: { ... } }` (or assert)
+// options object, only looking ahead as the main loop lexes the options.
+static void tryParseDynamicImportAttributes (State *state) {
+  char16_t* startPos = state->pos;
+  Import* import = state->import_write_head;
+  state->pos++;
+  char16_t ch = commentWhitespace(state, true);
+  if (ch == 'a' && memcmp(state->pos + 1, &SSERT[0], 5 * sizeof(char16_t)) == 0)
+    state->pos += 6;
+  else if (ch == 'w' && memcmp(state->pos + 1, &ITH[0], 3 * sizeof(char16_t)) == 0)
+    state->pos += 4;
+  else {
+    state->pos = startPos;
     return;
-  } while (true);
-  state->import_write_head->assert_index = assertStart;
-  state->import_write_head->statement_end = state->pos + 1;
+  }
+  ch = commentWhitespace(state, true);
+  if (ch == ':') {
+    state->pos++;
+    Attribute* attributes;
+    if (commentWhitespace(state, true) == '{' && readImportAttributes(state, &attributes))
+      import->attributes = attributes;
+  }
+  if (!state->has_error)
+    state->pos = startPos;
 }
 
-char16_t commentWhitespace (State *state, bool br) {
+static char16_t commentWhitespace (State *state, bool br) {
   char16_t ch;
   do {
     ch = *state->pos;
@@ -726,6 +1972,9 @@ char16_t commentWhitespace (State *state, bool br) {
         blockComment(state, br);
       else
         return ch;
+      // a comment running to the end of the source leaves pos at the terminator
+      if (state->pos > state->end)
+        return *state->pos;
     }
     else if (br ? !isBrOrWs(ch) : !isWsNotBr(ch)) {
       return ch;
@@ -734,8 +1983,11 @@ char16_t commentWhitespace (State *state, bool br) {
   return ch;
 }
 
-void templateString (State *state) {
+static void templateString (State *state) {
   while (state->pos++ < state->end) {
+#ifdef LEXER_SIMD
+    state->pos = skipToAny(state->pos, state->end, '`', '$', '\\', '\\');
+#endif
     char16_t ch = *state->pos;
     if (ch == '$' && *(state->pos + 1) == '{') {
       state->pos++;
@@ -754,9 +2006,129 @@ void templateString (State *state) {
   syntaxError(state);
 }
 
-void blockComment (State *state, bool br) {
+// With the Jsx option, whether the `<` at state->pos opens a JSX element or
+// fragment, which it does when followed by a name or `>` where an expression
+// can start, since a less-than can't.
+static bool isJsxStart (State *state) {
+  char16_t ch = *(state->pos + 1);
+  if (!(ch == '>' || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '_' || ch == '$'))
+    return false;
+  char16_t lastToken = *state->lastTokenPos;
+  return !lastToken || (isExpressionPunctuator(lastToken) && lastToken != '.' &&
+      !(lastToken == '+' && beforeLastToken(state) == '+') && !(lastToken == '-' && beforeLastToken(state) == '-')) ||
+      (state->lastTokenPos > state->source && isExpressionKeyword(state, state->lastTokenPos));
+}
+
+// Skips the balanced `<...>` at state->pos to its closing `>`.
+static void skipAngleBrackets (State *state) {
+  uint32_t depth = 1;
+  while (depth && state->pos++ < state->end) {
+    if (*state->pos == '<')
+      depth++;
+    else if (*state->pos == '>' && *(state->pos - 1) != '=')
+      depth--;
+  }
+}
+
+// Lexes the JSX element or fragment at state->pos, unless it's the type
+// parameters of a generic arrow function, `<T,>() =>` or `<T extends U>() =>`,
+// which are skipped.
+static void jsxElement (State *state) {
+  const char16_t* pos = state->pos + 1;
+  while (isIdentifierChar(*pos))
+    pos++;
+  bool br;
+  pos = skipCommentWhitespace(pos, state->end, &br);
+  if (*pos == ',' || (*pos == 'e' && isWordAt(pos, &XTENDS[0], 6))) {
+    skipAngleBrackets(state);
+    if (state->pos > state->end)
+      syntaxError(state);
+    return;
+  }
+  jsx(state, true);
+}
+
+// Lexes JSX from state->pos, either in a tag or among an element's children,
+// until the outermost element closes or a `{` expression container opens. The
+// container is lexed by the main loop, which resumes here at its `}`. Open
+// elements are kept on the open token stack, so text and nesting needn't be
+// told apart from JS.
+static void jsx (State *state, bool inTag) {
+  while (state->pos++ < state->end) {
+    char16_t ch = *state->pos;
+    if (inTag) {
+      switch (ch) {
+        case '{':
+          state->openTokenStack[state->openTokenDepth].token = JsxAttributeBrace;
+          state->openTokenStack[state->openTokenDepth++].pos = state->pos;
+          return;
+        // attribute strings have no escapes
+        case '"':
+        case '\'':
+          while (state->pos < state->end && *++state->pos != ch);
+          break;
+        case '/':
+          if (*(state->pos + 1) == '*') {
+            blockComment(state, true);
+            break;
+          }
+          if (*(state->pos + 1) == '/') {
+            lineComment(state);
+            break;
+          }
+          // <a />
+          if (*(state->pos + 1) == '>') {
+            state->pos++;
+            if (state->openTokenDepth == 0 || state->openTokenStack[state->openTokenDepth - 1].token != JsxChildren)
+              return;
+            inTag = false;
+          }
+          break;
+        // <C<T>>
+        case '<':
+          skipAngleBrackets(state);
+          break;
+        case '>':
+          state->openTokenStack[state->openTokenDepth].token = JsxChildren;
+          state->openTokenStack[state->openTokenDepth++].pos = state->pos;
+          inTag = false;
+          break;
+      }
+      continue;
+    }
+#ifdef LEXER_SIMD
+    state->pos = skipToAny(state->pos, state->end, '<', '{', '<', '{');
+    ch = *state->pos;
+#endif
+    if (ch == '{') {
+      state->openTokenStack[state->openTokenDepth].token = JsxChildBrace;
+      state->openTokenStack[state->openTokenDepth++].pos = state->pos;
+      return;
+    }
+    if (ch != '<')
+      continue;
+    // </a>
+    if (*(state->pos + 1) == '/') {
+      while (state->pos < state->end && *++state->pos != '>');
+      if (*state->pos != '>' || state->openTokenDepth == 0 || state->openTokenStack[--state->openTokenDepth].token != JsxChildren)
+        break;
+      if (state->openTokenDepth == 0 || state->openTokenStack[state->openTokenDepth - 1].token != JsxChildren)
+        return;
+    }
+    // <a>
+    else {
+      inTag = true;
+    }
+  }
+  syntaxError(state);
+}
+
+static void blockComment (State *state, bool br) {
   state->pos++;
   while (state->pos++ < state->end) {
+#ifdef LEXER_SIMD
+    state->pos = skipToAny(state->pos, state->end, '*', '*', br ? '*' : '\n', br ? '*' : '\r');
+#endif
     char16_t ch = *state->pos;
     if (!br && isBr(ch))
       return;
@@ -767,16 +2139,22 @@ void blockComment (State *state, bool br) {
   }
 }
 
-void lineComment (State *state) {
+static void lineComment (State *state) {
   while (state->pos++ < state->end) {
+#ifdef LEXER_SIMD
+    state->pos = skipToAny(state->pos, state->end, '\n', '\n', '\r', '\r');
+#endif
     char16_t ch = *state->pos;
     if (ch == '\n' || ch == '\r')
       return;
   }
 }
 
-void stringLiteral (State *state, char16_t quote) {
+static void stringLiteral (State *state, char16_t quote) {
   while (state->pos++ < state->end) {
+#ifdef LEXER_SIMD
+    state->pos = skipToAny(state->pos, state->end, quote, '\\', '\n', '\r');
+#endif
     char16_t ch = *state->pos;
     if (ch == quote)
       return;
@@ -791,7 +2169,7 @@ void stringLiteral (State *state, char16_t quote) {
   syntaxError(state);
 }
 
-char16_t regexCharacterClass (State *state) {
+static char16_t regexCharacterClass (State *state) {
   while (state->pos++ < state->end) {
     char16_t ch = *state->pos;
     if (ch == ']')
@@ -805,7 +2183,7 @@ char16_t regexCharacterClass (State *state) {
   return '\0';
 }
 
-void regularExpression (State *state) {
+static void regularExpression (State *state) {
   while (state->pos++ < state->end) {
     char16_t ch = *state->pos;
     if (ch == '/')
@@ -820,53 +2198,192 @@ void regularExpression (State *state) {
   syntaxError(state);
 }
 
-char16_t readToWsOrPunctuator (State *state, char16_t ch) {
+static char16_t readToWsOrPunctuator (State *state, char16_t ch) {
+  // nothing to read at the terminator
+  if (state->pos > state->end)
+    return ch;
   do {
     if (isBrOrWs(ch) || isPunctuator(ch))
       return ch;
-  } while (ch = *(++state->pos));
+  } while ((ch = *(++state->pos)));
   return ch;
 }
 
+#ifdef LEXER_SIMD
+// Returns the first position from pos holding one of the given code units,
+// advancing only over whole vectors ending before the last code unit, so the
+// caller's scalar loop still handles the tail and the matched code unit.
+static char16_t* skipToAny (char16_t* pos, char16_t* end, char16_t c1, char16_t c2, char16_t c3, char16_t c4) {
+  vec_t v1 = vsplat(c1), v2 = vsplat(c2), v3 = vsplat(c3), v4 = vsplat(c4);
+  while (pos + VLANES <= end) {
+    vec_t v = vload(pos);
+    uint32_t mask = vmask(vor(vor(veq(v, v1), veq(v, v2)), vor(veq(v, v3), veq(v, v4))));
+    if (mask)
+      return pos + __builtin_ctz(mask);
+    pos += VLANES;
+  }
+  return pos;
+}
+
+// Structural prefilter for the main loop: skips whitespace and the code units
+// the main loop would only record as the last token, which is anything other
+// than (){}'"/` and the e, i, r and c keyword starts, plus m and O when
+// detecting CommonJS exports and < when lexing JSX. A keyword start directly
+// following an identifier character cannot start a keyword so is skipped too.
+static char16_t* skipInert (State *state, char16_t* pos) {
+  if (pos == state->source)
+    return pos;
+  // the module.exports and Object.defineProperty starts, only with CjsExports
+  vec_t cjsM = vsplat(state->options & CjsExports ? 'm' : 'e');
+  vec_t cjsO = vsplat(state->options & CjsExports ? 'O' : 'e');
+  // the < of JSX elements, only with Jsx
+  vec_t jsxLt = vsplat(state->options & Jsx ? '<' : '(');
+  // the aw of await, until a top-level await is found
+  vec_t tla = vsplat(state->result->meta.top_level_await ? 'e' : 'a');
+  // one lane short of the end, for the lookahead
+  while (pos + VLANES < state->end) {
+    vec_t v = vload(pos);
+    vec_t prev = vload(pos - 1);
+    vec_t await = vand(veq(v, tla), veq(vload(pos + 1), vsplat('w')));
+    vec_t structural = vor(vor(vor(veq(v, vsplat('(')), veq(v, vsplat(')'))), vor(veq(v, vsplat('{')), veq(v, vsplat('}')))),
+        vor(vor(veq(v, vsplat('\'')), veq(v, vsplat('"'))), vor(vor(veq(v, vsplat('/')), veq(v, vsplat('`'))), veq(v, jsxLt))));
+    vec_t keyword = vor(vor(vor(veq(v, vsplat('e')), veq(v, vsplat('i'))), vor(veq(v, vsplat('r')), veq(v, vsplat('c')))),
+        vor(vor(veq(v, cjsM), veq(v, cjsO)), await));
+    vec_t prevIdentifier = vor(vor(vrange(prev, 'a', 'z'), vrange(prev, 'A', 'Z')),
+        vor(vrange(prev, '0', '9'), vor(veq(prev, vsplat('_')), veq(prev, vsplat('$')))));
+    vec_t ws = vor(veq(v, vsplat(' ')), vrange(v, 9, 13));
+    uint32_t special = vmask(vor(structural, vandnot(keyword, prevIdentifier)));
+    uint32_t token = vmask(ws) ^ ((1u << VLANES) - 1);
+    if (special)
+      token &= (1u << __builtin_ctz(special)) - 1;
+    if (token)
+      state->lastTokenPos = pos + 31 - __builtin_clz(token);
+    if (special)
+      return pos + __builtin_ctz(special);
+    pos += VLANES;
+  }
+  return pos;
+}
+#endif
+
+// Collects the offset of the start of every line into an arena array, counting
+// first so it can be allocated exactly. Lines are split on \n only, matching
+// the line numbers of the JS parse errors.
+static uint32_t* collectLineStarts (const char16_t* source, const char16_t* end, Allocator alloc, void* user_data, uint32_t* count) {
+  uint32_t n = 1;
+  const char16_t* pos = source;
+#ifdef LEXER_SIMD
+  for (; pos + VLANES <= end; pos += VLANES)
+    n += __builtin_popcount(vmask(veq(vload(pos), vsplat('\n'))));
+#endif
+  for (; pos < end; pos++)
+    n += *pos == '\n';
+
+  uint32_t* lineStarts = alloc(n * sizeof(uint32_t), user_data);
+  uint32_t* out = lineStarts;
+  *out++ = 0;
+  pos = source;
+#ifdef LEXER_SIMD
+  for (; pos + VLANES <= end; pos += VLANES) {
+    uint32_t mask = vmask(veq(vload(pos), vsplat('\n')));
+    while (mask) {
+      *out++ = pos - source + __builtin_ctz(mask) + 1;
+      mask &= mask - 1;
+    }
+  }
+#endif
+  for (; pos < end; pos++) {
+    if (*pos == '\n')
+      *out++ = pos - source + 1;
+  }
+
+  *count = n;
+  return lineStarts;
+}
+
+// Whether the source contains import, export or require anywhere, including in
+// comments, strings and identifiers, which only costs a full parse. Searches
+// for the second and third code units of each (mp, xp, eq), as they're rarer
+// than the first, checking the whole word on a match.
+static bool hasModuleKeyword (const char16_t* source, const char16_t* end) {
+  const char16_t* pos = source + 1;
+#ifdef LEXER_SIMD
+  for (; pos + 1 + VLANES <= end; pos += VLANES) {
+    vec_t v = vload(pos);
+    vec_t next = vload(pos + 1);
+    uint32_t mask = vmask(vor(vand(vor(veq(v, vsplat('m')), veq(v, vsplat('x'))), veq(next, vsplat('p'))),
+        vand(veq(v, vsplat('e')), veq(next, vsplat('q')))));
+    while (mask) {
+      if (isModuleKeyword(pos + __builtin_ctz(mask), end))
+        return true;
+      mask &= mask - 1;
+    }
+  }
+#endif
+  for (; pos < end; pos++) {
+    if (isModuleKeyword(pos, end))
+      return true;
+  }
+  return false;
+}
+
+static bool isModuleKeyword (const char16_t* pos, const char16_t* end) {
+  switch (*(pos - 1)) {
+    case 'i':
+      return end - pos >= 5 && memcmp(pos, &MPORT[0], 5 * sizeof(char16_t)) == 0;
+    case 'e':
+      return end - pos >= 5 && memcmp(pos, &XPORT[0], 5 * sizeof(char16_t)) == 0;
+    case 'r':
+      return end - pos >= 6 && memcmp(pos, &EQUIRE[0], 6 * sizeof(char16_t)) == 0;
+  }
+  return false;
+}
+
 // Note: non-asii BR and whitespace checks omitted for perf / footprint
 // if there is a significant user need this can be reconsidered
-bool isBr (char16_t c) {
+static bool isBr (char16_t c) {
   return c == '\r' || c == '\n';
 }
 
-bool isWsNotBr (char16_t c) {
+static bool isWsNotBr (char16_t c) {
   return c == 9 || c == 11 || c == 12 || c == 32 || c == 160;
 }
 
-bool isBrOrWs (char16_t c) {
-  return c > 8 && c < 14 || c == 32 || c == 160;
+static bool isBrOrWs (char16_t c) {
+  return (c > 8 && c < 14) || c == 32 || c == 160;
 }
 
-bool isBrOrWsOrPunctuatorNotDot (char16_t c) {
-  return c > 8 && c < 14 || c == 32 || c == 160 || isPunctuator(c) && c != '.';
+static bool isBrOrWsOrPunctuatorNotDot (char16_t c) {
+  return (c > 8 && c < 14) || c == 32 || c == 160 || (isPunctuator(c) && c != '.');
 }
 
-bool isQuote (char16_t ch) {
+static bool isQuote (char16_t ch) {
   return ch == '\'' || ch == '"';
 }
 
-bool keywordStart (State *state) {
+static bool keywordStart (State *state) {
   return state->pos == state->source || isBrOrWsOrPunctuatorNotDot(*(state->pos - 1));
 }
 
-bool readPrecedingKeyword1 (State *state, char16_t* pos, char16_t c1) {
+// The code unit before the last token, which is zero for a token at the start
+// of the source.
+static char16_t beforeLastToken (State *state) {
+  return state->lastTokenPos == state->source ? 0 : *(state->lastTokenPos - 1);
+}
+
+static bool readPrecedingKeyword1 (State *state, char16_t* pos, char16_t c1) {
   if (pos < state->source) return false;
   return *pos == c1 && (pos == state->source || isBrOrWsOrPunctuatorNotDot(*(pos - 1)));
 }
 
-bool readPrecedingKeywordn (State *state, char16_t* pos, const char16_t* compare, size_t n) {
+static bool readPrecedingKeywordn (State *state, char16_t* pos, const char16_t* compare, size_t n) {
   if (pos - n + 1 < state->source) return false;
   return memcmp(pos - n + 1, compare, n * sizeof(char16_t)) == 0 && (pos - n + 1 == state->source || isBrOrWsOrPunctuatorNotDot(*(pos - n)));
 }
 
 // Detects one of case, debugger, delete, do, else, in, instanceof, new,
 //   return, throw, typeof, void, yield ,await
-bool isExpressionKeyword (State *state, char16_t* pos) {
+static bool isExpressionKeyword (State *state, char16_t* pos) {
   switch (*pos) {
     case 'd':
       switch (*(pos - 1)) {
@@ -944,28 +2461,59 @@ bool isExpressionKeyword (State *state, char16_t* pos) {
   return false;
 }
 
-bool isParenKeyword (State *state, char16_t* curPos) {
+static bool isParenKeyword (State *state, char16_t* curPos) {
   return readPrecedingKeywordn(state, curPos, &WHILE[0], 5) ||
       readPrecedingKeywordn(state, curPos, &FOR[0], 3) ||
       readPrecedingKeywordn(state, curPos, &IF[0], 2);
 }
 
-bool isPunctuator (char16_t ch) {
+// Detects a { opening a function body from the token before it, being an
+// arrow or the ) of a parameter list that isn't a statement head.
+static bool isFunctionBrace (State *state, char16_t* pos) {
+  if (*pos == '>')
+    return *(pos - 1) == '=';
+  if (*pos != ')')
+    return false;
+  // back to the matching (, then to the token before it
+  uint32_t nesting = 0;
+  while (pos-- > state->source) {
+    if (*pos == ')')
+      nesting++;
+    else if (*pos == '(' && nesting-- == 0)
+      break;
+  }
+  while (pos > state->source && isBrOrWs(*(pos - 1)))
+    pos--;
+  if (pos <= state->source)
+    return false;
+  char16_t* parenPos = pos - 1;
+  switch (*parenPos) {
+    case 'h':
+      return !readPrecedingKeywordn(state, parenPos - 1, &CATC[0], 4) && !readPrecedingKeywordn(state, parenPos - 1, &SWITC[0], 5) &&
+          !readPrecedingKeywordn(state, parenPos - 1, &WIT[0], 3);
+    case 't':
+      // for await
+      return !readPrecedingKeywordn(state, parenPos - 1, &AWAI[0], 4);
+  }
+  return !isParenKeyword(state, parenPos);
+}
+
+static bool isPunctuator (char16_t ch) {
   // 23 possible punctuator endings: !%&()*+,-./:;<=>?[]^{}|~
   return ch == '!' || ch == '%' || ch == '&' ||
-    ch > 39 && ch < 48 || ch > 57 && ch < 64 ||
+    (ch > 39 && ch < 48) || (ch > 57 && ch < 64) ||
     ch == '[' || ch == ']' || ch == '^' ||
-    ch > 122 && ch < 127;
+    (ch > 122 && ch < 127);
 }
 
-bool isExpressionPunctuator (char16_t ch) {
+static bool isExpressionPunctuator (char16_t ch) {
   // 20 possible expression endings: !%&(*+,-.:;<=>?[^{|~
   return ch == '!' || ch == '%' || ch == '&' ||
-    ch > 39 && ch < 47 && ch != 41 || ch > 57 && ch < 64 ||
-    ch == '[' || ch == '^' || ch > 122 && ch < 127 && ch != '}';
+    (ch > 39 && ch < 47 && ch != 41) || (ch > 57 && ch < 64) ||
+    ch == '[' || ch == '^' || (ch > 122 && ch < 127 && ch != '}');
 }
 
-bool isBreakOrContinue (State *state, char16_t* curPos) {
+static bool isBreakOrContinue (State *state, char16_t* curPos) {
   switch (*curPos) {
     case 'k':
       return readPrecedingKeywordn(state, curPos - 1, &BREA[0], 4);
@@ -976,7 +2524,7 @@ bool isBreakOrContinue (State *state, char16_t* curPos) {
   return false;
 }
 
-bool isExpressionTerminator (State *state, char16_t* curPos) {
+static bool isExpressionTerminator (State *state, char16_t* curPos) {
   // detects:
   // => ; ) finally catch else class X
   // as all of these followed by a { will indicate a statement brace
@@ -996,6 +2544,21 @@ bool isExpressionTerminator (State *state, char16_t* curPos) {
   return false;
 }
 
+// With the Typescript option, whether the `!` at pos is a non-null assertion,
+// which follows an expression, rather than a logical not.
+static bool isNonNullAssertion (State *state, char16_t* pos) {
+  if (pos == state->source)
+    return false;
+  char16_t ch = *(pos - 1);
+  return ch == ')' || ch == ']' || (isIdentifierChar(ch) && !(pos - 1 > state->source && isExpressionKeyword(state, pos - 1)));
+}
+
+// Whether the word at pos continues with the n code units of compare and then
+// ends, rather than running on into an identifier.
+static bool isWordAt (const char16_t* pos, const char16_t* compare, size_t n) {
+  return memcmp(pos + 1, compare, n * sizeof(char16_t)) == 0 && !isIdentifierChar(*(pos + n + 1));
+}
+
 // Identifier detection, ported from Acorn
 // ## Character categories
 
@@ -1005,14 +2568,14 @@ bool isExpressionTerminator (State *state, char16_t* curPos) {
 // code point above 128.
 // Generated by `bin/generate-identifier-regex.js`.
 
-bool isNonASCIIidentifierStartChar (uint32_t ch) {
-  return ch == 0xaa || ch == 0xb5 || ch == 0xba || ch >= 0xc0 && ch <= 0xd6 || ch >= 0xd8 && ch <= 0xf6 || ch >= 0xf8 && ch <= 0x02c1 ||
-      ch >= 0x02c6 && ch <= 0x02d1 || ch >= 0x02e0 && ch <= 0x02e4 || ch == 0x02ec || ch == 0x02ee || ch >= 0x0370 && ch <= 0x0374 || ch == 0x0376 || ch == 0x0377 || ch >= 0x037a && ch <= 0x037d || ch == 0x037f || ch == 0x0386 || ch >= 0x0388 && ch <= 0x038a || ch == 0x038c || ch >= 0x038e && ch <= 0x03a1 || ch >= 0x03a3 && ch <= 0x03f5 || ch >= 0x03f7 && ch <= 0x0481 || ch >= 0x048a && ch <= 0x052f || ch >= 0x0531 && ch <= 0x0556 || ch == 0x0559 || ch >= 0x0560 && ch <= 0x0588 || ch >= 0x05d0 && ch <= 0x05ea || ch >= 0x05ef && ch <= 0x05f2 || ch >= 0x0620 && ch <= 0x064a || ch == 0x066e || ch == 0x066f || ch >= 0x0671 && ch <= 0x06d3 || ch == 0x06d5 || ch == 0x06e5 || ch == 0x06e6 || ch == 0x06ee || ch == 0x06ef || ch >= 0x06fa && ch <= 0x06fc || ch == 0x06ff || ch == 0x0710 || ch >= 0x0712 && ch <= 0x072f || ch >= 0x074d && ch <= 0x07a5 || ch == 0x07b1 || ch >= 0x07ca && ch <= 0x07ea || ch == 0x07f4 || ch == 0x07f5 || ch == 0x07fa || ch >= 0x0800 && ch <= 0x0815 || ch == 0x081a || ch == 0x0824 || ch == 0x0828 || ch >= 0x0840 && ch <= 0x0858 || ch >= 0x0860 && ch <= 0x086a || ch >= 0x08a0 && ch <= 0x08b4 || ch >= 0x08b6 && ch <= 0x08bd || ch >= 0x0904 && ch <= 0x0939 || ch == 0x093d || ch == 0x0950 || ch >= 0x0958 && ch <= 0x0961 || ch >= 0x0971 && ch <= 0x0980 || ch >= 0x0985 && ch <= 0x098c || ch == 0x098f || ch == 0x0990 || ch >= 0x0993 && ch <= 0x09a8 || ch >= 0x09aa && ch <= 0x09b0 || ch == 0x09b2 || ch >= 0x09b6 && ch <= 0x09b9 || ch == 0x09bd || ch == 0x09ce || ch == 0x09dc || ch == 0x09dd || ch >= 0x09df && ch <= 0x09e1 || ch == 0x09f0 || ch == 0x09f1 || ch == 0x09fc || ch >= 0x0a05 && ch <= 0x0a0a || ch == 0x0a0f || ch == 0x0a10 || ch >= 0x0a13 && ch <= 0x0a28 || ch >= 0x0a2a && ch <= 0x0a30 || ch == 0x0a32 || ch == 0x0a33 || ch == 0x0a35 || ch == 0x0a36 || ch == 0x0a38 || ch == 0x0a39 || ch >= 0x0a59 && ch <= 0x0a5c || ch == 0x0a5e || ch >= 0x0a72 && ch <= 0x0a74 || ch >= 0x0a85 && ch <= 0x0a8d || ch >= 0x0a8f && ch <= 0x0a91 || ch >= 0x0a93 && ch <= 0x0aa8 || ch >= 0x0aaa && ch <= 0x0ab0 || ch == 0x0ab2 || ch == 0x0ab3 || ch >= 0x0ab5 && ch <= 0x0ab9 || ch == 0x0abd || ch == 0x0ad0 || ch == 0x0ae0 || ch == 0x0ae1 || ch == 0x0af9 || ch >= 0x0b05 && ch <= 0x0b0c || ch == 0x0b0f || ch == 0x0b10 || ch >= 0x0b13 && ch <= 0x0b28 || ch >= 0x0b2a && ch <= 0x0b30 || ch == 0x0b32 || ch == 0x0b33 || ch >= 0x0b35 && ch <= 0x0b39 || ch == 0x0b3d || ch == 0x0b5c || ch == 0x0b5d || ch >= 0x0b5f && ch <= 0x0b61 || ch == 0x0b71 || ch == 0x0b83 || ch >= 0x0b85 && ch <= 0x0b8a || ch >= 0x0b8e && ch <= 0x0b90 || ch >= 0x0b92 && ch <= 0x0b95 || ch == 0x0b99 || ch == 0x0b9a || ch == 0x0b9c || ch == 0x0b9e || ch == 0x0b9f || ch == 0x0ba3 || ch == 0x0ba4 || ch >= 0x0ba8 && ch <= 0x0baa || ch >= 0x0bae && ch <= 0x0bb9 || ch == 0x0bd0 || ch >= 0x0c05 && ch <= 0x0c0c || ch >= 0x0c0e && ch <= 0x0c10 || ch >= 0x0c12 && ch <= 0x0c28 || ch >= 0x0c2a && ch <= 0x0c39 || ch == 0x0c3d || ch >= 0x0c58 && ch <= 0x0c5a || ch == 0x0c60 || ch == 0x0c61 || ch == 0x0c80 || ch >= 0x0c85 && ch <= 0x0c8c || ch >= 0x0c8e && ch <= 0x0c90 || ch >= 0x0c92 && ch <= 0x0ca8 || ch >= 0x0caa && ch <= 0x0cb3 || ch >= 0x0cb5 && ch <= 0x0cb9 || ch == 0x0cbd || ch == 0x0cde || ch == 0x0ce0 || ch == 0x0ce1 || ch == 0x0cf1 || ch == 0x0cf2 || ch >= 0x0d05 && ch <= 0x0d0c || ch >= 0x0d0e && ch <= 0x0d10 || ch >= 0x0d12 && ch <= 0x0d3a || ch == 0x0d3d || ch == 0x0d4e || ch >= 0x0d54 && ch <= 0x0d56 || ch >= 0x0d5f && ch <= 0x0d61 || ch >= 0x0d7a && ch <= 0x0d7f || ch >= 0x0d85 && ch <= 0x0d96 || ch >= 0x0d9a && ch <= 0x0db1 || ch >= 0x0db3 && ch <= 0x0dbb || ch == 0x0dbd || ch >= 0x0dc0 && ch <= 0x0dc6 || ch >= 0x0e01 && ch <= 0x0e30 || ch == 0x0e32 || ch == 0x0e33 || ch >= 0x0e40 && ch <= 0x0e46 || ch == 0x0e81 || ch == 0x0e82 || ch == 0x0e84 || ch == 0x0e87 || ch == 0x0e88 || ch == 0x0e8a || ch == 0x0e8d || ch >= 0x0e94 && ch <= 0x0e97 || ch >= 0x0e99 && ch <= 0x0e9f || ch >= 0x0ea1 && ch <= 0x0ea3 || ch == 0x0ea5 || ch == 0x0ea7 || ch == 0x0eaa || ch == 0x0eab || ch >= 0x0ead && ch <= 0x0eb0 || ch == 0x0eb2 || ch == 0x0eb3 || ch == 0x0ebd || ch >= 0x0ec0 && ch <= 0x0ec4 || ch == 0x0ec6 || ch >= 0x0edc && ch <= 0x0edf || ch == 0x0f00 || ch >= 0x0f40 && ch <= 0x0f47 || ch >= 0x0f49 && ch <= 0x0f6c || ch >= 0x0f88 && ch <= 0x0f8c || ch >= 0x1000 && ch <= 0x102a || ch == 0x103f || ch >= 0x1050 && ch <= 0x1055 || ch >= 0x105a && ch <= 0x105d || ch == 0x1061 || ch == 0x1065 || ch == 0x1066 || ch >= 0x106e && ch <= 0x1070 || ch >= 0x1075 && ch <= 0x1081 || ch == 0x108e || ch >= 0x10a0 && ch <= 0x10c5 || ch == 0x10c7 || ch == 0x10cd || ch >= 0x10d0 && ch <= 0x10fa || ch >= 0x10fc && ch <= 0x1248 || ch >= 0x124a && ch <= 0x124d || ch >= 0x1250 && ch <= 0x1256 || ch == 0x1258 || ch >= 0x125a && ch <= 0x125d || ch >= 0x1260 && ch <= 0x1288 || ch >= 0x128a && ch <= 0x128d || ch >= 0x1290 && ch <= 0x12b0 || ch >= 0x12b2 && ch <= 0x12b5 || ch >= 0x12b8 && ch <= 0x12be || ch == 0x12c0 || ch >= 0x12c2 && ch <= 0x12c5 || ch >= 0x12c8 && ch <= 0x12d6 || ch >= 0x12d8 && ch <= 0x1310 || ch >= 0x1312 && ch <= 0x1315 || ch >= 0x1318 && ch <= 0x135a || ch >= 0x1380 && ch <= 0x138f || ch >= 0x13a0 && ch <= 0x13f5 || ch >= 0x13f8 && ch <= 0x13fd || ch >= 0x1401 && ch <= 0x166c || ch >= 0x166f && ch <= 0x167f || ch >= 0x1681 && ch <= 0x169a || ch >= 0x16a0 && ch <= 0x16ea || ch >= 0x16ee && ch <= 0x16f8 || ch >= 0x1700 && ch <= 0x170c || ch >= 0x170e && ch <= 0x1711 || ch >= 0x1720 && ch <= 0x1731 || ch >= 0x1740 && ch <= 0x1751 || ch >= 0x1760 && ch <= 0x176c || ch >= 0x176e && ch <= 0x1770 || ch >= 0x1780 && ch <= 0x17b3 || ch == 0x17d7 || ch == 0x17dc || ch >= 0x1820 && ch <= 0x1878 || ch >= 0x1880 && ch <= 0x18a8 || ch == 0x18aa || ch >= 0x18b0 && ch <= 0x18f5 || ch >= 0x1900 && ch <= 0x191e || ch >= 0x1950 && ch <= 0x196d || ch >= 0x1970 && ch <= 0x1974 || ch >= 0x1980 && ch <= 0x19ab || ch >= 0x19b0 && ch <= 0x19c9 || ch >= 0x1a00 && ch <= 0x1a16 || ch >= 0x1a20 && ch <= 0x1a54 || ch == 0x1aa7 || ch >= 0x1b05 && ch <= 0x1b33 || ch >= 0x1b45 && ch <= 0x1b4b || ch >= 0x1b83 && ch <= 0x1ba0 || ch == 0x1bae || ch == 0x1baf || ch >= 0x1bba && ch <= 0x1be5 || ch >= 0x1c00 && ch <= 0x1c23 || ch >= 0x1c4d && ch <= 0x1c4f || ch >= 0x1c5a && ch <= 0x1c7d || ch >= 0x1c80 && ch <= 0x1c88 || ch >= 0x1c90 && ch <= 0x1cba || ch >= 0x1cbd && ch <= 0x1cbf || ch >= 0x1ce9 && ch <= 0x1cec || ch >= 0x1cee && ch <= 0x1cf1 || ch == 0x1cf5 || ch == 0x1cf6 || ch >= 0x1d00 && ch <= 0x1dbf || ch >= 0x1e00 && ch <= 0x1f15 || ch >= 0x1f18 && ch <= 0x1f1d || ch >= 0x1f20 && ch <= 0x1f45 || ch >= 0x1f48 && ch <= 0x1f4d || ch >= 0x1f50 && ch <= 0x1f57 || ch == 0x1f59 || ch == 0x1f5b || ch == 0x1f5d || ch >= 0x1f5f && ch <= 0x1f7d || ch >= 0x1f80 && ch <= 0x1fb4 || ch >= 0x1fb6 && ch <= 0x1fbc || ch == 0x1fbe || ch >= 0x1fc2 && ch <= 0x1fc4 || ch >= 0x1fc6 && ch <= 0x1fcc || ch >= 0x1fd0 && ch <= 0x1fd3 || ch >= 0x1fd6 && ch <= 0x1fdb || ch >= 0x1fe0 && ch <= 0x1fec || ch >= 0x1ff2 && ch <= 0x1ff4 || ch >= 0x1ff6 && ch <= 0x1ffc || ch == 0x2071 || ch == 0x207f || ch >= 0x2090 && ch <= 0x209c || ch == 0x2102 || ch == 0x2107 || ch >= 0x210a && ch <= 0x2113 || ch == 0x2115 || ch >= 0x2118 && ch <= 0x211d || ch == 0x2124 || ch == 0x2126 || ch == 0x2128 || ch >= 0x212a && ch <= 0x2139 || ch >= 0x213c && ch <= 0x213f || ch >= 0x2145 && ch <= 0x2149 || ch == 0x214e || ch >= 0x2160 && ch <= 0x2188 || ch >= 0x2c00 && ch <= 0x2c2e || ch >= 0x2c30 && ch <= 0x2c5e || ch >= 0x2c60 && ch <= 0x2ce4 || ch >= 0x2ceb && ch <= 0x2cee || ch == 0x2cf2 || ch == 0x2cf3 || ch >= 0x2d00 && ch <= 0x2d25 || ch == 0x2d27 || ch == 0x2d2d || ch >= 0x2d30 && ch <= 0x2d67 || ch == 0x2d6f || ch >= 0x2d80 && ch <= 0x2d96 || ch >= 0x2da0 && ch <= 0x2da6 || ch >= 0x2da8 && ch <= 0x2dae || ch >= 0x2db0 && ch <= 0x2db6 || ch >= 0x2db8 && ch <= 0x2dbe || ch >= 0x2dc0 && ch <= 0x2dc6 || ch >= 0x2dc8 && ch <= 0x2dce || ch >= 0x2dd0 && ch <= 0x2dd6 || ch >= 0x2dd8 && ch <= 0x2dde || ch >= 0x3005 && ch <= 0x3007 || ch >= 0x3021 && ch <= 0x3029 || ch >= 0x3031 && ch <= 0x3035 || ch >= 0x3038 && ch <= 0x303c || ch >= 0x3041 && ch <= 0x3096 || ch >= 0x309b && ch <= 0x309f || ch >= 0x30a1 && ch <= 0x30fa || ch >= 0x30fc && ch <= 0x30ff || ch >= 0x3105 && ch <= 0x312f || ch >= 0x3131 && ch <= 0x318e || ch >= 0x31a0 && ch <= 0x31ba || ch >= 0x31f0 && ch <= 0x31ff || ch >= 0x3400 && ch <= 0x4db5 || ch >= 0x4e00 && ch <= 0x9fef || ch >= 0xa000 && ch <= 0xa48c || ch >= 0xa4d0 && ch <= 0xa4fd || ch >= 0xa500 && ch <= 0xa60c || ch >= 0xa610 && ch <= 0xa61f || ch == 0xa62a || ch == 0xa62b || ch >= 0xa640 && ch <= 0xa66e || ch >= 0xa67f && ch <= 0xa69d || ch >= 0xa6a0 && ch <= 0xa6ef || ch >= 0xa717 && ch <= 0xa71f || ch >= 0xa722 && ch <= 0xa788 || ch >= 0xa78b && ch <= 0xa7b9 || ch >= 0xa7f7 && ch <= 0xa801 || ch >= 0xa803 && ch <= 0xa805 || ch >= 0xa807 && ch <= 0xa80a || ch >= 0xa80c && ch <= 0xa822 || ch >= 0xa840 && ch <= 0xa873 || ch >= 0xa882 && ch <= 0xa8b3 || ch >= 0xa8f2 && ch <= 0xa8f7 || ch == 0xa8fb || ch == 0xa8fd || ch == 0xa8fe || ch >= 0xa90a && ch <= 0xa925 || ch >= 0xa930 && ch <= 0xa946 || ch >= 0xa960 && ch <= 0xa97c || ch >= 0xa984 && ch <= 0xa9b2 || ch == 0xa9cf || ch >= 0xa9e0 && ch <= 0xa9e4 || ch >= 0xa9e6 && ch <= 0xa9ef || ch >= 0xa9fa && ch <= 0xa9fe || ch >= 0xaa00 && ch <= 0xaa28 || ch >= 0xaa40 && ch <= 0xaa42 || ch >= 0xaa44 && ch <= 0xaa4b || ch >= 0xaa60 && ch <= 0xaa76 || ch == 0xaa7a || ch >= 0xaa7e && ch <= 0xaaaf || ch == 0xaab1 || ch == 0xaab5 || ch == 0xaab6 || ch >= 0xaab9 && ch <= 0xaabd || ch == 0xaac0 || ch == 0xaac2 || ch >= 0xaadb && ch <= 0xaadd || ch >= 0xaae0 && ch <= 0xaaea || ch >= 0xaaf2 && ch <= 0xaaf4 || ch >= 0xab01 && ch <= 0xab06 || ch >= 0xab09 && ch <= 0xab0e || ch >= 0xab11 && ch <= 0xab16 || ch >= 0xab20 && ch <= 0xab26 || ch >= 0xab28 && ch <= 0xab2e ||
-      ch >= 0xab30 && ch <= 0xab5a || ch >= 0xab5c && ch <= 0xab65 || ch >= 0xab70 && ch <= 0xabe2 || ch >= 0xac00 && ch <= 0xd7a3 || ch >= 0xd7b0 && ch <= 0xd7c6 || ch >= 0xd7cb && ch <= 0xd7fb || ch >= 0xf900 && ch <= 0xfa6d || ch >= 0xfa70 && ch <= 0xfad9 || ch >= 0xfb00 && ch <= 0xfb06 || ch >= 0xfb13 && ch <= 0xfb17 || ch == 0xfb1d || ch >= 0xfb1f && ch <= 0xfb28 || ch >= 0xfb2a && ch <= 0xfb36 || ch >= 0xfb38 && ch <= 0xfb3c || ch == 0xfb3e || ch == 0xfb40 || ch == 0xfb41 || ch == 0xfb43 || ch == 0xfb44 || ch >= 0xfb46 && ch <= 0xfbb1 || ch >= 0xfbd3 && ch <= 0xfd3d || ch >= 0xfd50 && ch <= 0xfd8f || ch >= 0xfd92 && ch <= 0xfdc7 || ch >= 0xfdf0 && ch <= 0xfdfb || ch >= 0xfe70 && ch <= 0xfe74 || ch >= 0xfe76 && ch <= 0xfefc || ch >= 0xff21 && ch <= 0xff3a || ch >= 0xff41 && ch <= 0xff5a || ch >= 0xff66 && ch <= 0xffbe || ch >= 0xffc2 && ch <= 0xffc7 || ch >= 0xffca && ch <= 0xffcf || ch >= 0xffd2 && ch <= 0xffd7 || ch >= 0xffda && ch <= 0xffdc;
+static bool isNonASCIIidentifierStartChar (uint32_t ch) {
+  return ch == 0xaa || ch == 0xb5 || ch == 0xba || (ch >= 0xc0 && ch <= 0xd6) || (ch >= 0xd8 && ch <= 0xf6) || (ch >= 0xf8 && ch <= 0x02c1) ||
+      (ch >= 0x02c6 && ch <= 0x02d1) || (ch >= 0x02e0 && ch <= 0x02e4) || ch == 0x02ec || ch == 0x02ee || (ch >= 0x0370 && ch <= 0x0374) || ch == 0x0376 || ch == 0x0377 || (ch >= 0x037a && ch <= 0x037d) || ch == 0x037f || ch == 0x0386 || (ch >= 0x0388 && ch <= 0x038a) || ch == 0x038c || (ch >= 0x038e && ch <= 0x03a1) || (ch >= 0x03a3 && ch <= 0x03f5) || (ch >= 0x03f7 && ch <= 0x0481) || (ch >= 0x048a && ch <= 0x052f) || (ch >= 0x0531 && ch <= 0x0556) || ch == 0x0559 || (ch >= 0x0560 && ch <= 0x0588) || (ch >= 0x05d0 && ch <= 0x05ea) || (ch >= 0x05ef && ch <= 0x05f2) || (ch >= 0x0620 && ch <= 0x064a) || ch == 0x066e || ch == 0x066f || (ch >= 0x0671 && ch <= 0x06d3) || ch == 0x06d5 || ch == 0x06e5 || ch == 0x06e6 || ch == 0x06ee || ch == 0x06ef || (ch >= 0x06fa && ch <= 0x06fc) || ch == 0x06ff || ch == 0x0710 || (ch >= 0x0712 && ch <= 0x072f) || (ch >= 0x074d && ch <= 0x07a5) || ch == 0x07b1 || (ch >= 0x07ca && ch <= 0x07ea) || ch == 0x07f4 || ch == 0x07f5 || ch == 0x07fa || (ch >= 0x0800 && ch <= 0x0815) || ch == 0x081a || ch == 0x0824 || ch == 0x0828 || (ch >= 0x0840 && ch <= 0x0858) || (ch >= 0x0860 && ch <= 0x086a) || (ch >= 0x08a0 && ch <= 0x08b4) || (ch >= 0x08b6 && ch <= 0x08bd) || (ch >= 0x0904 && ch <= 0x0939) || ch == 0x093d || ch == 0x0950 || (ch >= 0x0958 && ch <= 0x0961) || (ch >= 0x0971 && ch <= 0x0980) || (ch >= 0x0985 && ch <= 0x098c) || ch == 0x098f || ch == 0x0990 || (ch >= 0x0993 && ch <= 0x09a8) || (ch >= 0x09aa && ch <= 0x09b0) || ch == 0x09b2 || (ch >= 0x09b6 && ch <= 0x09b9) || ch == 0x09bd || ch == 0x09ce || ch == 0x09dc || ch == 0x09dd || (ch >= 0x09df && ch <= 0x09e1) || ch == 0x09f0 || ch == 0x09f1 || ch == 0x09fc || (ch >= 0x0a05 && ch <= 0x0a0a) || ch == 0x0a0f || ch == 0x0a10 || (ch >= 0x0a13 && ch <= 0x0a28) || (ch >= 0x0a2a && ch <= 0x0a30) || ch == 0x0a32 || ch == 0x0a33 || ch == 0x0a35 || ch == 0x0a36 || ch == 0x0a38 || ch == 0x0a39 || (ch >= 0x0a59 && ch <= 0x0a5c) || ch == 0x0a5e || (ch >= 0x0a72 && ch <= 0x0a74) || (ch >= 0x0a85 && ch <= 0x0a8d) || (ch >= 0x0a8f && ch <= 0x0a91) || (ch >= 0x0a93 && ch <= 0x0aa8) || (ch >= 0x0aaa && ch <= 0x0ab0) || ch == 0x0ab2 || ch == 0x0ab3 || (ch >= 0x0ab5 && ch <= 0x0ab9) || ch == 0x0abd || ch == 0x0ad0 || ch == 0x0ae0 || ch == 0x0ae1 || ch == 0x0af9 || (ch >= 0x0b05 && ch <= 0x0b0c) || ch == 0x0b0f || ch == 0x0b10 || (ch >= 0x0b13 && ch <= 0x0b28) || (ch >= 0x0b2a && ch <= 0x0b30) || ch == 0x0b32 || ch == 0x0b33 || (ch >= 0x0b35 && ch <= 0x0b39) || ch == 0x0b3d || ch == 0x0b5c || ch == 0x0b5d || (ch >= 0x0b5f && ch <= 0x0b61) || ch == 0x0b71 || ch == 0x0b83 || (ch >= 0x0b85 && ch <= 0x0b8a) || (ch >= 0x0b8e && ch <= 0x0b90) || (ch >= 0x0b92 && ch <= 0x0b95) || ch == 0x0b99 || ch == 0x0b9a || ch == 0x0b9c || ch == 0x0b9e || ch == 0x0b9f || ch == 0x0ba3 || ch == 0x0ba4 || (ch >= 0x0ba8 && ch <= 0x0baa) || (ch >= 0x0bae && ch <= 0x0bb9) || ch == 0x0bd0 || (ch >= 0x0c05 && ch <= 0x0c0c) || (ch >= 0x0c0e && ch <= 0x0c10) || (ch >= 0x0c12 && ch <= 0x0c28) || (ch >= 0x0c2a && ch <= 0x0c39) || ch == 0x0c3d || (ch >= 0x0c58 && ch <= 0x0c5a) || ch == 0x0c60 || ch == 0x0c61 || ch == 0x0c80 || (ch >= 0x0c85 && ch <= 0x0c8c) || (ch >= 0x0c8e && ch <= 0x0c90) || (ch >= 0x0c92 && ch <= 0x0ca8) || (ch >= 0x0caa && ch <= 0x0cb3) || (ch >= 0x0cb5 && ch <= 0x0cb9) || ch == 0x0cbd || ch == 0x0cde || ch == 0x0ce0 || ch == 0x0ce1 || ch == 0x0cf1 || ch == 0x0cf2 || (ch >= 0x0d05 && ch <= 0x0d0c) || (ch >= 0x0d0e && ch <= 0x0d10) || (ch >= 0x0d12 && ch <= 0x0d3a) || ch == 0x0d3d || ch == 0x0d4e || (ch >= 0x0d54 && ch <= 0x0d56) || (ch >= 0x0d5f && ch <= 0x0d61) || (ch >= 0x0d7a && ch <= 0x0d7f) || (ch >= 0x0d85 && ch <= 0x0d96) || (ch >= 0x0d9a && ch <= 0x0db1) || (ch >= 0x0db3 && ch <= 0x0dbb) || ch == 0x0dbd || (ch >= 0x0dc0 && ch <= 0x0dc6) || (ch >= 0x0e01 && ch <= 0x0e30) || ch == 0x0e32 || ch == 0x0e33 || (ch >= 0x0e40 && ch <= 0x0e46) || ch == 0x0e81 || ch == 0x0e82 || ch == 0x0e84 || ch == 0x0e87 || ch == 0x0e88 || ch == 0x0e8a || ch == 0x0e8d || (ch >= 0x0e94 && ch <= 0x0e97) || (ch >= 0x0e99 && ch <= 0x0e9f) || (ch >= 0x0ea1 && ch <= 0x0ea3) || ch == 0x0ea5 || ch == 0x0ea7 || ch == 0x0eaa || ch == 0x0eab || (ch >= 0x0ead && ch <= 0x0eb0) || ch == 0x0eb2 || ch == 0x0eb3 || ch == 0x0ebd || (ch >= 0x0ec0 && ch <= 0x0ec4) || ch == 0x0ec6 || (ch >= 0x0edc && ch <= 0x0edf) || ch == 0x0f00 || (ch >= 0x0f40 && ch <= 0x0f47) || (ch >= 0x0f49 && ch <= 0x0f6c) || (ch >= 0x0f88 && ch <= 0x0f8c) || (ch >= 0x1000 && ch <= 0x102a) || ch == 0x103f || (ch >= 0x1050 && ch <= 0x1055) || (ch >= 0x105a && ch <= 0x105d) || ch == 0x1061 || ch == 0x1065 || ch == 0x1066 || (ch >= 0x106e && ch <= 0x1070) || (ch >= 0x1075 && ch <= 0x1081) || ch == 0x108e || (ch >= 0x10a0 && ch <= 0x10c5) || ch == 0x10c7 || ch == 0x10cd || (ch >= 0x10d0 && ch <= 0x10fa) || (ch >= 0x10fc && ch <= 0x1248) || (ch >= 0x124a && ch <= 0x124d) || (ch >= 0x1250 && ch <= 0x1256) || ch == 0x1258 || (ch >= 0x125a && ch <= 0x125d) || (ch >= 0x1260 && ch <= 0x1288) || (ch >= 0x128a && ch <= 0x128d) || (ch >= 0x1290 && ch <= 0x12b0) || (ch >= 0x12b2 && ch <= 0x12b5) || (ch >= 0x12b8 && ch <= 0x12be) || ch == 0x12c0 || (ch >= 0x12c2 && ch <= 0x12c5) || (ch >= 0x12c8 && ch <= 0x12d6) || (ch >= 0x12d8 && ch <= 0x1310) || (ch >= 0x1312 && ch <= 0x1315) || (ch >= 0x1318 && ch <= 0x135a) || (ch >= 0x1380 && ch <= 0x138f) || (ch >= 0x13a0 && ch <= 0x13f5) || (ch >= 0x13f8 && ch <= 0x13fd) || (ch >= 0x1401 && ch <= 0x166c) || (ch >= 0x166f && ch <= 0x167f) || (ch >= 0x1681 && ch <= 0x169a) || (ch >= 0x16a0 && ch <= 0x16ea) || (ch >= 0x16ee && ch <= 0x16f8) || (ch >= 0x1700 && ch <= 0x170c) || (ch >= 0x170e && ch <= 0x1711) || (ch >= 0x1720 && ch <= 0x1731) || (ch >= 0x1740 && ch <= 0x1751) || (ch >= 0x1760 && ch <= 0x176c) || (ch >= 0x176e && ch <= 0x1770) || (ch >= 0x1780 && ch <= 0x17b3) || ch == 0x17d7 || ch == 0x17dc || (ch >= 0x1820 && ch <= 0x1878) || (ch >= 0x1880 && ch <= 0x18a8) || ch == 0x18aa || (ch >= 0x18b0 && ch <= 0x18f5) || (ch >= 0x1900 && ch <= 0x191e) || (ch >= 0x1950 && ch <= 0x196d) || (ch >= 0x1970 && ch <= 0x1974) || (ch >= 0x1980 && ch <= 0x19ab) || (ch >= 0x19b0 && ch <= 0x19c9) || (ch >= 0x1a00 && ch <= 0x1a16) || (ch >= 0x1a20 && ch <= 0x1a54) || ch == 0x1aa7 || (ch >= 0x1b05 && ch <= 0x1b33) || (ch >= 0x1b45 && ch <= 0x1b4b) || (ch >= 0x1b83 && ch <= 0x1ba0) || ch == 0x1bae || ch == 0x1baf || (ch >= 0x1bba && ch <= 0x1be5) || (ch >= 0x1c00 && ch <= 0x1c23) || (ch >= 0x1c4d && ch <= 0x1c4f) || (ch >= 0x1c5a && ch <= 0x1c7d) || (ch >= 0x1c80 && ch <= 0x1c88) || (ch >= 0x1c90 && ch <= 0x1cba) || (ch >= 0x1cbd && ch <= 0x1cbf) || (ch >= 0x1ce9 && ch <= 0x1cec) || (ch >= 0x1cee && ch <= 0x1cf1) || ch == 0x1cf5 || ch == 0x1cf6 || (ch >= 0x1d00 && ch <= 0x1dbf) || (ch >= 0x1e00 && ch <= 0x1f15) || (ch >= 0x1f18 && ch <= 0x1f1d) || (ch >= 0x1f20 && ch <= 0x1f45) || (ch >= 0x1f48 && ch <= 0x1f4d) || (ch >= 0x1f50 && ch <= 0x1f57) || ch == 0x1f59 || ch == 0x1f5b || ch == 0x1f5d || (ch >= 0x1f5f && ch <= 0x1f7d) || (ch >= 0x1f80 && ch <= 0x1fb4) || (ch >= 0x1fb6 && ch <= 0x1fbc) || ch == 0x1fbe || (ch >= 0x1fc2 && ch <= 0x1fc4) || (ch >= 0x1fc6 && ch <= 0x1fcc) || (ch >= 0x1fd0 && ch <= 0x1fd3) || (ch >= 0x1fd6 && ch <= 0x1fdb) || (ch >= 0x1fe0 && ch <= 0x1fec) || (ch >= 0x1ff2 && ch <= 0x1ff4) || (ch >= 0x1ff6 && ch <= 0x1ffc) || ch == 0x2071 || ch == 0x207f || (ch >= 0x2090 && ch <= 0x209c) || ch == 0x2102 || ch == 0x2107 || (ch >= 0x210a && ch <= 0x2113) || ch == 0x2115 || (ch >= 0x2118 && ch <= 0x211d) || ch == 0x2124 || ch == 0x2126 || ch == 0x2128 || (ch >= 0x212a && ch <= 0x2139) || (ch >= 0x213c && ch <= 0x213f) || (ch >= 0x2145 && ch <= 0x2149) || ch == 0x214e || (ch >= 0x2160 && ch <= 0x2188) || (ch >= 0x2c00 && ch <= 0x2c2e) || (ch >= 0x2c30 && ch <= 0x2c5e) || (ch >= 0x2c60 && ch <= 0x2ce4) || (ch >= 0x2ceb && ch <= 0x2cee) || ch == 0x2cf2 || ch == 0x2cf3 || (ch >= 0x2d00 && ch <= 0x2d25) || ch == 0x2d27 || ch == 0x2d2d || (ch >= 0x2d30 && ch <= 0x2d67) || ch == 0x2d6f || (ch >= 0x2d80 && ch <= 0x2d96) || (ch >= 0x2da0 && ch <= 0x2da6) || (ch >= 0x2da8 && ch <= 0x2dae) || (ch >= 0x2db0 && ch <= 0x2db6) || (ch >= 0x2db8 && ch <= 0x2dbe) || (ch >= 0x2dc0 && ch <= 0x2dc6) || (ch >= 0x2dc8 && ch <= 0x2dce) || (ch >= 0x2dd0 && ch <= 0x2dd6) || (ch >= 0x2dd8 && ch <= 0x2dde) || (ch >= 0x3005 && ch <= 0x3007) || (ch >= 0x3021 && ch <= 0x3029) || (ch >= 0x3031 && ch <= 0x3035) || (ch >= 0x3038 && ch <= 0x303c) || (ch >= 0x3041 && ch <= 0x3096) || (ch >= 0x309b && ch <= 0x309f) || (ch >= 0x30a1 && ch <= 0x30fa) || (ch >= 0x30fc && ch <= 0x30ff) || (ch >= 0x3105 && ch <= 0x312f) || (ch >= 0x3131 && ch <= 0x318e) || (ch >= 0x31a0 && ch <= 0x31ba) || (ch >= 0x31f0 && ch <= 0x31ff) || (ch >= 0x3400 && ch <= 0x4db5) || (ch >= 0x4e00 && ch <= 0x9fef) || (ch >= 0xa000 && ch <= 0xa48c) || (ch >= 0xa4d0 && ch <= 0xa4fd) || (ch >= 0xa500 && ch <= 0xa60c) || (ch >= 0xa610 && ch <= 0xa61f) || ch == 0xa62a || ch == 0xa62b || (ch >= 0xa640 && ch <= 0xa66e) || (ch >= 0xa67f && ch <= 0xa69d) || (ch >= 0xa6a0 && ch <= 0xa6ef) || (ch >= 0xa717 && ch <= 0xa71f) || (ch >= 0xa722 && ch <= 0xa788) || (ch >= 0xa78b && ch <= 0xa7b9) || (ch >= 0xa7f7 && ch <= 0xa801) || (ch >= 0xa803 && ch <= 0xa805) || (ch >= 0xa807 && ch <= 0xa80a) || (ch >= 0xa80c && ch <= 0xa822) || (ch >= 0xa840 && ch <= 0xa873) || (ch >= 0xa882 && ch <= 0xa8b3) || (ch >= 0xa8f2 && ch <= 0xa8f7) || ch == 0xa8fb || ch == 0xa8fd || ch == 0xa8fe || (ch >= 0xa90a && ch <= 0xa925) || (ch >= 0xa930 && ch <= 0xa946) || (ch >= 0xa960 && ch <= 0xa97c) || (ch >= 0xa984 && ch <= 0xa9b2) || ch == 0xa9cf || (ch >= 0xa9e0 && ch <= 0xa9e4) || (ch >= 0xa9e6 && ch <= 0xa9ef) || (ch >= 0xa9fa && ch <= 0xa9fe) || (ch >= 0xaa00 && ch <= 0xaa28) || (ch >= 0xaa40 && ch <= 0xaa42) || (ch >= 0xaa44 && ch <= 0xaa4b) || (ch >= 0xaa60 && ch <= 0xaa76) || ch == 0xaa7a || (ch >= 0xaa7e && ch <= 0xaaaf) || ch == 0xaab1 || ch == 0xaab5 || ch == 0xaab6 || (ch >= 0xaab9 && ch <= 0xaabd) || ch == 0xaac0 || ch == 0xaac2 || (ch >= 0xaadb && ch <= 0xaadd) || (ch >= 0xaae0 && ch <= 0xaaea) || (ch >= 0xaaf2 && ch <= 0xaaf4) || (ch >= 0xab01 && ch <= 0xab06) || (ch >= 0xab09 && ch <= 0xab0e) || (ch >= 0xab11 && ch <= 0xab16) || (ch >= 0xab20 && ch <= 0xab26) || (ch >= 0xab28 && ch <= 0xab2e) ||
+      (ch >= 0xab30 && ch <= 0xab5a) || (ch >= 0xab5c && ch <= 0xab65) || (ch >= 0xab70 && ch <= 0xabe2) || (ch >= 0xac00 && ch <= 0xd7a3) || (ch >= 0xd7b0 && ch <= 0xd7c6) || (ch >= 0xd7cb && ch <= 0xd7fb) || (ch >= 0xf900 && ch <= 0xfa6d) || (ch >= 0xfa70 && ch <= 0xfad9) || (ch >= 0xfb00 && ch <= 0xfb06) || (ch >= 0xfb13 && ch <= 0xfb17) || ch == 0xfb1d || (ch >= 0xfb1f && ch <= 0xfb28) || (ch >= 0xfb2a && ch <= 0xfb36) || (ch >= 0xfb38 && ch <= 0xfb3c) || ch == 0xfb3e || ch == 0xfb40 || ch == 0xfb41 || ch == 0xfb43 || ch == 0xfb44 || (ch >= 0xfb46 && ch <= 0xfbb1) || (ch >= 0xfbd3 && ch <= 0xfd3d) || (ch >= 0xfd50 && ch <= 0xfd8f) || (ch >= 0xfd92 && ch <= 0xfdc7) || (ch >= 0xfdf0 && ch <= 0xfdfb) || (ch >= 0xfe70 && ch <= 0xfe74) || (ch >= 0xfe76 && ch <= 0xfefc) || (ch >= 0xff21 && ch <= 0xff3a) || (ch >= 0xff41 && ch <= 0xff5a) || (ch >= 0xff66 && ch <= 0xffbe) || (ch >= 0xffc2 && ch <= 0xffc7) || (ch >= 0xffca && ch <= 0xffcf) || (ch >= 0xffd2 && ch <= 0xffd7) || (ch >= 0xffda && ch <= 0xffdc);
 }
 
-bool isNonASCIIidentifierChar (uint32_t ch) {
-  return isNonASCIIidentifierStartChar(ch) || ch == 0x200c || ch == 0x200d || ch == 0xb7 || ch >= 0x0300 && ch <= 0x036f || ch == 0x0387 || ch >= 0x0483 && ch <= 0x0487 || ch >= 0x0591 && ch <= 0x05bd || ch == 0x05bf || ch == 0x05c1 || ch == 0x05c2 || ch == 0x05c4 || ch == 0x05c5 || ch == 0x05c7 || ch >= 0x0610 && ch <= 0x061a || ch >= 0x064b && ch <= 0x0669 || ch == 0x0670 || ch >= 0x06d6 && ch <= 0x06dc || ch >= 0x06df && ch <= 0x06e4 || ch == 0x06e7 || ch == 0x06e8 || ch >= 0x06ea && ch <= 0x06ed || ch >= 0x06f0 && ch <= 0x06f9 || ch == 0x0711 || ch >= 0x0730 && ch <= 0x074a || ch >= 0x07a6 && ch <= 0x07b0 || ch >= 0x07c0 && ch <= 0x07c9 || ch >= 0x07eb && ch <= 0x07f3 || ch == 0x07fd || ch >= 0x0816 && ch <= 0x0819 || ch >= 0x081b && ch <= 0x0823 || ch >= 0x0825 && ch <= 0x0827 || ch >= 0x0829 && ch <= 0x082d || ch >= 0x0859 && ch <= 0x085b || ch >= 0x08d3 && ch <= 0x08e1 || ch >= 0x08e3 && ch <= 0x0903 || ch >= 0x093a && ch <= 0x093c || ch >= 0x093e && ch <= 0x094f || ch >= 0x0951 && ch <= 0x0957 || ch == 0x0962 || ch == 0x0963 || ch >= 0x0966 && ch <= 0x096f || ch >= 0x0981 && ch <= 0x0983 || ch == 0x09bc || ch >= 0x09be && ch <= 0x09c4 || ch == 0x09c7 || ch == 0x09c8 || ch >= 0x09cb && ch <= 0x09cd || ch == 0x09d7 || ch == 0x09e2 || ch == 0x09e3 || ch >= 0x09e6 && ch <= 0x09ef || ch == 0x09fe || ch >= 0x0a01 && ch <= 0x0a03 || ch == 0x0a3c || ch >= 0x0a3e && ch <= 0x0a42 || ch == 0x0a47 || ch == 0x0a48 || ch >= 0x0a4b && ch <= 0x0a4d || ch == 0x0a51 || ch >= 0x0a66 && ch <= 0x0a71 || ch == 0x0a75 || ch >= 0x0a81 && ch <= 0x0a83 || ch == 0x0abc || ch >= 0x0abe && ch <= 0x0ac5 || ch >= 0x0ac7 && ch <= 0x0ac9 || ch >= 0x0acb && ch <= 0x0acd || ch == 0x0ae2 || ch == 0x0ae3 || ch >= 0x0ae6 && ch <= 0x0aef || ch >= 0x0afa && ch <= 0x0aff || ch >= 0x0b01 && ch <= 0x0b03 || ch == 0x0b3c || ch >= 0x0b3e && ch <= 0x0b44 || ch == 0x0b47 || ch == 0x0b48 || ch >= 0x0b4b && ch <= 0x0b4d || ch == 0x0b56 || ch == 0x0b57 || ch == 0x0b62 || ch == 0x0b63 || ch >= 0x0b66 && ch <= 0x0b6f || ch == 0x0b82 || ch >= 0x0bbe && ch <= 0x0bc2 || ch >= 0x0bc6 && ch <= 0x0bc8 || ch >= 0x0bca && ch <= 0x0bcd || ch == 0x0bd7 || ch >= 0x0be6 && ch <= 0x0bef || ch >= 0x0c00 && ch <= 0x0c04 || ch >= 0x0c3e && ch <= 0x0c44 || ch >= 0x0c46 && ch <= 0x0c48 || ch >= 0x0c4a && ch <= 0x0c4d || ch == 0x0c55 || ch == 0x0c56 || ch == 0x0c62 || ch == 0x0c63 || ch >= 0x0c66 && ch <= 0x0c6f || ch >= 0x0c81 && ch <= 0x0c83 || ch == 0x0cbc || ch >= 0x0cbe && ch <= 0x0cc4 || ch >= 0x0cc6 && ch <= 0x0cc8 || ch >= 0x0cca && ch <= 0x0ccd || ch == 0x0cd5 || ch == 0x0cd6 || ch == 0x0ce2 || ch == 0x0ce3 || ch >= 0x0ce6 && ch <= 0x0cef || ch >= 0x0d00 && ch <= 0x0d03 || ch == 0x0d3b || ch == 0x0d3c || ch >= 0x0d3e && ch <= 0x0d44 || ch >= 0x0d46 && ch <= 0x0d48 || ch >= 0x0d4a && ch <= 0x0d4d || ch == 0x0d57 || ch == 0x0d62 || ch == 0x0d63 || ch >= 0x0d66 && ch <= 0x0d6f || ch == 0x0d82 || ch == 0x0d83 || ch == 0x0dca || ch >= 0x0dcf && ch <= 0x0dd4 || ch == 0x0dd6 || ch >= 0x0dd8 && ch <= 0x0ddf || ch >= 0x0de6 && ch <= 0x0def || ch == 0x0df2 || ch == 0x0df3 || ch == 0x0e31 || ch >= 0x0e34 && ch <= 0x0e3a || ch >= 0x0e47 && ch <= 0x0e4e || ch >= 0x0e50 && ch <= 0x0e59 || ch == 0x0eb1 || ch >= 0x0eb4 && ch <= 0x0eb9 || ch == 0x0ebb || ch == 0x0ebc || ch >= 0x0ec8 && ch <= 0x0ecd || ch >= 0x0ed0 && ch <= 0x0ed9 || ch == 0x0f18 || ch == 0x0f19 || ch >= 0x0f20 && ch <= 0x0f29 || ch == 0x0f35 || ch == 0x0f37 || ch == 0x0f39 || ch == 0x0f3e || ch == 0x0f3f || ch >= 0x0f71 && ch <= 0x0f84 || ch == 0x0f86 || ch == 0x0f87 || ch >= 0x0f8d && ch <= 0x0f97 || ch >= 0x0f99 && ch <= 0x0fbc || ch == 0x0fc6 || ch >= 0x102b && ch <= 0x103e || ch >= 0x1040 && ch <= 0x1049 || ch >= 0x1056 && ch <= 0x1059 || ch >= 0x105e && ch <= 0x1060 || ch >= 0x1062 && ch <= 0x1064 || ch >= 0x1067 && ch <= 0x106d || ch >= 0x1071 && ch <= 0x1074 || ch >= 0x1082 && ch <= 0x108d || ch >= 0x108f && ch <= 0x109d || ch >= 0x135d && ch <= 0x135f || ch >= 0x1369 && ch <= 0x1371 || ch >= 0x1712 && ch <= 0x1714 || ch >= 0x1732 && ch <= 0x1734 || ch == 0x1752 || ch == 0x1753 || ch == 0x1772 || ch == 0x1773 || ch >= 0x17b4 && ch <= 0x17d3 || ch == 0x17dd || ch >= 0x17e0 && ch <= 0x17e9 || ch >= 0x180b && ch <= 0x180d || ch >= 0x1810 && ch <= 0x1819 || ch == 0x18a9 || ch >= 0x1920 && ch <= 0x192b || ch >= 0x1930 && ch <= 0x193b || ch >= 0x1946 && ch <= 0x194f || ch >= 0x19d0 && ch <= 0x19da || ch >= 0x1a17 && ch <= 0x1a1b || ch >= 0x1a55 && ch <= 0x1a5e || ch >= 0x1a60 && ch <= 0x1a7c || ch >= 0x1a7f && ch <= 0x1a89 || ch >= 0x1a90 && ch <= 0x1a99 || ch >= 0x1ab0 && ch <= 0x1abd || ch >= 0x1b00 && ch <= 0x1b04 || ch >= 0x1b34 && ch <= 0x1b44 || ch >= 0x1b50 && ch <= 0x1b59 || ch >= 0x1b6b && ch <= 0x1b73 || ch >= 0x1b80 && ch <= 0x1b82 || ch >= 0x1ba1 && ch <= 0x1bad || ch >= 0x1bb0 && ch <= 0x1bb9 || ch >= 0x1be6 && ch <= 0x1bf3 || ch >= 0x1c24 && ch <= 0x1c37 || ch >= 0x1c40 && ch <= 0x1c49 || ch >= 0x1c50 && ch <= 0x1c59 || ch >= 0x1cd0 && ch <= 0x1cd2 || ch >= 0x1cd4 && ch <= 0x1ce8 || ch == 0x1ced || ch >= 0x1cf2 && ch <= 0x1cf4 || ch >= 0x1cf7 && ch <= 0x1cf9 || ch >= 0x1dc0 && ch <= 0x1df9 || ch >= 0x1dfb && ch <= 0x1dff || ch == 0x203f || ch == 0x2040 || ch == 0x2054 || ch >= 0x20d0 && ch <= 0x20dc || ch == 0x20e1 || ch >= 0x20e5 && ch <= 0x20f0 || ch >= 0x2cef && ch <= 0x2cf1 || ch == 0x2d7f || ch >= 0x2de0 && ch <= 0x2dff || ch >= 0x302a && ch <= 0x302f || ch == 0x3099 || ch == 0x309a || ch >= 0xa620 && ch <= 0xa629 || ch == 0xa66f || ch >= 0xa674 && ch <= 0xa67d || ch == 0xa69e || ch == 0xa69f || ch == 0xa6f0 || ch == 0xa6f1 || ch == 0xa802 || ch == 0xa806 || ch == 0xa80b || ch >= 0xa823 && ch <= 0xa827 || ch == 0xa880 || ch == 0xa881 || ch >= 0xa8b4 && ch <= 0xa8c5 || ch >= 0xa8d0 && ch <= 0xa8d9 || ch >= 0xa8e0 && ch <= 0xa8f1 || ch >= 0xa8ff && ch <= 0xa909 || ch >= 0xa926 && ch <= 0xa92d || ch >= 0xa947 && ch <= 0xa953 || ch >= 0xa980 && ch <= 0xa983 || ch >= 0xa9b3 && ch <= 0xa9c0 || ch >= 0xa9d0 && ch <= 0xa9d9 || ch == 0xa9e5 || ch >= 0xa9f0 && ch <= 0xa9f9 || ch >= 0xaa29 && ch <= 0xaa36 || ch == 0xaa43 || ch == 0xaa4c || ch == 0xaa4d || ch >= 0xaa50 && ch <= 0xaa59 || ch >= 0xaa7b && ch <= 0xaa7d || ch == 0xaab0 || ch >= 0xaab2 && ch <= 0xaab4 || ch == 0xaab7 || ch == 0xaab8 || ch == 0xaabe || ch == 0xaabf || ch == 0xaac1 || ch >= 0xaaeb && ch <= 0xaaef || ch == 0xaaf5 || ch == 0xaaf6 || ch >= 0xabe3 && ch <= 0xabea || ch == 0xabec || ch == 0xabed || ch >= 0xabf0 && ch <= 0xabf9 || ch == 0xfb1e || ch >= 0xfe00 && ch <= 0xfe0f || ch >= 0xfe20 && ch <= 0xfe2f || ch == 0xfe33 || ch == 0xfe34 || ch >= 0xfe4d && ch <= 0xfe4f || ch >= 0xff10 && ch <= 0xff19 || ch == 0xff3f;
+static bool isNonASCIIidentifierChar (uint32_t ch) {
+  return isNonASCIIidentifierStartChar(ch) || ch == 0x200c || ch == 0x200d || ch == 0xb7 || (ch >= 0x0300 && ch <= 0x036f) || ch == 0x0387 || (ch >= 0x0483 && ch <= 0x0487) || (ch >= 0x0591 && ch <= 0x05bd) || ch == 0x05bf || ch == 0x05c1 || ch == 0x05c2 || ch == 0x05c4 || ch == 0x05c5 || ch == 0x05c7 || (ch >= 0x0610 && ch <= 0x061a) || (ch >= 0x064b && ch <= 0x0669) || ch == 0x0670 || (ch >= 0x06d6 && ch <= 0x06dc) || (ch >= 0x06df && ch <= 0x06e4) || ch == 0x06e7 || ch == 0x06e8 || (ch >= 0x06ea && ch <= 0x06ed) || (ch >= 0x06f0 && ch <= 0x06f9) || ch == 0x0711 || (ch >= 0x0730 && ch <= 0x074a) || (ch >= 0x07a6 && ch <= 0x07b0) || (ch >= 0x07c0 && ch <= 0x07c9) || (ch >= 0x07eb && ch <= 0x07f3) || ch == 0x07fd || (ch >= 0x0816 && ch <= 0x0819) || (ch >= 0x081b && ch <= 0x0823) || (ch >= 0x0825 && ch <= 0x0827) || (ch >= 0x0829 && ch <= 0x082d) || (ch >= 0x0859 && ch <= 0x085b) || (ch >= 0x08d3 && ch <= 0x08e1) || (ch >= 0x08e3 && ch <= 0x0903) || (ch >= 0x093a && ch <= 0x093c) || (ch >= 0x093e && ch <= 0x094f) || (ch >= 0x0951 && ch <= 0x0957) || ch == 0x0962 || ch == 0x0963 || (ch >= 0x0966 && ch <= 0x096f) || (ch >= 0x0981 && ch <= 0x0983) || ch == 0x09bc || (ch >= 0x09be && ch <= 0x09c4) || ch == 0x09c7 || ch == 0x09c8 || (ch >= 0x09cb && ch <= 0x09cd) || ch == 0x09d7 || ch == 0x09e2 || ch == 0x09e3 || (ch >= 0x09e6 && ch <= 0x09ef) || ch == 0x09fe || (ch >= 0x0a01 && ch <= 0x0a03) || ch == 0x0a3c || (ch >= 0x0a3e && ch <= 0x0a42) || ch == 0x0a47 || ch == 0x0a48 || (ch >= 0x0a4b && ch <= 0x0a4d) || ch == 0x0a51 || (ch >= 0x0a66 && ch <= 0x0a71) || ch == 0x0a75 || (ch >= 0x0a81 && ch <= 0x0a83) || ch == 0x0abc || (ch >= 0x0abe && ch <= 0x0ac5) || (ch >= 0x0ac7 && ch <= 0x0ac9) || (ch >= 0x0acb && ch <= 0x0acd) || ch == 0x0ae2 || ch == 0x0ae3 || (ch >= 0x0ae6 && ch <= 0x0aef) || (ch >= 0x0afa && ch <= 0x0aff) || (ch >= 0x0b01 && ch <= 0x0b03) || ch == 0x0b3c || (ch >= 0x0b3e && ch <= 0x0b44) || ch == 0x0b47 || ch == 0x0b48 || (ch >= 0x0b4b && ch <= 0x0b4d) || ch == 0x0b56 || ch == 0x0b57 || ch == 0x0b62 || ch == 0x0b63 || (ch >= 0x0b66 && ch <= 0x0b6f) || ch == 0x0b82 || (ch >= 0x0bbe && ch <= 0x0bc2) || (ch >= 0x0bc6 && ch <= 0x0bc8) || (ch >= 0x0bca && ch <= 0x0bcd) || ch == 0x0bd7 || (ch >= 0x0be6 && ch <= 0x0bef) || (ch >= 0x0c00 && ch <= 0x0c04) || (ch >= 0x0c3e && ch <= 0x0c44) || (ch >= 0x0c46 && ch <= 0x0c48) || (ch >= 0x0c4a && ch <= 0x0c4d) || ch == 0x0c55 || ch == 0x0c56 || ch == 0x0c62 || ch == 0x0c63 || (ch >= 0x0c66 && ch <= 0x0c6f) || (ch >= 0x0c81 && ch <= 0x0c83) || ch == 0x0cbc || (ch >= 0x0cbe && ch <= 0x0cc4) || (ch >= 0x0cc6 && ch <= 0x0cc8) || (ch >= 0x0cca && ch <= 0x0ccd) || ch == 0x0cd5 || ch == 0x0cd6 || ch == 0x0ce2 || ch == 0x0ce3 || (ch >= 0x0ce6 && ch <= 0x0cef) || (ch >= 0x0d00 && ch <= 0x0d03) || ch == 0x0d3b || ch == 0x0d3c || (ch >= 0x0d3e && ch <= 0x0d44) || (ch >= 0x0d46 && ch <= 0x0d48) || (ch >= 0x0d4a && ch <= 0x0d4d) || ch == 0x0d57 || ch == 0x0d62 || ch == 0x0d63 || (ch >= 0x0d66 && ch <= 0x0d6f) || ch == 0x0d82 || ch == 0x0d83 || ch == 0x0dca || (ch >= 0x0dcf && ch <= 0x0dd4) || ch == 0x0dd6 || (ch >= 0x0dd8 && ch <= 0x0ddf) || (ch >= 0x0de6 && ch <= 0x0def) || ch == 0x0df2 || ch == 0x0df3 || ch == 0x0e31 || (ch >= 0x0e34 && ch <= 0x0e3a) || (ch >= 0x0e47 && ch <= 0x0e4e) || (ch >= 0x0e50 && ch <= 0x0e59) || ch == 0x0eb1 || (ch >= 0x0eb4 && ch <= 0x0eb9) || ch == 0x0ebb || ch == 0x0ebc || (ch >= 0x0ec8 && ch <= 0x0ecd) || (ch >= 0x0ed0 && ch <= 0x0ed9) || ch == 0x0f18 || ch == 0x0f19 || (ch >= 0x0f20 && ch <= 0x0f29) || ch == 0x0f35 || ch == 0x0f37 || ch == 0x0f39 || ch == 0x0f3e || ch == 0x0f3f || (ch >= 0x0f71 && ch <= 0x0f84) || ch == 0x0f86 || ch == 0x0f87 || (ch >= 0x0f8d && ch <= 0x0f97) || (ch >= 0x0f99 && ch <= 0x0fbc) || ch == 0x0fc6 || (ch >= 0x102b && ch <= 0x103e) || (ch >= 0x1040 && ch <= 0x1049) || (ch >= 0x1056 && ch <= 0x1059) || (ch >= 0x105e && ch <= 0x1060) || (ch >= 0x1062 && ch <= 0x1064) || (ch >= 0x1067 && ch <= 0x106d) || (ch >= 0x1071 && ch <= 0x1074) || (ch >= 0x1082 && ch <= 0x108d) || (ch >= 0x108f && ch <= 0x109d) || (ch >= 0x135d && ch <= 0x135f) || (ch >= 0x1369 && ch <= 0x1371) || (ch >= 0x1712 && ch <= 0x1714) || (ch >= 0x1732 && ch <= 0x1734) || ch == 0x1752 || ch == 0x1753 || ch == 0x1772 || ch == 0x1773 || (ch >= 0x17b4 && ch <= 0x17d3) || ch == 0x17dd || (ch >= 0x17e0 && ch <= 0x17e9) || (ch >= 0x180b && ch <= 0x180d) || (ch >= 0x1810 && ch <= 0x1819) || ch == 0x18a9 || (ch >= 0x1920 && ch <= 0x192b) || (ch >= 0x1930 && ch <= 0x193b) || (ch >= 0x1946 && ch <= 0x194f) || (ch >= 0x19d0 && ch <= 0x19da) || (ch >= 0x1a17 && ch <= 0x1a1b) || (ch >= 0x1a55 && ch <= 0x1a5e) || (ch >= 0x1a60 && ch <= 0x1a7c) || (ch >= 0x1a7f && ch <= 0x1a89) || (ch >= 0x1a90 && ch <= 0x1a99) || (ch >= 0x1ab0 && ch <= 0x1abd) || (ch >= 0x1b00 && ch <= 0x1b04) || (ch >= 0x1b34 && ch <= 0x1b44) || (ch >= 0x1b50 && ch <= 0x1b59) || (ch >= 0x1b6b && ch <= 0x1b73) || (ch >= 0x1b80 && ch <= 0x1b82) || (ch >= 0x1ba1 && ch <= 0x1bad) || (ch >= 0x1bb0 && ch <= 0x1bb9) || (ch >= 0x1be6 && ch <= 0x1bf3) || (ch >= 0x1c24 && ch <= 0x1c37) || (ch >= 0x1c40 && ch <= 0x1c49) || (ch >= 0x1c50 && ch <= 0x1c59) || (ch >= 0x1cd0 && ch <= 0x1cd2) || (ch >= 0x1cd4 && ch <= 0x1ce8) || ch == 0x1ced || (ch >= 0x1cf2 && ch <= 0x1cf4) || (ch >= 0x1cf7 && ch <= 0x1cf9) || (ch >= 0x1dc0 && ch <= 0x1df9) || (ch >= 0x1dfb && ch <= 0x1dff) || ch == 0x203f || ch == 0x2040 || ch == 0x2054 || (ch >= 0x20d0 && ch <= 0x20dc) || ch == 0x20e1 || (ch >= 0x20e5 && ch <= 0x20f0) || (ch >= 0x2cef && ch <= 0x2cf1) || ch == 0x2d7f || (ch >= 0x2de0 && ch <= 0x2dff) || (ch >= 0x302a && ch <= 0x302f) || ch == 0x3099 || ch == 0x309a || (ch >= 0xa620 && ch <= 0xa629) || ch == 0xa66f || (ch >= 0xa674 && ch <= 0xa67d) || ch == 0xa69e || ch == 0xa69f || ch == 0xa6f0 || ch == 0xa6f1 || ch == 0xa802 || ch == 0xa806 || ch == 0xa80b || (ch >= 0xa823 && ch <= 0xa827) || ch == 0xa880 || ch == 0xa881 || (ch >= 0xa8b4 && ch <= 0xa8c5) || (ch >= 0xa8d0 && ch <= 0xa8d9) || (ch >= 0xa8e0 && ch <= 0xa8f1) || (ch >= 0xa8ff && ch <= 0xa909) || (ch >= 0xa926 && ch <= 0xa92d) || (ch >= 0xa947 && ch <= 0xa953) || (ch >= 0xa980 && ch <= 0xa983) || (ch >= 0xa9b3 && ch <= 0xa9c0) || (ch >= 0xa9d0 && ch <= 0xa9d9) || ch == 0xa9e5 || (ch >= 0xa9f0 && ch <= 0xa9f9) || (ch >= 0xaa29 && ch <= 0xaa36) || ch == 0xaa43 || ch == 0xaa4c || ch == 0xaa4d || (ch >= 0xaa50 && ch <= 0xaa59) || (ch >= 0xaa7b && ch <= 0xaa7d) || ch == 0xaab0 || (ch >= 0xaab2 && ch <= 0xaab4) || ch == 0xaab7 || ch == 0xaab8 || ch == 0xaabe || ch == 0xaabf || ch == 0xaac1 || (ch >= 0xaaeb && ch <= 0xaaef) || ch == 0xaaf5 || ch == 0xaaf6 || (ch >= 0xabe3 && ch <= 0xabea) || ch == 0xabec || ch == 0xabed || (ch >= 0xabf0 && ch <= 0xabf9) || ch == 0xfb1e || (ch >= 0xfe00 && ch <= 0xfe0f) || (ch >= 0xfe20 && ch <= 0xfe2f) || ch == 0xfe33 || ch == 0xfe34 || (ch >= 0xfe4d && ch <= 0xfe4f) || (ch >= 0xff10 && ch <= 0xff19) || ch == 0xff3f;
 }
 
 // These are a run-length and offset encoded representation of the
@@ -1028,7 +2591,7 @@ static uint32_t astralIdentifierCodes[] = { 509,0,227,0,150,4,294,9,1368,2,2,1,6
 // This has a complexity linear to the value of the code. The
 // assumption is that looking up astral identifier characters is
 // rare.
-bool isInAstralIdentifierStartCodes (uint32_t code) {
+static bool isInAstralIdentifierStartCodes (uint32_t code) {
   uint32_t cur = 0x10000;
   for (unsigned int i = 0; i < sizeof(astralIdentifierStartCodes) / sizeof(uint32_t); i += 2) {
     cur += astralIdentifierStartCodes[i];
@@ -1041,7 +2604,7 @@ bool isInAstralIdentifierStartCodes (uint32_t code) {
   return false;
 }
 
-bool isInAstralIdentifierCodes (uint32_t code) {
+static bool isInAstralIdentifierCodes (uint32_t code) {
   uint32_t cur = 0x10000;
   for (unsigned int i = 0; i < sizeof(astralIdentifierCodes) / sizeof(uint32_t); i += 2) {
     cur += astralIdentifierCodes[i];
@@ -1054,19 +2617,9 @@ bool isInAstralIdentifierCodes (uint32_t code) {
   return false;
 }
 
-// Test whether a given character code starts an identifier.
-bool isIdentifierStart(uint32_t code) {
-  if (code < 65) return code == 36;
-  if (code < 91) return true;
-  if (code < 97) return code == 95;
-  if (code < 123) return true;
-  if (code <= 0xffff) return code >= 0xaa && isNonASCIIidentifierStartChar(code);
-  return isInAstralIdentifierStartCodes(code);
-}
-
 // Test whether a given character is part of an identifier.
 
-bool isIdentifierChar(uint32_t code) {
+static bool isIdentifierChar(uint32_t code) {
   if (code < 48) return code == 36;
   if (code < 58) return true;
   if (code < 65) return false;
@@ -1077,13 +2630,22 @@ bool isIdentifierChar(uint32_t code) {
   return isInAstralIdentifierStartCodes(code) || isInAstralIdentifierCodes(code);
 }
 
-uint32_t nextChar(State *state) {
+static uint32_t nextChar(State *state) {
+#ifdef LEXER_UTF16
+  uint32_t c = *state->pos++;
+  if (c >= 0xd800 && c <= 0xdbff && *state->pos >= 0xdc00 && *state->pos <= 0xdfff)
+    c = 0x10000 + ((c - 0xd800) << 10) + (*state->pos++ - 0xdc00);
+  return c;
+#else
   uint32_t c;
   int e;
   state->pos = utf8_decode(state->pos, &c, &e);
   return c;
+#endif
 }
 
+#ifndef LEXER_UTF16
+
 // https://github.com/skeeto/branchless-utf8/blob/master/utf8.h
 /* Decode the next character, C, from BUF, reporting errors in E.
  *
@@ -1140,15 +2702,431 @@ static void *utf8_decode(void *buf, uint32_t *c, int *e) {
 
   return next;
 }
+#endif
 
-void bail (State *state, uint32_t error) {
+static void syntaxError (State *state) {
   state->has_error = true;
-  state->result->parse_error = error;
+  state->result->parse_error = state->pos - state->source;
   state->pos = state->end + 1;
 }
 
-void syntaxError (State *state) {
-  state->has_error = true;
-  state->result->parse_error = state->pos - state->source;
-  state->pos = state->end + 1;
+static bool readHex (const char16_t** pos, const char16_t* end, int digits, uint32_t* out) {
+  if (end - *pos < digits)
+    return false;
+  uint32_t c = 0;
+  for (int i = 0; i < digits; i++) {
+    char16_t ch = (*pos)[i];
+    if (ch >= '0' && ch <= '9')
+      c = c * 16 + ch - '0';
+    else if ((ch | 32) >= 'a' && (ch | 32) <= 'f')
+      c = c * 16 + (ch | 32) - 'a' + 10;
+    else
+      return false;
+    if (c > 0x10FFFF)
+      return false;
+  }
+  *pos += digits;
+  *out = c;
+  return true;
+}
+
+static char16_t* writeCodePoint (char16_t* out, uint32_t c) {
+#ifdef LEXER_UTF16
+  if (c >= 0x10000) {
+    c -= 0x10000;
+    *out++ = 0xD800 + (c >> 10);
+    *out++ = 0xDC00 + (c & 0x3FF);
+  }
+  else {
+    *out++ = c;
+  }
+#else
+  if (c < 0x80) {
+    *out++ = c;
+  }
+  else if (c < 0x800) {
+    *out++ = 0xC0 | (c >> 6);
+    *out++ = 0x80 | (c & 0x3F);
+  }
+  else if (c < 0x10000) {
+    *out++ = 0xE0 | (c >> 12);
+    *out++ = 0x80 | ((c >> 6) & 0x3F);
+    *out++ = 0x80 | (c & 0x3F);
+  }
+  else {
+    *out++ = 0xF0 | (c >> 18);
+    *out++ = 0x80 | ((c >> 12) & 0x3F);
+    *out++ = 0x80 | ((c >> 6) & 0x3F);
+    *out++ = 0x80 | (c & 0x3F);
+  }
+#endif
+  return out;
+}
+
+// Decodes the escapes of a string literal or template body in [start, end),
+// excluding its quotes, writing the result to out in the lexer encoding and
+// returning its length, or -1 for an invalid escape. The result is never longer
+// than the input, so out may equal start to decode in place.
+//
+// Escapes decoding to a lone surrogate can't be represented in UTF-8 and are
+// replaced with U+FFFD there, as are surrogate pairs escaped separately
+// combined into one character.
+int32_t unescape (const char16_t* start, const char16_t* end, char16_t* out) {
+  char16_t* outStart = out;
+  const char16_t* pos = start;
+  while (pos < end) {
+    char16_t ch = *pos++;
+    // line terminators in template bodies are normalized to \n
+    if (ch == '\r') {
+      if (pos < end && *pos == '\n')
+        pos++;
+      *out++ = '\n';
+      continue;
+    }
+    if (ch != '\\') {
+      *out++ = ch;
+      continue;
+    }
+    if (pos == end)
+      return -1;
+    ch = *pos++;
+    uint32_t c;
+    switch (ch) {
+      case 'n': c = '\n'; break;
+      case 'r': c = '\r'; break;
+      case 't': c = '\t'; break;
+      case 'b': c = '\b'; break;
+      case 'v': c = '\v'; break;
+      case 'f': c = '\f'; break;
+      // line continuations are removed
+      case '\r':
+        if (pos < end && *pos == '\n')
+          pos++;
+      case '\n':
+        continue;
+      case 'x':
+        if (!readHex(&pos, end, 2, &c))
+          return -1;
+        break;
+      case 'u':
+        if (pos < end && *pos == '{') {
+          const char16_t* close = ++pos;
+          while (close < end && *close != '}')
+            close++;
+          if (close == end || close == pos || !readHex(&pos, close, close - pos, &c))
+            return -1;
+          pos++;
+        }
+        else if (!readHex(&pos, end, 4, &c)) {
+          return -1;
+        }
+#ifndef LEXER_UTF16
+        if (c >= 0xD800 && c <= 0xDBFF && end - pos >= 6 && pos[0] == '\\' && pos[1] == 'u') {
+          const char16_t* next = pos + 2;
+          uint32_t low;
+          if (readHex(&next, end, 4, &low) && (low >= 0xDC00 && low <= 0xDFFF)) {
+            c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+            pos = next;
+          }
+        }
+        if (c >= 0xD800 && c <= 0xDFFF)
+          c = 0xFFFD;
+#endif
+        break;
+      case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7':
+        c = ch - '0';
+        for (int i = 0; i < 2 && pos < end && *pos >= '0' && *pos <= '7' && c * 8 + *pos - '0' <= 0xFF; i++)
+          c = c * 8 + *pos++ - '0';
+        // as in strict mode, an octal escape can't run into 8 or 9
+        if (pos < end && (*pos == '8' || *pos == '9'))
+          return -1;
+        break;
+      default:
+#ifdef LEXER_UTF16
+        if (ch == 0x2028 || ch == 0x2029)
+          continue;
+#else
+        if (ch == 0xE2 && end - pos >= 2 && pos[0] == 0x80 && (pos[1] == 0xA8 || pos[1] == 0xA9)) {
+          pos += 2;
+          continue;
+        }
+#endif
+        // any other escaped character is itself, with the rest of a multibyte
+        // character copied as-is
+        *out++ = ch;
+        continue;
+    }
+    out = writeCodePoint(out, c);
+  }
+  return out - outStart;
+}
+
+#if defined(LEXER_JS) || defined(LEXER_PACK)
+// Packed results, with all records in one int32 region so the JS wrappers
+// read them through a single Int32Array view:
+//   [importCount, exportCount, flags, parseError, lineCount, attributeCount, bindingCount,
+//    topLevelAwait, importMeta, require, prologueEnd, errorCount, fingerprintLow,
+//    fingerprintHigh]
+//   [s, e, ss, se, a, d, safe, at, b, star, k, ps, hl, hh, t] per import
+//   [s, e, ls, le, cjs, ri, rs, re, t] per export
+//   [ks, ke, vs, ve] per import attribute
+//   [s, e, ls, le, flags] per import binding
+//   [s, e, error] per recovered error range
+//   [lineStart] per line
+// in code units, with -1 for absent offsets and a parseError of -1 on success.
+// flags are 1 for a facade, 2 when fast rejected, 4 for a "use strict"
+// directive and 8 for a hashbang.
+// d is -1 for static imports and -2 for import.meta. at and b are the number
+// of attributes and bindings of the import, which follow in import order.
+// Attribute key and value spans are inside any quotes, and bindings have
+// BindingFlags and no imported name span for default, namespace and phase
+// imports. Re-exports have the index ri of their import and the span of the
+// name imported by a named re-export, and star marks an `export * from`
+// import. k is the SpecifierKind, ps the subpath start of a bare specifier and
+// hl and hh the low and high halves of the specifier hash, with the Specifiers
+// option. t marks type-only imports and exports, with the Typescript option.
+// Line starts are included when parsing with the LineStarts option, and
+// always for a parse error.
+
+static int32_t packOffset (const char16_t* source, const char16_t* ptr) {
+  return ptr ? ptr - source : -1;
+}
+
+static int32_t* packResult (bool ok, ParseResult result, const char16_t* source, uint32_t sourceLen, Allocator alloc, void* user_data, uint32_t* packedLen) {
+  if (!ok) {
+    result.first_import = NULL;
+    result.first_export = NULL;
+    if (!result.line_starts)
+      result.line_starts = collectLineStarts(source, source + sourceLen, alloc, user_data, &result.line_count);
+  }
+
+  uint32_t importCount = 0, exportCount = 0, attributeCount = 0, bindingCount = 0, errorCount = 0;
+  for (Import* import = result.first_import; import; import = import->next) {
+    importCount++;
+    for (Attribute* attribute = import->attributes; attribute; attribute = attribute->next)
+      attributeCount++;
+    for (ImportBinding* binding = import->bindings; binding; binding = binding->next)
+      bindingCount++;
+  }
+  for (Export* export = result.first_export; export; export = export->next)
+    exportCount++;
+  for (ErrorRange* range = result.first_error; range; range = range->next)
+    errorCount++;
+
+  uint32_t len = 14 + importCount * 15 + exportCount * 9 + attributeCount * 4 + bindingCount * 5 + errorCount * 3 + result.line_count;
+  int32_t* out = alloc(len * sizeof(int32_t), user_data);
+  if (packedLen)
+    *packedLen = len;
+  out[0] = importCount;
+  out[1] = exportCount;
+  // flags: facade, fast rejected, use strict, hashbang
+  out[2] = result.facade | result.fast_rejected << 1 | result.meta.use_strict << 2 | result.meta.hashbang << 3;
+  out[3] = ok ? -1 : (int32_t)result.parse_error;
+  out[4] = result.line_count;
+  out[5] = attributeCount;
+  out[6] = bindingCount;
+  out[7] = packOffset(source, result.meta.top_level_await);
+  out[8] = packOffset(source, result.meta.import_meta);
+  out[9] = packOffset(source, result.meta.require);
+  out[10] = packOffset(source, result.meta.prologue_end);
+  out[11] = errorCount;
+  out[12] = (int32_t)result.meta.fingerprint;
+  out[13] = (int32_t)(result.meta.fingerprint >> 32);
+
+  int32_t* record = out + 14;
+  for (Import* import = result.first_import; import; import = import->next) {
+    record[0] = packOffset(source, import->start);
+    record[1] = packOffset(source, import->end);
+    record[2] = packOffset(source, import->statement_start);
+    record[3] = packOffset(source, import->statement_end);
+    record[4] = packOffset(source, import->assert_index);
+    record[5] = import->dynamic == STANDARD_IMPORT ? -1 : import->dynamic == IMPORT_META ? -2 : packOffset(source, import->dynamic);
+    record[6] = import->safe;
+    record[7] = 0;
+    for (Attribute* attribute = import->attributes; attribute; attribute = attribute->next)
+      record[7]++;
+    record[8] = 0;
+    for (ImportBinding* binding = import->bindings; binding; binding = binding->next)
+      record[8]++;
+    record[9] = import->star_reexport;
+    record[10] = import->specifier_kind;
+    record[11] = packOffset(source, import->subpath_start);
+    record[12] = (int32_t)import->hash;
+    record[13] = (int32_t)(import->hash >> 32);
+    record[14] = import->type_only;
+    record += 15;
+  }
+  for (Export* export = result.first_export; export; export = export->next) {
+    record[0] = packOffset(source, export->start);
+    record[1] = packOffset(source, export->end);
+    record[2] = packOffset(source, export->local_start);
+    record[3] = packOffset(source, export->local_end);
+    record[4] = export->cjs;
+    record[5] = export->import_index;
+    record[6] = packOffset(source, export->imported_start);
+    record[7] = packOffset(source, export->imported_end);
+    record[8] = export->type_only;
+    record += 9;
+  }
+  for (Import* import = result.first_import; import; import = import->next) {
+    for (Attribute* attribute = import->attributes; attribute; attribute = attribute->next) {
+      record[0] = packOffset(source, attribute->key_start);
+      record[1] = packOffset(source, attribute->key_end);
+      record[2] = packOffset(source, attribute->value_start);
+      record[3] = packOffset(source, attribute->value_end);
+      record += 4;
+    }
+  }
+  for (Import* import = result.first_import; import; import = import->next) {
+    for (ImportBinding* binding = import->bindings; binding; binding = binding->next) {
+      record[0] = packOffset(source, binding->imported_start);
+      record[1] = packOffset(source, binding->imported_end);
+      record[2] = packOffset(source, binding->local_start);
+      record[3] = packOffset(source, binding->local_end);
+      record[4] = binding->flags;
+      record += 5;
+    }
+  }
+  for (ErrorRange* range = result.first_error; range; range = range->next) {
+    record[0] = packOffset(source, range->start);
+    record[1] = packOffset(source, range->end);
+    record[2] = packOffset(source, range->error);
+    record += 3;
+  }
+  memcpy(record, result.line_starts, result.line_count * sizeof(uint32_t));
+  return out;
+}
+
+// Lexes the regions with parse_regions and packs the results of each in turn,
+// up to and including the first region that failed, setting packedCount to
+// their number and packedLens, when given, to their lengths. Every offset is
+// of the whole source.
+static int32_t** packRegions (char16_t* source, uint32_t sourceLen, const Region* regions, uint32_t regionCount, uint32_t options, Allocator alloc, void* user_data, uint32_t* packedCount, uint32_t* packedLens) {
+  ParseResult* results = alloc(regionCount * sizeof(ParseResult), user_data);
+  uint32_t lexed = parse_regions(source, sourceLen, regions, regionCount, options, alloc, user_data, results);
+  uint32_t count = lexed < regionCount ? lexed + 1 : regionCount;
+  // one entry per region, so the wrappers can view them all before reading
+  int32_t** packed = alloc(regionCount * sizeof(int32_t*), user_data);
+  for (uint32_t i = 0; i < count; i++)
+    packed[i] = packResult(i < lexed, results[i], source, sourceLen, alloc, user_data, packedLens ? &packedLens[i] : NULL);
+  *packedCount = count;
+  return packed;
+}
+
+#ifdef LEXER_PACK
+// Parses and packs the results in one call, for the native addon, which lexes
+// on worker threads and so can't share the JS API's globals.
+int32_t* parse_packed (char16_t* source, uint32_t sourceLen, uint32_t options, Allocator alloc, void* user_data, uint32_t* packedLen) {
+  ParseResult result = { 0 };
+  bool ok = parse(source, sourceLen, options, alloc, user_data, &result);
+  return packResult(ok, result, source, sourceLen, alloc, user_data, packedLen);
+}
+
+int32_t** parse_regions_packed (char16_t* source, uint32_t sourceLen, const Region* regions, uint32_t regionCount, uint32_t options, Allocator alloc, void* user_data, uint32_t* packedCount, uint32_t* packedLens) {
+  return packRegions(source, sourceLen, regions, regionCount, options, alloc, user_data, packedCount, packedLens);
+}
+#endif
+#endif
+
+#ifdef LEXER_JS
+// JS API, used by the wasm and asm.js builds
+//
+// The source is written at the address returned by sa, with the analysis
+// arena following it. p (or ps and then pn until it returns non-null, to
+// parse in slices) then returns the packed results, or pr those of each of the
+// regions written at the address returned by ra.
+
+#ifdef __wasm__
+extern unsigned char __heap_base;
+#endif
+
+static char16_t* jsSource = NULL;
+static uint32_t jsSourceLen;
+static uint8_t* jsHeap;
+
+static void jsReserve (void* end) {
+#ifdef __wasm__
+  size_t size = __builtin_wasm_memory_size(0) * 65536;
+  if ((size_t)end > size)
+    __builtin_wasm_memory_grow(0, ((size_t)end - size + 65535) / 65536);
+#endif
+}
+
+static void* jsAlloc (uint32_t bytes, void* user_data) {
+  uint8_t* ptr = jsHeap;
+  jsHeap += (bytes + 7) & ~7;
+  jsReserve(jsHeap);
+  return ptr;
+}
+
+// setSource, for the asm.js build where the wrapper manages memory
+void ses (char16_t* ptr) {
+  jsSource = ptr;
+}
+
+static void jsInit () {
+#ifdef __wasm__
+  if (jsSource == NULL)
+    jsSource = (char16_t*)(((uintptr_t)&__heap_base + 7) & ~7);
+#endif
+}
+
+// allocateSource
+char16_t* sa (uint32_t len) {
+  jsInit();
+  jsSourceLen = len;
+  jsSource[len] = '\0';
+  jsHeap = (uint8_t*)(((uintptr_t)(jsSource + len + 1) + 7) & ~7);
+  return jsSource;
+}
+
+// parse
+int32_t* p (uint32_t options) {
+  ParseResult result = { 0 };
+  bool ok = parse(jsSource, jsSourceLen, options, jsAlloc, NULL, &result);
+  return packResult(ok, result, jsSource, jsSourceLen, jsAlloc, NULL, NULL);
+}
+
+// allocateRegions, space for the regions to be written into for pr
+Region* ra (uint32_t count) {
+  return jsAlloc(count * sizeof(Region), NULL);
+}
+
+// parseRegions, returning the addresses of the packed results of each region,
+// up to the first that failed
+int32_t** pr (uint32_t options, Region* regions, uint32_t count) {
+  uint32_t packedCount;
+  return packRegions(jsSource, jsSourceLen, regions, count, options, jsAlloc, NULL, &packedCount, NULL);
+}
+
+static ParseContext* jsContext;
+static ParseResult jsStepResult;
+
+// parseStart
+void ps (uint32_t options) {
+  jsStepResult = (ParseResult){ 0 };
+  jsContext = parse_init(jsSource, jsSourceLen, options, jsAlloc, NULL, &jsStepResult);
+}
+
+// parseNext, returning the packed results once done and NULL while pending
+int32_t* pn (uint32_t maxLen) {
+  enum ParseStatus status = parse_step(jsContext, maxLen);
+  if (status == ParsePending)
+    return NULL;
+  return packResult(status == ParseOk, jsStepResult, jsSource, jsSourceLen, jsAlloc, NULL, NULL);
+}
+
+// allocateScratch, space for a string literal to be copied into and decoded in
+// place by u. Results are read out by the wrapper before any decoding, so this
+// reuses the source region.
+char16_t* us (uint32_t len) {
+  jsInit();
+  jsReserve(jsSource + len);
+  return jsSource;
+}
+
+// unescape
+int32_t u (char16_t* ptr, uint32_t len) {
+  return unescape(ptr, ptr + len, ptr);
 }
+#endif
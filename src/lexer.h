@@ -4,20 +4,134 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+// The lexer is generic over its code unit width. By default it lexes UTF-8
+// bytes in place (the Rust crate), while building with -DLEXER_UTF16 lexes
+// UTF-16 code units so JS strings can be copied into memory without
+// re-encoding (the wasm and asm.js builds). Only `parse`, `parse_init`,
+// `parse_step`, `parse_regions`, `unescape` and, with -DLEXER_PACK,
+// `parse_packed` and `parse_regions_packed` have external linkage, so both
+// widths can be linked into one binary by including lexer.c from two
+// translation units with those renamed in one of them (as the native addon
+// does).
+#ifdef LEXER_UTF16
+typedef uint16_t char16_t;
+#else
 typedef unsigned char char16_t;
+#endif
 // extern unsigned char __heap_base;
 
-const char16_t* STANDARD_IMPORT = (char16_t*)0x1;
-const char16_t* IMPORT_META = (char16_t*)0x2;
-const char16_t* REQUIRE = (char16_t*)0x3;
-const char16_t __empty_char = '\0';
-const char16_t* EMPTY_CHAR = &__empty_char;
+// SIMD kernels are used to skip over string, comment and template contents
+// and over runs of tokens the main loop ignores, using wasm SIMD128 in the
+// -msimd128 wasm build and SSE2 natively. Vectors hold VLANES code units and
+// vmask produces one bit per lane. Building with -DLEXER_SCALAR leaves them
+// out, as the reference the fuzz/ harness checks the SIMD build against.
+#if defined(LEXER_SCALAR)
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define LEXER_SIMD
+typedef v128_t vec_t;
+#define vload(p) wasm_v128_load(p)
+#define vor(a, b) wasm_v128_or(a, b)
+#define vand(a, b) wasm_v128_and(a, b)
+#define vandnot(a, b) wasm_v128_andnot(b, a)
+#ifdef LEXER_UTF16
+#define vsplat(c) wasm_i16x8_splat(c)
+#define veq(a, b) wasm_i16x8_eq(a, b)
+#define vgt(a, b) wasm_i16x8_gt(a, b)
+#define vmask(v) wasm_i16x8_bitmask(v)
+#else
+#define vsplat(c) wasm_i8x16_splat(c)
+#define veq(a, b) wasm_i8x16_eq(a, b)
+#define vgt(a, b) wasm_i8x16_gt(a, b)
+#define vmask(v) wasm_i8x16_bitmask(v)
+#endif
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define LEXER_SIMD
+typedef __m128i vec_t;
+#define vload(p) _mm_loadu_si128((const __m128i*)(p))
+#define vor(a, b) _mm_or_si128(a, b)
+#define vand(a, b) _mm_and_si128(a, b)
+#define vandnot(a, b) _mm_andnot_si128(b, a)
+#ifdef LEXER_UTF16
+#define vsplat(c) _mm_set1_epi16(c)
+#define veq(a, b) _mm_cmpeq_epi16(a, b)
+#define vgt(a, b) _mm_cmpgt_epi16(a, b)
+#define vmask(v) _mm_movemask_epi8(_mm_packs_epi16(v, _mm_setzero_si128()))
+#else
+#define vsplat(c) _mm_set1_epi8(c)
+#define veq(a, b) _mm_cmpeq_epi8(a, b)
+#define vgt(a, b) _mm_cmpgt_epi8(a, b)
+#define vmask(v) _mm_movemask_epi8(v)
+#endif
+#endif
+
+// lane comparisons are signed, so non-ASCII code units never fall in a range
+#define VLANES (16 / sizeof(char16_t))
+#define vrange(v, lo, hi) vand(vgt(v, vsplat((lo) - 1)), vgt(vsplat((hi) + 1), v))
+
+static const char16_t* STANDARD_IMPORT = (char16_t*)0x1;
+static const char16_t* IMPORT_META = (char16_t*)0x2;
+static const char16_t __empty_char = '\0';
+static const char16_t* EMPTY_CHAR = &__empty_char;
 // const char16_t* source = NULL;
 
 // void setSource (void* ptr) {
 //   source = ptr;
 // }
 
+// An import attribute of a `with { key: 'value' }` or `assert { ... }` clause,
+// or of a dynamic import's options object when it's a literal.
+struct Attribute {
+  // the key, inside its quotes when it's a string
+  const char16_t* key_start;
+  const char16_t* key_end;
+  // the value, inside its quotes
+  const char16_t* value_start;
+  const char16_t* value_end;
+  // the decoded value, in the source unless it has escapes, with a length of
+  // -1 for an invalid escape
+  const char16_t* value;
+  int32_t value_len;
+  // 0 for an identifier key
+  char16_t key_quote;
+  char16_t value_quote;
+  struct Attribute* next;
+};
+typedef struct Attribute Attribute;
+
+enum BindingFlags {
+  BindingDefault = 1, // binds the default export, as `x` or `default as x`
+  BindingNamespace = 2, // binds the namespace object, as `* as ns`
+  BindingPhase = 4, // follows a phase, as `source x` or `defer * as ns`
+  BindingType = 8, // a type-only binding, as `type A` of `import { type A }`
+};
+
+// A name bound by a static import statement: `x` of `import x`, `ns` of
+// `import * as ns` or `b` of `import { a as b }`. A phase binding of
+// `import source x` has neither the default nor the namespace flag.
+struct ImportBinding {
+  // the imported name, including any quotes, or NULL for default, namespace
+  // and phase imports
+  const char16_t* imported_start;
+  const char16_t* imported_end;
+  const char16_t* local_start;
+  const char16_t* local_end;
+  uint32_t flags;
+  struct ImportBinding* next;
+};
+typedef struct ImportBinding ImportBinding;
+
+// The class of a string specifier, with the Specifiers option.
+enum SpecifierKind {
+  SpecifierNone = 0, // not a string literal, or has escapes
+  SpecifierRelative = 1, // ./ or ../, or just . or ..
+  SpecifierAbsolute = 2, // /
+  SpecifierUrl = 3, // a URL scheme, as node:, data: or https:
+  SpecifierBare = 4, // a package name, which may be @scope/name, and subpath
+  SpecifierImports = 5, // a # subpath import of package.json "imports"
+};
+
 struct Import {
   const char16_t* start;
   const char16_t* end;
@@ -26,6 +140,19 @@ struct Import {
   const char16_t* assert_index;
   const char16_t* dynamic;
   bool safe;
+  // an `export * from` whose exports are all re-exported
+  bool star_reexport;
+  // with the Typescript option, an `import type` or `export type ... from`
+  bool type_only;
+  // with the Specifiers option, for string specifiers without escapes
+  enum SpecifierKind specifier_kind;
+  // for bare specifiers, the end of the package name, at the / before the
+  // subpath or the end of the specifier
+  const char16_t* subpath_start;
+  // 64-bit FNV-1a of the specifier's code units
+  uint64_t hash;
+  Attribute* attributes;
+  ImportBinding* bindings;
   struct Import* next;
 };
 typedef struct Import Import;
@@ -39,6 +166,9 @@ enum OpenTokenState {
   ImportParen = 5, // import(),
   ClassBrace = 6,
   AsyncParen = 7, // async()
+  JsxAttributeBrace = 8, // { of a JSX attribute, with the Jsx option
+  JsxChildren = 9, // a JSX element whose children are being lexed
+  JsxChildBrace = 10, // { of a JSX child expression
 };
 
 struct OpenToken {
@@ -47,37 +177,157 @@ struct OpenToken {
 };
 typedef struct OpenToken OpenToken;
 
+// What lexSlice does on a code unit, looked up in the action table of its
+// current mode. The facade actions only appear in the facade tables and the
+// rest only in the main tables.
+enum LexAction {
+  ActSkip, // whitespace in the facade
+  ActToken, // a token the facade only records as the last token
+  ActFacadeCjsExports, // e of exports or export, with CjsExports
+  ActFacadeExport,
+  ActFacadeImport,
+  ActFacadeRequire,
+  ActFacadeSlash,
+  ActLeaveFacade, // any non-module token
+  // ActInertSpace to ActClass are the main actions skipInert can skip over
+  ActInertSpace, // whitespace in the main loop
+  ActInertToken, // a token the main loop only records as the last token
+  ActCjsExports, // e of exports or export, with CjsExports
+  ActExport,
+  ActModule, // with CjsExports
+  ActObject, // with CjsExports
+  ActImport,
+  ActRequire,
+  ActAwait,
+  ActClass,
+  ActParenOpen,
+  ActParenClose,
+  ActBraceOpen,
+  ActBraceClose,
+  ActJsx, // with Jsx
+  ActString,
+  ActSlash,
+  ActTemplate,
+};
+
+enum ExportKind {
+  LocalExport = 0,
+  ReexportNamed = 1, // export { a as b } from
+  ReexportNamespace = 2, // export * as ns from
+};
+
 struct Export {
   const char16_t* start;
   const char16_t* end;
   const char16_t* local_start;
   const char16_t* local_end;
+  // assigned to exports or module.exports, with the CjsExports option
+  bool cjs;
+  // with the Typescript option, a type alias or interface, or a name of an
+  // `export type { ... }` or marked `type` in `export { type A }`
+  bool type_only;
+  enum ExportKind kind;
+  // for re-exports, the index of the import of the module re-exported from,
+  // or -1
+  int32_t import_index;
+  // for named re-exports, the name imported from that module, including any
+  // quotes
+  const char16_t* imported_start;
+  const char16_t* imported_end;
   struct Export* next;
 };
 typedef struct Export Export;
 
 typedef void *(*Allocator)(uint32_t bytes, void *user_data);
 
+// parse options, as bit flags
+enum ParseOption {
+  LineStarts = 1, // collect line_starts
+  CjsExports = 2, // detect CommonJS exports assignments as cjs exports
+  FastReject = 4, // skip lexing when import, export and require never appear
+  Recover = 8, // resume after syntax errors, reporting them as error ranges
+  Specifiers = 16, // classify and hash string specifiers
+  Fingerprint = 32, // compute meta.fingerprint
+  Jsx = 64, // lex JSX elements in expression position
+  Typescript = 128, // read type-only imports and exports and TS declarations
+};
+
+// A region in which lexing failed, with the Recover option, from the last
+// record before the error to where lexing resumed, or the end of the source.
+// Records inside it may be missing.
+struct ErrorRange {
+  const char16_t* start;
+  const char16_t* end;
+  // where the error was found
+  const char16_t* error;
+  struct ErrorRange* next;
+};
+typedef struct ErrorRange ErrorRange;
+
+// Facts about the module as a whole, gathered while lexing. Positions are of
+// the first occurrence, or NULL when there is none.
+struct ModuleMeta {
+  // an await outside of any function
+  const char16_t* top_level_await;
+  const char16_t* import_meta;
+  // a require() call or reference, as reported as an import
+  const char16_t* require;
+  // the start of the first statement after the leading import and export
+  // declarations, or the end of the source when there is none
+  const char16_t* prologue_end;
+  // a "use strict" directive in the directive prologue
+  bool use_strict;
+  // a #! line at the very start of the source
+  bool hashbang;
+  // with the Fingerprint option, a hash of the module's shape: its decoded
+  // specifiers with their kinds and attributes, and its export names,
+  // independent of their order
+  uint64_t fingerprint;
+};
+typedef struct ModuleMeta ModuleMeta;
+
 struct ParseResult {
   Import *first_import;
   Export *first_export;
   uint32_t parse_error;
+  bool facade;
+  // offsets of the start of each line, sorted, when parsed with LineStarts
+  uint32_t *line_starts;
+  uint32_t line_count;
+  // set when lexing was skipped by the FastReject option, in which case
+  // syntax errors aren't detected and facade is false
+  bool fast_rejected;
+  // with fast_rejected, only use_strict and hashbang are set
+  ModuleMeta meta;
+  // with the Recover option, instead of failing
+  ErrorRange *first_error;
 };
 
 typedef struct ParseResult ParseResult;
 
+// A range [start, end) of a source in code units to lex as a module of its
+// own, such as the contents of a <script type="module"> block.
+struct Region {
+  uint32_t start;
+  uint32_t end;
+};
+
+typedef struct Region Region;
+
 struct State {
   Allocator alloc;
   void *user_data;
   ParseResult *result;
   Import* import_write_head;
   Import* import_write_head_last;
+  uint32_t import_count;
   Export* export_write_head;
   bool facade;
   bool lastSlashWasDivision;
   uint16_t openTokenDepth;
   char16_t* lastTokenPos;
   char16_t *source;
+  uint32_t options;
   char16_t* pos;
   char16_t* end;
   OpenToken* openTokenStack;
@@ -85,38 +335,34 @@ struct State {
   Import** dynamicImportStack;
   bool nextBraceIsClass;
   bool has_error;
+  // past the "module-only" facade loop
+  bool mainParse;
+  ErrorRange* error_write_head;
+  // where lexing last resumed after an error
+  const char16_t* resumePos;
 };
 
 typedef struct State State;
 
-// Memory Structure:
-// -> source
-// -> analysis starts after source
-// uint32_t parse_error;
-// bool has_error = false;
-// uint32_t sourceLen = 0;
-
-void bail (State *state, uint32_t err);
-
-// allocateSource
-// void sa (uint32_t utf16Len) {
-  // sourceLen = utf16Len;
-  // const char16_t* sourceEnd = source + utf16Len;
-  // ensure source is null terminated
-  // *(char16_t*)(source + utf16Len) = '\0';
-  // analysis_base = (void*)sourceEnd;
-  // analysis_base = malloc(10 * sizeof(Import));
-  // analysis_head = analysis_base;
-  // first_import = NULL;
-  // import_write_head = NULL;
-  // import_read_head = NULL;
-  // first_export = NULL;
-  // export_write_head = NULL;
-  // export_read_head = NULL;
-  // return source;
-// }
+// Time sliced parsing state, allocated from the arena by parse_init so a host
+// can yield between parse_step calls.
+struct ParseContext {
+  State state;
+  OpenToken openTokenStack[1024];
+  Import* dynamicImportStack[512];
+  bool done;
+  bool ok;
+};
+
+typedef struct ParseContext ParseContext;
+
+enum ParseStatus {
+  ParseOk = 0,
+  ParseFailed = 1, // parse_error is set
+  ParsePending = 2,
+};
 
-void addImport (State *state, const char16_t* statement_start, const char16_t* start, const char16_t* end, const char16_t* dynamic) {
+static void addImport (State *state, const char16_t* statement_start, const char16_t* start, const char16_t* end, const char16_t* dynamic) {
   // Import* import = (Import*)(analysis_head);
   // analysis_head = analysis_head + sizeof(Import);
   // Import *import = state->allocImport();
@@ -127,9 +373,13 @@ void addImport (State *state, const char16_t* statement_start, const char16_t* s
     state->import_write_head->next = import;
   state->import_write_head_last = state->import_write_head;
   state->import_write_head = import;
+  state->import_count++;
   import->statement_start = statement_start;
-  if (dynamic == IMPORT_META)
+  if (dynamic == IMPORT_META) {
     import->statement_end = end;
+    if (!state->result->meta.import_meta)
+      state->result->meta.import_meta = start;
+  }
   else if (dynamic == STANDARD_IMPORT)
     import->statement_end = end + 1;
   else 
@@ -139,10 +389,17 @@ void addImport (State *state, const char16_t* statement_start, const char16_t* s
   import->assert_index = 0;
   import->dynamic = dynamic;
   import->safe = dynamic == STANDARD_IMPORT;
+  import->star_reexport = false;
+  import->type_only = false;
+  import->specifier_kind = SpecifierNone;
+  import->subpath_start = NULL;
+  import->hash = 0;
+  import->attributes = NULL;
+  import->bindings = NULL;
   import->next = NULL;
 }
 
-void addExport (State *state, const char16_t* start, const char16_t* end, const char16_t* local_start, const char16_t* local_end) {
+static void addExport (State *state, const char16_t* start, const char16_t* end, const char16_t* local_start, const char16_t* local_end) {
   // Export* export = (Export*)(analysis_head);
   // analysis_head = analysis_head + sizeof(Export);
   // Export *export = state->allocExport();
@@ -156,128 +413,167 @@ void addExport (State *state, const char16_t* start, const char16_t* end, const
   export->end = end;
   export->local_start = local_start;
   export->local_end = local_end;
+  export->cjs = false;
+  export->type_only = false;
+  export->kind = LocalExport;
+  export->import_index = -1;
+  export->imported_start = NULL;
+  export->imported_end = NULL;
   export->next = NULL;
 }
 
-// getErr
-// uint32_t e () {
-//   return parse_error;
-// }
-
-// // getImportStart
-// uint32_t is () {
-//   return import_read_head->start - source;
-// }
-// // getImportEnd
-// uint32_t ie () {
-//   return import_read_head->end == 0 ? -1 : import_read_head->end - source;
-// }
-// // getImportStatementStart
-// uint32_t ss () {
-//   return import_read_head->statement_start - source;
-// }
-// // getImportStatementEnd
-// uint32_t se () {
-//   return import_read_head->statement_end == 0 ? -1 : import_read_head->statement_end - source;
-// }
-// // getAssertIndex
-// uint32_t ai () {
-//   return import_read_head->assert_index == 0 ? -1 : import_read_head->assert_index - source;
-// }
-// // getImportDynamic
-// uint32_t id () {
-//   const char16_t* dynamic = import_read_head->dynamic;
-//   if (dynamic == STANDARD_IMPORT)
-//     return -1;
-//   else if (dynamic == IMPORT_META)
-//     return -2;
-//   return import_read_head->dynamic - source;
-// }
-// // getImportSafeString
-// uint32_t ip () {
-//   return import_read_head->safe;
-// }
-// // getExportStart
-// uint32_t es () {
-//   return export_read_head->start - source;
-// }
-// // getExportEnd
-// uint32_t ee () {
-//   return export_read_head->end - source;
-// }
-// // getExportLocalStart
-// int32_t els () {
-//   return export_read_head->local_start ? export_read_head->local_start - source : -1;
-// }
-// // getExportLocalEnd
-// int32_t ele () {
-//   return export_read_head->local_end ? export_read_head->local_end - source : -1;
-// }
-// // readImport
-// bool ri () {
-//   printf("Testing %d\n", import_read_head);
-//   if (import_read_head == NULL)
-//     import_read_head = first_import;
-//   else
-//     import_read_head = import_read_head->next;
-//   if (import_read_head == NULL)
-//     return false;
-//   return true;
-// }
-// // readExport
-// bool re () {
-//   if (export_read_head == NULL)
-//     export_read_head = first_export;
-//   else
-//     export_read_head = export_read_head->next;
-//   if (export_read_head == NULL)
-//     return false;
-//   return true;
-// }
-// bool f () {
-//   return facade;
-// }
+// Appends a binding at tail, as the import it belongs to is only added once
+// its specifier is read.
+static void addBinding (State *state, ImportBinding*** tail, const char16_t* imported_start, const char16_t* imported_end, const char16_t* local_start, const char16_t* local_end, uint32_t flags) {
+  ImportBinding *binding = state->alloc(sizeof(ImportBinding), state->user_data);
+  binding->imported_start = imported_start;
+  binding->imported_end = imported_end;
+  binding->local_start = local_start;
+  binding->local_end = local_end;
+  binding->flags = flags;
+  binding->next = NULL;
+  **tail = binding;
+  *tail = &binding->next;
+}
 
 bool parse ();
+ParseContext* parse_init (char16_t *source, uint32_t sourceLen, uint32_t options, Allocator alloc, void *user_data, ParseResult *result);
+// Lexes the tokens starting in the next maxLen code units, or up to the end of
+// the source, returning ParsePending while there's more to lex. The result is
+// complete once it returns ParseOk or ParseFailed.
+enum ParseStatus parse_step (ParseContext* ctx, uint32_t maxLen);
+// Lexes each region of the source as a module of its own in place, into one
+// result per region allocated from the one arena, stopping at the first
+// region that fails. Records point into the whole source, and parse_error and
+// line_starts are offsets of it too, with the line starts of the whole source
+// shared by all of the results, so nothing needs shifting. Regions must lie
+// within the source, and as with any source the code unit after a region may
+// be read as lookahead, so they should end at a token boundary, as scripts do
+// before their </script>. Returns the number of regions lexed without error,
+// where regionCount means all of them.
+uint32_t parse_regions (char16_t* source, uint32_t sourceLen, const Region* regions, uint32_t regionCount, uint32_t options, Allocator alloc, void* user_data, ParseResult* results);
+
+// Line (from 1) and column (from 0) of an offset, by binary search of the line
+// starts collected with the LineStarts option. With no line starts, the offset
+// is on the first line.
+static inline void lineCol (const uint32_t* lineStarts, uint32_t lineCount, uint32_t offset, uint32_t* line, uint32_t* column) {
+  uint32_t lo = 0, hi = lineCount;
+  while (hi - lo > 1) {
+    uint32_t mid = (lo + hi) / 2;
+    if (lineStarts[mid] <= offset)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  *line = lo + 1;
+  *column = lineCount ? offset - lineStarts[lo] : offset;
+}
+int32_t unescape (const char16_t* start, const char16_t* end, char16_t* out);
+
+#ifdef LEXER_PACK
+int32_t* parse_packed (char16_t* source, uint32_t sourceLen, uint32_t options, Allocator alloc, void* user_data, uint32_t* packedLen);
+int32_t** parse_regions_packed (char16_t* source, uint32_t sourceLen, const Region* regions, uint32_t regionCount, uint32_t options, Allocator alloc, void* user_data, uint32_t* packedCount, uint32_t* packedLens);
+#endif
+
+#ifdef LEXER_JS
+char16_t* sa (uint32_t len);
+void ses (char16_t* ptr);
+int32_t* p (uint32_t options);
+void ps (uint32_t options);
+int32_t* pn (uint32_t maxLen);
+Region* ra (uint32_t count);
+int32_t** pr (uint32_t options, Region* regions, uint32_t count);
+char16_t* us (uint32_t len);
+int32_t u (char16_t* ptr, uint32_t len);
+#endif
+
+static bool initState (State *state, char16_t *source, uint32_t sourceLen, uint32_t options, Allocator alloc, void *user_data, ParseResult *result, OpenToken* openTokenStack, Import** dynamicImportStack);
+static bool lexSlice (State *state, char16_t* sliceEnd);
+static const uint8_t* actionTable (State *state);
+static bool finishParse (State *state);
+static bool recoverError (State *state);
+static void dropImport (State *state, Import* drop);
+static void fingerprintShape (State *state);
+static uint64_t hashUnits (uint64_t hash, const char16_t* pos, const char16_t* end);
+static uint64_t hashString (State *state, uint64_t hash, const char16_t* start, const char16_t* end);
+static uint64_t hashName (State *state, uint64_t hash, const char16_t* start, const char16_t* end);
+static uint64_t mix64 (uint64_t hash);
+static const char16_t* findStatementLine (const char16_t* pos, const char16_t* end);
+static char16_t* readDirectives (const char16_t* source, const char16_t* end, ModuleMeta* meta);
+static const char16_t* skipCommentWhitespace (const char16_t* pos, const char16_t* end, bool* br);
+static void endPrologue (State *state, const char16_t* pos);
+
+static void tryParseImportStatement (State *state);
+static void tryParseExportStatement (State *state);
+static void tryParseRequire (State *state);
+static void tryParseCjsExports (State *state);
+static void tryParseDefineProperty (State *state);
+static void tryParseAwait (State *state);
+static bool isFunctionBrace (State *state, char16_t* pos);
+static bool inArrowBody (State *state, char16_t* pos);
+
+static void readImportString (State *state, const char16_t* ss, char16_t ch);
+static void readSpecifier (State *state, Import* import);
+static ImportBinding* readImportBindings (State *state, char16_t ch);
+static void readNamedImports (State *state, ImportBinding*** tail);
+static char16_t readImportName (State *state, char16_t ch);
+static bool readImportAttributes (State *state, Attribute** first);
+static void tryParseDynamicImportAttributes (State *state);
+static char16_t readExportAs (State *state, char16_t* startPos, char16_t* endPos);
+static bool skipTypeModifier (State *state);
+static bool tryParseTypeExport (State *state);
+
+static bool isJsxStart (State *state);
+static void jsxElement (State *state);
+static void skipAngleBrackets (State *state);
+static void jsx (State *state, bool inTag);
 
-void tryParseImportStatement (State *state);
-void tryParseExportStatement (State *state);
-void tryParseRequire (State *state);
+static char16_t commentWhitespace (State *state, bool br);
+static void regularExpression (State *state);
+static void templateString (State *state);
+static void blockComment (State *state, bool br);
+static void lineComment (State *state);
+static void stringLiteral (State *state, char16_t quote);
 
-void readImportString (State *state, const char16_t* ss, char16_t ch);
-char16_t readExportAs (State *state, char16_t* startPos, char16_t* endPos);
+static char16_t readToWsOrPunctuator (State *state, char16_t ch);
 
-char16_t commentWhitespace (State *state, bool br);
-void regularExpression (State *state);
-void templateString (State *state);
-void blockComment (State *state, bool br);
-void lineComment (State *state);
-void stringLiteral (State *state, char16_t quote);
+static uint32_t* collectLineStarts (const char16_t* source, const char16_t* end, Allocator alloc, void* user_data, uint32_t* count);
+static bool hasModuleKeyword (const char16_t* source, const char16_t* end);
+static bool isModuleKeyword (const char16_t* pos, const char16_t* end);
 
-char16_t readToWsOrPunctuator (State *state, char16_t ch);
+#ifdef LEXER_SIMD
+static char16_t* skipToAny (char16_t* pos, char16_t* end, char16_t c1, char16_t c2, char16_t c3, char16_t c4);
+static char16_t* skipInert (State *state, char16_t* pos);
+#endif
 
-bool isQuote (char16_t ch);
+static bool isQuote (char16_t ch);
 
-bool isBr (char16_t c);
-bool isWsNotBr (char16_t c);
-bool isBrOrWs (char16_t c);
-bool isBrOrWsOrPunctuator (char16_t c);
-bool isBrOrWsOrPunctuatorNotDot (char16_t c);
+static bool isBr (char16_t c);
+static bool isWsNotBr (char16_t c);
+static bool isBrOrWs (char16_t c);
+static bool isBrOrWsOrPunctuatorNotDot (char16_t c);
 
-bool readPrecedingKeyword1(State *state, char16_t* pos, char16_t c1);
-bool readPrecedingKeywordn(State *state, char16_t* pos, const char16_t* compare, size_t n);
+static bool readPrecedingKeyword1(State *state, char16_t* pos, char16_t c1);
+static bool readPrecedingKeywordn(State *state, char16_t* pos, const char16_t* compare, size_t n);
 
-bool isBreakOrContinue (State *state, char16_t* curPos);
+static bool isBreakOrContinue (State *state, char16_t* curPos);
 
-bool keywordStart (State *state);
-bool isExpressionKeyword (State *state, char16_t* pos);
-bool isParenKeyword (State *state, char16_t* pos);
-bool isPunctuator (char16_t charCode);
-bool isExpressionPunctuator (char16_t charCode);
-bool isExpressionTerminator (State *state, char16_t* pos);
-bool isIdentifierChar(uint32_t code);
-uint32_t nextChar(State *state);
+static bool keywordStart (State *state);
+static char16_t beforeLastToken (State *state);
+static bool isExpressionKeyword (State *state, char16_t* pos);
+static bool isParenKeyword (State *state, char16_t* pos);
+static bool isPunctuator (char16_t charCode);
+static bool isExpressionPunctuator (char16_t charCode);
+static bool isExpressionTerminator (State *state, char16_t* pos);
+static bool isNonNullAssertion (State *state, char16_t* pos);
+static bool isWordAt (const char16_t* pos, const char16_t* compare, size_t n);
+static bool isIdentifierChar(uint32_t code);
+static bool readHex (const char16_t** pos, const char16_t* end, int digits, uint32_t* out);
+static char16_t* writeCodePoint (char16_t* out, uint32_t c);
+static uint32_t nextChar(State *state);
+#ifndef LEXER_UTF16
 static void *utf8_decode(void *buf, uint32_t *c, int *e);
+#endif
 
 
-void syntaxError (State *state);
+static void syntaxError (State *state);
@@ -62,6 +62,129 @@ export interface ImportSpecifier {
    * Otherwise this is `-1`.
    */
   readonly a: number;
+
+  /**
+   * Import attributes as decoded `[key, value]` pairs, from either `with` or
+   * `assert` clauses and the options of dynamic imports, or `null` when there
+   * are none. Values with invalid escapes are `undefined`.
+   *
+   * @example
+   * const [imports] = parse(`import json from './foo.json' with { type: 'json' }`);
+   * imports[0].at;
+   * // Returns [['type', 'json']]
+   */
+  readonly at: ReadonlyArray<readonly [key: string, value: string | undefined]> | null;
+
+  /**
+   * Names bound by a static import statement, or `null` when there are none.
+   *
+   * @example
+   * const [imports] = parse(`import a, { b as c } from 'd'`);
+   * imports[0].b.map(b => [b.n, b.ln]);
+   * // Returns [[undefined, 'a'], ['b', 'c']]
+   */
+  readonly b: ReadonlyArray<ImportBinding> | null;
+
+  /**
+   * Whether this is the import of an `export * from` statement, which
+   * re-exports all of the module's exports.
+   */
+  readonly star: boolean;
+
+  /**
+   * With the `specifiers` option, the class of a string specifier without
+   * escapes, otherwise `SpecifierKind.None`.
+   */
+  readonly k: SpecifierKind;
+  /**
+   * With the `specifiers` option, the end of the package name of a bare
+   * specifier, at the `/` before its subpath or the end of the specifier.
+   * Otherwise `-1`.
+   *
+   * @example
+   * const source = `import '@scope/pkg/sub.js'`;
+   * const [imports] = parse(source, '@', { specifiers: true });
+   * source.slice(imports[0].s, imports[0].ps);
+   * // Returns "@scope/pkg"
+   */
+  readonly ps: number;
+  /**
+   * With the `specifiers` option, the 64-bit FNV-1a hash of the UTF-8 encoding
+   * of a classified specifier as 16 hex digits, for use as a cache key.
+   */
+  readonly h: string | undefined;
+  /**
+   * With the `typescript` option, whether this is the import of an
+   * `import type` or `export type ... from` statement, which is erased when
+   * compiled to JS.
+   */
+  readonly t: boolean;
+}
+
+/**
+ * Classes of string specifiers, matching SpecifierKind in lexer.h.
+ */
+export enum SpecifierKind {
+  /** Not a string literal, or has escapes */
+  None = 0,
+  /** `./` or `../`, or just `.` or `..` */
+  Relative = 1,
+  /** `/` */
+  Absolute = 2,
+  /** A URL scheme, as `node:`, `data:` or `https:` */
+  Url = 3,
+  /** A package name, which may be `@scope/name`, and subpath */
+  Bare = 4,
+  /** A `#` subpath import of package.json `"imports"` */
+  Imports = 5
+}
+
+export interface ImportBinding {
+  /**
+   * Imported name, decoded when it's a string, or undefined for default,
+   * namespace and phase imports.
+   */
+  readonly n: string | undefined;
+  /**
+   * Local name
+   */
+  readonly ln: string;
+  /**
+   * Start of the imported name, including any quotes, or -1.
+   */
+  readonly s: number;
+  /**
+   * End of the imported name, or -1.
+   */
+  readonly e: number;
+  /**
+   * Start of the local name
+   */
+  readonly ls: number;
+  /**
+   * End of the local name
+   */
+  readonly le: number;
+  /**
+   * Whether this binds the default export, as `import a` or
+   * `import { default as a }`.
+   */
+  readonly d: boolean;
+  /**
+   * Whether this binds the namespace object, as `import * as ns`.
+   */
+  readonly ns: boolean;
+  /**
+   * Whether this follows an import phase, as `import source a` or
+   * `import defer * as ns`.
+   */
+  readonly ph: boolean;
+  /**
+   * With the `typescript` option, whether this has its own `type` modifier,
+   * as `import { type a }`. Names of an `import type` statement instead have
+   * the `t` of their import set.
+   */
+  readonly t: boolean;
 }
 
 export interface ExportSpecifier {
@@ -136,6 +259,189 @@ export interface ExportSpecifier {
    * End of local name, or -1.
    */
   readonly le: number;
+
+  /**
+   * Whether this is a CommonJS export assignment, detected with the
+   * `cjsExports` option. CommonJS exports have no local name.
+   *
+   * @example
+   * const source = `exports.a = 1; module.exports = { b, c: d }`;
+   * const [imports, exports] = parse(source, '@', { cjsExports: true });
+   * exports.map(e => e.n);
+   * // Returns ["a", "b", "c"]
+   */
+  readonly cjs: boolean;
+
+  /**
+   * For a re-export, the index in the imports of the import of the module
+   * it re-exports from, or -1. Namespace re-exports (`export * as ns from`)
+   * have no imported name.
+   *
+   * @example
+   * const source = `export { a as b } from 'c'`;
+   * const [imports, exports] = parse(source);
+   * imports[exports[0].ri].n;
+   * // Returns "c"
+   * exports[0].rn;
+   * // Returns "a"
+   */
+  readonly ri: number;
+  /**
+   * Name imported by a named re-export, or undefined.
+   */
+  readonly rn: string | undefined;
+  /**
+   * Start of the name imported by a named re-export, or -1.
+   */
+  readonly rs: number;
+  /**
+   * End of the name imported by a named re-export, or -1.
+   */
+  readonly re: number;
+
+  /**
+   * With the `typescript` option, whether this is a type-only export: a type
+   * alias, interface, or name of an `export type` statement or with its own
+   * `type` modifier.
+   *
+   * @example
+   * const source = `export type { A }; export interface B {}; export enum C {}`;
+   * const [imports, exports] = parse(source, '@', { typescript: true });
+   * exports.map(e => [e.n, e.t]);
+   * // Returns [["A", true], ["B", true], ["C", false]]
+   */
+  readonly t: boolean;
+}
+
+export interface ParseOptions {
+  /**
+   * Also return the sorted offsets of the start of every line, for use with
+   * `lineCol`. Lines are split on `\n`.
+   */
+  readonly lineStarts?: boolean;
+  /**
+   * Also detect CommonJS exports (`exports.a =`, `module.exports.a =`,
+   * `Object.defineProperty(exports, 'a', ...)` and the keys of
+   * `module.exports = { ... }`) as exports with the `cjs` flag. The
+   * `__esModule` marker is reported as an export of that name.
+   */
+  readonly cjsExports?: boolean;
+  /**
+   * Skip lexing sources in which `import`, `export` and `require` never
+   * appear, returning no imports or exports after a fast search. A fifth
+   * `fastRejected` value is returned, set when lexing was skipped, in which
+   * case syntax errors aren't detected, `facade` is false and no line starts
+   * are collected.
+   */
+  readonly fastReject?: boolean;
+  /**
+   * Also return a sixth `ModuleMeta` value summarizing the module, after the
+   * `fastRejected` value.
+   */
+  readonly meta?: boolean;
+  /**
+   * Instead of throwing on a syntax error, resume lexing from the next line
+   * starting with an `import` or `export` statement, and return the
+   * `ErrorRange`s recovered from as a seventh value.
+   */
+  readonly recover?: boolean;
+  /**
+   * Classify string specifiers as `k`, with the package name split `ps` of
+   * bare specifiers, and hash them as `h`, so resolvers need no further
+   * string work.
+   */
+  readonly specifiers?: boolean;
+  /**
+   * Return the `ModuleMeta` as with `meta`, including its `fingerprint`.
+   */
+  readonly fingerprint?: boolean;
+  /**
+   * Skip over JSX elements, so their text and attributes aren't lexed as JS.
+   */
+  readonly jsx?: boolean;
+  /**
+   * Lex TypeScript import and export syntax: type-only imports, exports and
+   * bindings are returned with `t` set rather than dropped, declarations
+   * such as `export enum` and `export namespace` are exported, and
+   * `import a = require('b')` is a `require` import.
+   */
+  readonly typescript?: boolean;
+}
+
+/**
+ * A region in which lexing failed, with the `recover` option, from the last
+ * import or export before the error to where lexing resumed, or the end of
+ * the source. Imports and exports inside it may be missing.
+ */
+export interface ErrorRange {
+  readonly s: number;
+  readonly e: number;
+  /**
+   * Where the error was found, as the `idx` of the error thrown without
+   * `recover`.
+   */
+  readonly idx: number;
+}
+
+/**
+ * Facts about the module as a whole, gathered in the same pass as the
+ * imports and exports. Offsets are of the first occurrence, or -1.
+ */
+export interface ModuleMeta {
+  /**
+   * Start of an `await` outside of any function.
+   */
+  readonly topLevelAwait: number;
+  /**
+   * Start of an `import.meta`.
+   */
+  readonly importMeta: number;
+  /**
+   * Start of a `require` call or reference, as returned as an import.
+   */
+  readonly require: number;
+  /**
+   * Start of the first statement after the leading import and export
+   * declarations, or the source length when there is none. -1 when fast
+   * rejected.
+   */
+  readonly prologueEnd: number;
+  /**
+   * Whether the directive prologue has a `"use strict"` directive.
+   */
+  readonly useStrict: boolean;
+  /**
+   * Whether the source starts with a `#!` line.
+   */
+  readonly hashbang: boolean;
+  /**
+   * With the `fingerprint` option, a 64-bit hash of the module's shape as 16
+   * hex digits: the decoded specifiers of its imports with their kinds,
+   * attributes and bindings, and its export names with the names they
+   * re-export, independent of their order. Edits that leave it unchanged don't
+   * change how the module links.
+   */
+  readonly fingerprint?: string;
+}
+
+// wasm parse option bit flags
+const OPTION_LINE_STARTS = 1;
+const OPTION_CJS_EXPORTS = 2;
+const OPTION_FAST_REJECT = 4;
+const OPTION_RECOVER = 8;
+const OPTION_SPECIFIERS = 16;
+const OPTION_FINGERPRINT = 32;
+const OPTION_JSX = 64;
+const OPTION_TYPESCRIPT = 128;
+
+/**
+ * @internal Shared with the worker pool.
+ */
+export function parseOptionFlags (options: ParseOptions): number {
+  return (options.lineStarts ? OPTION_LINE_STARTS : 0) | (options.cjsExports ? OPTION_CJS_EXPORTS : 0) |
+      (options.fastReject ? OPTION_FAST_REJECT : 0) | (options.recover ? OPTION_RECOVER : 0) |
+      (options.specifiers ? OPTION_SPECIFIERS : 0) | (options.fingerprint ? OPTION_FINGERPRINT : 0) |
+      (options.jsx ? OPTION_JSX : 0) | (options.typescript ? OPTION_TYPESCRIPT : 0);
 }
 
 const isLE = new Uint8Array(new Uint16Array([1]).buffer)[0] === 1;
@@ -146,58 +452,337 @@ const isLE = new Uint8Array(new Uint16Array([1]).buffer)[0] === 1;
  *
  * @param source Source code to parser
  * @param name Optional sourcename
+ * @param options Optional outputs
  * @returns Tuple contaning imports list and exports list.
  */
-export function parse (source: string, name = '@'): readonly [
+export function parse (source: string, name = '@', options: ParseOptions = {}): readonly [
   imports: ReadonlyArray<ImportSpecifier>,
   exports: ReadonlyArray<ExportSpecifier>,
-  facade: boolean
+  facade: boolean,
+  lineStarts?: Uint32Array,
+  fastRejected?: boolean,
+  meta?: ModuleMeta,
+  errors?: ReadonlyArray<ErrorRange>
 ] {
   if (!wasm)
     // actually returns a promise if init hasn't resolved (not type safe).
     // casting to avoid a breaking type change.
-    return init.then(() => parse(source)) as unknown as ReturnType<typeof parse>;
+    return init.then(() => parse(source, name, options)) as unknown as ReturnType<typeof parse>;
+
+  setSource(wasm, source);
 
+  // parsing may grow memory, so the buffer is only read after it returns
+  const result = new Int32Array(wasm.memory.buffer, wasm.p(parseOptionFlags(options)));
+  return readParseResult(source, result, name, options);
+}
+
+function setSource (instance: typeof wasm, source: string) {
   const len = source.length + 1;
 
-  // need 2 bytes per code point plus analysis space so we double again
-  const extraMem = (wasm.__heap_base.value || wasm.__heap_base) as number + len * 4 - wasm.memory.buffer.byteLength;
+  // the wasm build lexes UTF-16 code units as-is, so no re-encoding is needed
+  // need 2 bytes per code unit plus analysis space so we double again
+  const extraMem = (instance.__heap_base.value || instance.__heap_base) as number + len * 4 - instance.memory.buffer.byteLength;
   if (extraMem > 0)
-    wasm.memory.grow(Math.ceil(extraMem / 65536));
+    instance.memory.grow(Math.ceil(extraMem / 65536));
 
-  const addr = wasm.sa(len - 1);
-  (isLE ? copyLE : copyBE)(source, new Uint16Array(wasm.memory.buffer, addr, len));
+  const addr = instance.sa(len - 1);
+  (isLE ? copyLE : copyBE)(source, new Uint16Array(instance.memory.buffer, addr, len));
+}
 
-  if (!wasm.parse())
-    throw Object.assign(new Error(`Parse error ${name}:${source.slice(0, wasm.e()).split('\n').length}:${wasm.e() - source.lastIndexOf('\n', wasm.e() - 1)}`), { idx: wasm.e() });
+/**
+ * Parses each `[start, end)` range of the source as a module of its own, such
+ * as the `<script type="module">` blocks of an HTML file or single-file
+ * component, returning the `parse` result of each in order. The source is
+ * copied in once and each region lexed in place, and all offsets, including
+ * line starts and the `idx` of a parse error, are of the whole source, so
+ * nothing needs shifting. Throws the first parse error.
+ *
+ * Regions should end at a token boundary, as scripts do before their
+ * `</script>`, since the code unit after a region may be read as lookahead.
+ *
+ * @param source Source code containing the regions
+ * @param regions Start and end offsets of each region
+ * @param name Optional sourcename
+ * @param options Optional outputs, for every region
+ */
+export function parseRegions (source: string, regions: ReadonlyArray<readonly [start: number, end: number]>, name = '@', options: ParseOptions = {}): ReturnType<typeof parse>[] {
+  if (!wasm)
+    return init.then(() => parseRegions(source, regions, name, options)) as unknown as ReturnType<typeof parseRegions>;
 
-  const imports: ImportSpecifier[] = [], exports: ExportSpecifier[] = [];
-  while (wasm.ri()) {
-    const s = wasm.is(), e = wasm.ie(), a = wasm.ai(), d = wasm.id(), ss = wasm.ss(), se = wasm.se();
-    let n;
-    if (wasm.ip())
-      n = decode(source.slice(d === -1 ? s - 1 : s, d === -1 ? e + 1 : e));
-    imports.push({ n, s, e, ss, se, d, a });
+  const offsets = regionOffsets(source.length, regions);
+  setSource(wasm, source);
+  const regionsAddr = wasm.ra(regions.length);
+  new Uint32Array(wasm.memory.buffer, regionsAddr, offsets.length).set(offsets);
+
+  const addr = wasm.pr(parseOptionFlags(options), regionsAddr, regions.length);
+  const packed = new Uint32Array(wasm.memory.buffer, addr, regions.length);
+  const results: ReturnType<typeof parse>[] = [];
+  for (let i = 0; i < regions.length; i++)
+    results.push(readParseResult(source, new Int32Array(wasm.memory.buffer, packed[i]), name, options));
+  return results;
+}
+
+/**
+ * Flattens regions into start and end pairs, checking they lie within the
+ * source.
+ *
+ * @internal Shared with the native addon.
+ */
+export function regionOffsets (sourceLength: number, regions: ReadonlyArray<readonly [start: number, end: number]>): Uint32Array {
+  const offsets = new Uint32Array(regions.length * 2);
+  for (let i = 0; i < regions.length; i++) {
+    const [start, end] = regions[i];
+    if (!(Number.isInteger(start) && Number.isInteger(end) && 0 <= start && start <= end && end <= sourceLength))
+      throw new RangeError(`Invalid region [${start}, ${end}) of a source of length ${sourceLength}`);
+    offsets[i * 2] = start;
+    offsets[i * 2 + 1] = end;
   }
-  while (wasm.re()) {
-    const s = wasm.es(), e = wasm.ee(), ls = wasm.els(), le = wasm.ele();
-    const n = source.slice(s, e), ch = n[0];
-    const ln = ls < 0 ? undefined : source.slice(ls, le), lch = ln ? ln[0] : '';
-    exports.push({
-      s, e, ls, le,
-      n: (ch === '"' || ch === "'") ? decode(n) : n,
-      ln: (lch === '"' || lch === "'") ? decode(ln) : ln,
-    });
+  return offsets;
+}
+
+export interface ParseAsyncOptions extends ParseOptions {
+  /**
+   * Number of code units lexed between yields to the host, defaulting to
+   * 64Ki. Slices end at the next token boundary.
+   */
+  readonly sliceLength?: number;
+}
+
+// parseAsync lexes on its own instance, so sliced parses can't be clobbered
+// by parse calls between slices, one source at a time.
+let asyncWasm: Promise<typeof wasm> | undefined;
+let asyncQueue: Promise<unknown> = Promise.resolve();
+
+const yieldToHost: () => Promise<unknown> = typeof (globalThis as any).scheduler?.yield === 'function'
+  ? () => (globalThis as any).scheduler.yield()
+  : typeof setImmediate === 'function'
+  ? () => new Promise(resolve => setImmediate(resolve))
+  : () => new Promise(resolve => setTimeout(resolve));
+
+/**
+ * Parses like `parse`, but in slices of `sliceLength` code units, yielding to
+ * the event loop between them through `scheduler.yield` where available or
+ * else `setImmediate` or `setTimeout`, so lexing large sources doesn't block
+ * other work for long. Concurrent calls are lexed one after another.
+ *
+ * @param source Source code to parser
+ * @param name Optional sourcename
+ * @param options Optional outputs and slice length
+ */
+export function parseAsync (source: string, name = '@', options: ParseAsyncOptions = {}): Promise<ReturnType<typeof parse>> {
+  const result = asyncQueue.then(() => parseSlices(source, name, options));
+  asyncQueue = result.catch(() => {});
+  return result;
+}
+
+async function parseSlices (source: string, name: string, options: ParseAsyncOptions) {
+  if (!asyncWasm)
+    // names are decoded by the main instance, so it's initialized too
+    asyncWasm = init.then(() => wasmModule).then(module => WebAssembly.instantiate(module)).then(instance => instance.exports as typeof wasm);
+  const instance = await asyncWasm;
+
+  setSource(instance, source);
+  instance.ps(parseOptionFlags(options));
+  let addr;
+  while ((addr = instance.pn(options.sliceLength || 65536)) === 0)
+    await yieldToHost();
+
+  return readParseResult(source, new Int32Array(instance.memory.buffer, addr), name, options);
+}
+
+/**
+ * Line (from 1) and column (from 0) of an offset, by binary search of the
+ * line starts returned when parsing with the `lineStarts` option. With no
+ * line starts, as for a fast rejected source, the offset is on the first line.
+ */
+export function lineCol (lineStarts: Uint32Array, offset: number): { line: number, column: number } {
+  let lo = 0, hi = lineStarts.length;
+  while (hi - lo > 1) {
+    const mid = (lo + hi) >>> 1;
+    if (lineStarts[mid] <= offset)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  return { line: lo + 1, column: lineStarts.length ? offset - lineStarts[lo] : offset };
+}
+
+/**
+ * What names are read from: the source string, or for the native addon's
+ * `Uint8Array` sources, a view decoding their bytes as UTF-8.
+ *
+ * @internal
+ */
+export type SourceText = Pick<string, 'slice' | 'charCodeAt'>;
+
+/**
+ * Builds the parse return value from the packed results of the wasm `p`
+ * export, throwing the parse error if there is one.
+ *
+ * @internal Shared with the worker pool, which transfers results back as
+ * packed Int32Arrays.
+ */
+export function readParseResult (source: SourceText, result: Int32Array, name = '@', options: ParseOptions = {}): ReturnType<typeof parse> {
+  const importCount = result[0], exportCount = result[1], flags = result[2], err = result[3], lineCount = result[4], attributeCount = result[5], bindingCount = result[6], errorCount = result[11];
+  const attributesStart = 14 + importCount * 15 + exportCount * 9;
+  const bindingsStart = attributesStart + attributeCount * 4;
+  const errorsStart = bindingsStart + bindingCount * 5;
+  const linesStart = errorsStart + errorCount * 3;
+
+  if (err !== -1) {
+    const { line, column } = lineCol(new Uint32Array(result.buffer, result.byteOffset + linesStart * 4, lineCount), err);
+    throw Object.assign(new Error(`Parse error ${name}:${line}:${column + 1}`), { idx: err });
   }
 
-  function decode (str: string | undefined) {
-    try {
-      return (0, eval)(str as string) // eval(undefined) -> undefined
+  const imports: ImportSpecifier[] = [], exports: ExportSpecifier[] = [];
+  let i = 14, attribute = attributesStart, binding = bindingsStart;
+  for (const importEnd = i + importCount * 15; i < importEnd; i += 15) {
+    const attributesEnd = attribute + result[i + 7] * 4;
+    const attributes = attribute === attributesEnd ? null : result.slice(attribute, attribute = attributesEnd);
+    let bindings: Binding[] | null = null;
+    for (const bindingsEnd = binding + result[i + 8] * 5; binding < bindingsEnd; binding += 5) {
+      // BindingFlags of lexer.h
+      const flags = result[binding + 4];
+      (bindings = bindings || []).push(record<ImportBinding>({
+        s: result[binding], e: result[binding + 1], ls: result[binding + 2], le: result[binding + 3],
+        d: (flags & 1) !== 0, ns: (flags & 2) !== 0, ph: (flags & 4) !== 0, t: (flags & 8) !== 0
+      }, source, bindingAccessors));
     }
-    catch (e) {}
+    imports.push(record<ImportSpecifier>({
+      s: result[i], e: result[i + 1], ss: result[i + 2], se: result[i + 3], d: result[i + 5], a: result[i + 4],
+      b: bindings, star: result[i + 9] !== 0, k: result[i + 10], ps: result[i + 11], t: result[i + 14] !== 0
+    }, [source, result[i + 6] !== 0, attributes, result[i + 12], result[i + 13]], importAccessors));
   }
+  for (const exportEnd = i + exportCount * 9; i < exportEnd; i += 9)
+    exports.push(record<ExportSpecifier>({
+      s: result[i], e: result[i + 1], ls: result[i + 2], le: result[i + 3], cjs: result[i + 4] !== 0,
+      ri: result[i + 5], rs: result[i + 6], re: result[i + 7], t: result[i + 8] !== 0
+    }, source, exportAccessors));
+
+  const facade = (flags & 1) !== 0;
+  const lineStarts = options.lineStarts ? new Uint32Array(result.buffer, result.byteOffset + linesStart * 4, lineCount).slice() : undefined;
+  const meta: ModuleMeta | undefined = options.meta || options.fingerprint ? {
+    topLevelAwait: result[7],
+    importMeta: result[8],
+    require: result[9],
+    prologueEnd: result[10],
+    useStrict: (flags & 4) !== 0,
+    hashbang: (flags & 8) !== 0
+  } : undefined;
+  if (options.fingerprint)
+    (meta as { fingerprint?: string }).fingerprint = hex32(result[13]) + hex32(result[12]);
+  if (options.recover) {
+    const errors: ErrorRange[] = [];
+    for (let j = errorsStart; j < linesStart; j += 3)
+      errors.push({ s: result[j], e: result[j + 1], idx: result[j + 2] });
+    return [imports, exports, facade, lineStarts, (flags & 2) !== 0, meta, errors];
+  }
+  if (meta)
+    return [imports, exports, facade, lineStarts, (flags & 2) !== 0, meta];
+  if (options.fastReject)
+    return [imports, exports, facade, lineStarts, (flags & 2) !== 0];
+  if (lineStarts)
+    return [imports, exports, facade, lineStarts];
+  return [imports, exports, facade];
+}
+
+// n and ln are only materialized when read, so callers that only need spans
+// never create strings. Records are plain objects, with those fields as own
+// enumerable accessors that replace themselves with their value on first
+// read, so they still spread, print and compare as before. What they are
+// decoded from is kept in a non-enumerable _ field.
+function record<T> (fields: object, data: unknown, accessors: PropertyDescriptorMap): T {
+  Object.defineProperty(fields, '_', { value: data });
+  return Object.defineProperties(fields, accessors) as T;
+}
+
+function lazy<T> (name: string, get: (record: T) => unknown): PropertyDescriptor {
+  return {
+    get (this: T) {
+      const value = get(this);
+      Object.defineProperty(this, name, { value, enumerable: true });
+      return value;
+    },
+    enumerable: true,
+    configurable: true
+  };
+}
+
+// the source, whether the specifier is safe to decode, the [ks, ke, vs, ve]
+// spans per attribute and the low and high halves of the hash
+type ImportRecord = ImportSpecifier & { _: readonly [SourceText, boolean, Int32Array | null, number, number] };
+type ExportRecord = ExportSpecifier & { _: SourceText };
+type BindingRecord = ImportBinding & { _: SourceText };
+
+const importAccessors: PropertyDescriptorMap = {
+  n: lazy('n', ({ _: [source, safe], s, e, d }: ImportRecord) =>
+    !safe ? undefined : d === -1 ? decode(source, s, e) : decode(source, s + 1, e - 1)),
+  at: lazy('at', ({ _: [source, , spans] }: ImportRecord) => {
+    if (!spans)
+      return null;
+    const at: [string, string | undefined][] = [];
+    for (let i = 0; i < spans.length; i += 4)
+      at.push([decode(source, spans[i], spans[i + 1]) ?? source.slice(spans[i], spans[i + 1]), decode(source, spans[i + 2], spans[i + 3])]);
+    return at;
+  }),
+  h: lazy('h', ({ _: [, , , hl, hh], k }: ImportRecord) =>
+    k === SpecifierKind.None ? undefined : hex32(hh) + hex32(hl))
+};
+
+function hex32 (n: number) {
+  return (0x100000000 + (n >>> 0)).toString(16).slice(1);
+}
+
+const exportAccessors: PropertyDescriptorMap = {
+  n: lazy('n', ({ _: source, s, e }: ExportRecord) => readName(source, s, e)),
+  ln: lazy('ln', ({ _: source, ls, le }: ExportRecord) => ls < 0 ? undefined : readName(source, ls, le)),
+  rn: lazy('rn', ({ _: source, rs, re }: ExportRecord) => rs < 0 ? undefined : readName(source, rs, re))
+};
+
+const bindingAccessors: PropertyDescriptorMap = {
+  n: lazy('n', ({ _: source, s, e }: BindingRecord) => s < 0 ? undefined : readName(source, s, e)),
+  ln: lazy('ln', ({ _: source, ls, le }: BindingRecord) => source.slice(ls, le))
+};
+
+function readName (source: SourceText, start: number, end: number) {
+  const ch = source.charCodeAt(start);
+  return ch === 34 || ch === 39 ? decode(source, start + 1, end - 1) : source.slice(start, end);
+}
+
+let nativeUnescape: ((str: string) => string | undefined) | undefined;
 
-  return [imports, exports, !!wasm.f()];
+/**
+ * @internal Used by the native addon so names are decoded without the wasm
+ * instance.
+ */
+export function setUnescape (unescape: (str: string) => string | undefined) {
+  nativeUnescape = unescape;
+}
+
+/**
+ * Decodes the string literal contents source[start, end) with the wasm (or
+ * native addon) unescape, returning undefined for an invalid escape.
+ */
+function decode (source: SourceText, start: number, end: number) {
+  const str = source.slice(start, end);
+  if (str.indexOf('\\') === -1 && str.indexOf('\r') === -1)
+    return str;
+  if (nativeUnescape)
+    return nativeUnescape(str);
+  const len = str.length;
+  const addr = wasm.us(len);
+  (isLE ? copyLE : copyBE)(str, new Uint16Array(wasm.memory.buffer, addr, len));
+  const outLen = wasm.u(addr, len);
+  if (outLen === -1)
+    return undefined;
+  const out = new Uint16Array(wasm.memory.buffer, addr, outLen);
+  if (!isLE)
+    for (let i = 0; i < outLen; i++)
+      out[i] = (out[i] & 0xff) << 8 | out[i] >>> 8;
+  let decoded = '';
+  for (let i = 0; i < outLen; i += 4096)
+    decoded += String.fromCharCode.apply(null, out.subarray(i, i + 4096) as unknown as number[]);
+  return decoded;
 }
 
 function copyBE (src: string, outBuf16: Uint16Array) {
@@ -219,48 +804,42 @@ function copyLE (src: string, outBuf16: Uint16Array) {
 let wasm: {
   __heap_base: {value: number} | number & {value: undefined};
   memory: WebAssembly.Memory;
-  parse(): boolean;
-  /** getAssertIndex */
-  ai(): number;
-  /** getErr */
-  e(): number;
-  /** getExportEnd */
-  ee(): number;
-  /** getExportLocalEnd */
-  ele(): number;
-  /** getExportLocalStart */
-  els(): number;
-  /** getExportStart */
-  es(): number;
-  /** facade */
-  f(): boolean;
-  /** getImportDynamic */
-  id(): number;
-  /** getImportEnd */
-  ie(): number;
-  /** getImportSafeString */
-  ip(): number;
-  /** getImportStart */
-  is(): number;
-  /** readExport */
-  re(): boolean;
-  /** readImport */
-  ri(): boolean;
+  /** parse, returning the address of the packed Int32Array results */
+  p(options: number): number;
+  /** parseStart, for parsing in slices with pn */
+  ps(options: number): void;
+  /** parseNext, returning the address of the packed results once done or 0 */
+  pn(maxLen: number): number;
+  /** parseRegions, returning the address of the addresses of the packed results of each region */
+  pr(options: number, regions: number, count: number): number;
+  /** allocateRegions, returning the address to write start and end pairs to */
+  ra(count: number): number;
   /** allocateSource */
   sa(utf16Len: number): number;
-  /** getImportStatementEnd */
-  se(): number;
-  /** getImportStatementStart */
-  ss(): number;
+  /** unescape, in place, returning the decoded length or -1 */
+  u(addr: number, utf16Len: number): number;
+  /** allocateScratch */
+  us(utf16Len: number): number;
 };
 
 
+// Smallest module using a SIMD128 instruction (i8x16.popcnt of a splat), used
+// to detect whether the SIMD build can be instantiated.
+const simd = WebAssembly.validate(new Uint8Array([0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1, 8, 0, 65, 0, 253, 15, 253, 98, 11]));
+
 /**
- * Wait for init to resolve before calling `parse`.
+ * The compiled lexer module.
+ *
+ * @internal Shared with the worker pool so the module is only compiled once.
  */
-export const init = WebAssembly.compile(
+export const wasmModule = WebAssembly.compile(
   (binary => typeof Buffer !== 'undefined' ? Buffer.from(binary, 'base64') : Uint8Array.from(atob(binary), x => x.charCodeAt(0)))
-  ('WASM_BINARY')
-)
+  (simd ? 'WASM_SIMD_BINARY' : 'WASM_BINARY')
+);
+
+/**
+ * Wait for init to resolve before calling `parse`.
+ */
+export const init = wasmModule
 .then(WebAssembly.instantiate)
 .then(({ exports }) => { wasm = exports as typeof wasm; });
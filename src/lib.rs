@@ -1,10 +1,37 @@
+pub mod binary;
+#[cfg(all(unix, feature = "daemon"))]
+pub mod daemon;
+pub mod graph;
+mod utf16;
+
+pub use utf16::Utf16Index;
+
 use bumpalo::Bump;
 use core::alloc::Layout;
-use std::{borrow::Cow, ffi::c_void, marker::PhantomData, mem::MaybeUninit, ptr, sync::atomic::AtomicPtr};
+use std::{borrow::Cow, ffi::c_void, marker::PhantomData, mem::MaybeUninit, ops::Range, sync::atomic::AtomicPtr};
 
 type Allocate = unsafe extern "C" fn(bytes: u32, user_data: *mut c_void) -> *mut c_void;
 extern "C" {
-  fn parse(ptr: *const u8, len: u32, alloc: Allocate, user_data: *mut c_void, result: *mut ParseResult) -> bool;
+  fn parse(
+    ptr: *const u8,
+    len: u32,
+    options: u32,
+    alloc: Allocate,
+    user_data: *mut c_void,
+    result: *mut ParseResult,
+  ) -> bool;
+  fn parse_regions(
+    ptr: *const u8,
+    len: u32,
+    regions: *const Region,
+    region_count: u32,
+    options: u32,
+    alloc: Allocate,
+    user_data: *mut c_void,
+    results: *mut ParseResult,
+  ) -> u32;
+  #[link_name = "unescape"]
+  fn unescape_literal(start: *const u8, end: *const u8, out: *mut u8) -> i32;
 }
 
 #[repr(C)]
@@ -16,6 +43,13 @@ pub struct Import<'a> {
   assert_index: *const u8,
   dynamic: *const u8,
   safe: bool,
+  star_reexport: bool,
+  type_only: bool,
+  specifier_kind: u32,
+  subpath_start: *const u8,
+  hash: u64,
+  attributes: *const Attribute<'a>,
+  bindings: *const ImportBinding<'a>,
   next: *const Import<'a>,
   phantom: PhantomData<&'a ()>,
 }
@@ -30,13 +64,35 @@ pub enum ImportKind {
   Meta,
 }
 
+/// The class of a string specifier, with `LexOptions::specifiers`.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum SpecifierKind {
+  /// Not a string literal, or has escapes.
+  None,
+  /// `./` or `../`, or just `.` or `..`.
+  Relative,
+  /// `/`.
+  Absolute,
+  /// A URL scheme, as `node:`, `data:` or `https:`.
+  Url,
+  /// A package name, which may be `@scope/name`, and subpath.
+  Bare,
+  /// A `#` subpath import of package.json `"imports"`.
+  Imports,
+}
+
 impl<'a> Import<'a> {
-  pub fn specifier(&self) -> Cow<'a, str> {
-    let (start, end) = if self.kind() == ImportKind::DynamicString {
+  // the specifier inside any quotes
+  fn specifier_range(&self) -> (*const u8, *const u8) {
+    if self.kind() == ImportKind::DynamicString {
       unsafe { (self.start.offset(1), self.end.offset(-1)) }
     } else {
       (self.start, self.end)
-    };
+    }
+  }
+
+  pub fn specifier(&self) -> Cow<'a, str> {
+    let (start, end) = self.specifier_range();
 
     let s =
       unsafe { std::str::from_utf8_unchecked(std::slice::from_raw_parts(start, end as usize - start as usize)) };
@@ -67,127 +123,236 @@ impl<'a> Import<'a> {
       ImportKind::DynamicExpression
     }
   }
-}
 
-fn unescape<'a>(s: &'a str) -> Result<Cow<'a, str>, ()> {
-  let mut cow = Cow::Borrowed(s);
-  let bytes = s.as_bytes();
-  let mut i = 0;
-  let mut si = 0;
-  while i < bytes.len() {
-    let start = i;
-    let b = bytes[i];
-    if b == b'\\' && i + 1 < bytes.len() {
-      i += 1;
-      let c = match bytes[i] {
-        b'n' => '\n',
-        b'r' => '\r',
-        b't' => '\t',
-        b'b' => 8 as char,
-        b'v' => 11 as char,
-        b'f' => 12 as char,
-        b'\r' | b'\n' => {
-          // Unicode new line characters after \ get removed from output in both
-          // template literals and strings
-          cow.to_mut().replace_range(si..si + 2, "");
-          i += 1;
-          continue;
-        }
-        b'x' => {
-          i += 1;
-          read_hex(bytes, &mut i, 2)?
-        }
-        b'u' if i + 1 < bytes.len() => {
-          i += 1;
-          if bytes[i] == b'{' {
-            i += 1;
-            if let Some(end) = bytes[i..].iter().position(|c| *c == b'}') {
-              let res = read_hex(bytes, &mut i, end)?;
-              i += 1;
-              res
-            } else {
-              return Err(());
-            }
-          } else {
-            read_hex(bytes, &mut i, 4)?
-          }
-        }
-        c if c >= b'0' && c <= b'7' => {
-          let mut total = c - b'0';
-          i += 1;
-          for _ in 0..2 {
-            if i < bytes.len() && bytes[i] >= b'0' && bytes[i] <= b'7' {
-              if let Some(t) = total.checked_mul(8).and_then(|t| t.checked_add(bytes[i] - b'0')) {
-                total = t;
-                i += 1;
-              } else {
-                break;
-              }
-            } else {
-              break;
-            }
-          }
-          if i < bytes.len() && (bytes[i] == b'8' || bytes[i] == b'9') {
-            return Err(());
-          }
-          total as char
-        }
-        c => c as char,
-      };
-
-      let mut buf = [0; 4];
-      let r = c.encode_utf8(&mut buf);
-      cow.to_mut().replace_range(si..si + i - start, r);
-      si += r.len();
+  /// The attributes of a `with` or `assert` clause, or of a dynamic import's
+  /// literal options object.
+  pub fn attributes(&self) -> ResultIter<'a, Attribute<'a>> {
+    ResultIter {
+      ptr: AtomicPtr::new(self.attributes as *mut Attribute),
+      lifetime: PhantomData,
+    }
+  }
+
+  /// Whether this is the import of an `export * from` statement, which
+  /// re-exports all of the module's exports.
+  pub fn is_star_reexport(&self) -> bool {
+    self.star_reexport
+  }
+
+  /// With `LexOptions::typescript`, whether this is the import of an
+  /// `import type` or `export type ... from` statement, which is erased when
+  /// compiled to JS.
+  pub fn is_type_only(&self) -> bool {
+    self.type_only
+  }
+
+  /// With `LexOptions::specifiers`, the class of a string specifier without
+  /// escapes, otherwise `SpecifierKind::None`.
+  pub fn specifier_kind(&self) -> SpecifierKind {
+    match self.specifier_kind {
+      1 => SpecifierKind::Relative,
+      2 => SpecifierKind::Absolute,
+      3 => SpecifierKind::Url,
+      4 => SpecifierKind::Bare,
+      5 => SpecifierKind::Imports,
+      _ => SpecifierKind::None,
+    }
+  }
+
+  /// With `LexOptions::specifiers`, the package name and subpath of a bare
+  /// specifier, as `("@scope/pkg", "/sub.js")` for `'@scope/pkg/sub.js'`.
+  /// The subpath is empty when there is none.
+  pub fn package_subpath(&self) -> Option<(&'a str, &'a str)> {
+    if self.subpath_start.is_null() {
+      return None;
+    }
+    let (start, end) = self.specifier_range();
+    unsafe {
+      Some((
+        std::str::from_utf8_unchecked(std::slice::from_raw_parts(
+          start,
+          self.subpath_start as usize - start as usize,
+        )),
+        std::str::from_utf8_unchecked(std::slice::from_raw_parts(
+          self.subpath_start,
+          end as usize - self.subpath_start as usize,
+        )),
+      ))
+    }
+  }
+
+  /// With `LexOptions::specifiers`, the 64-bit FNV-1a hash of the UTF-8 bytes
+  /// of a classified specifier, for use as a cache key.
+  pub fn specifier_hash(&self) -> Option<u64> {
+    if self.specifier_kind == 0 {
+      None
     } else {
-      si += 1;
-      i += 1;
+      Some(self.hash)
     }
   }
 
-  Ok(cow)
+  /// The names bound by a static import statement.
+  pub fn bindings(&self) -> ResultIter<'a, ImportBinding<'a>> {
+    ResultIter {
+      ptr: AtomicPtr::new(self.bindings as *mut ImportBinding),
+      lifetime: PhantomData,
+    }
+  }
 }
 
-fn read_hex(bytes: &[u8], pos: &mut usize, len: usize) -> Result<char, ()> {
-  let start = *pos;
-  let mut total: u32 = 0;
-  let mut last_code = 0;
-  for _ in 0..len {
-    let code = bytes[*pos];
+// binding flags, matching BindingFlags in lexer.h
+const BINDING_DEFAULT: u32 = 1;
+const BINDING_NAMESPACE: u32 = 2;
+const BINDING_PHASE: u32 = 4;
+const BINDING_TYPE: u32 = 8;
 
-    if code == b'_' {
-      if last_code == b'_' {
-        return Err(());
+/// A name bound by a static import statement, such as `b` of
+/// `import { a as b }`.
+#[repr(C)]
+pub struct ImportBinding<'a> {
+  imported_start: *const u8,
+  imported_end: *const u8,
+  local_start: *const u8,
+  local_end: *const u8,
+  flags: u32,
+  next: *const ImportBinding<'a>,
+  phantom: PhantomData<&'a ()>,
+}
+
+impl<'a> NextPtr for ImportBinding<'a> {
+  fn next(&self) -> *const Self {
+    self.next
+  }
+}
+
+impl<'a> ImportBinding<'a> {
+  /// The imported name, decoded when it's a string, or `None` for default,
+  /// namespace and phase imports.
+  pub fn imported(&self) -> Option<Cow<'a, str>> {
+    if self.imported_start.is_null() {
+      return None;
+    }
+    let s = unsafe {
+      std::str::from_utf8_unchecked(std::slice::from_raw_parts(
+        self.imported_start,
+        self.imported_end as usize - self.imported_start as usize,
+      ))
+    };
+    Some(match s.as_bytes()[0] {
+      b'"' | b'\'' => {
+        let s = &s[1..s.len() - 1];
+        unescape(s).unwrap_or(Cow::Borrowed(s))
       }
-      last_code = code;
-      *pos += 1;
-      continue;
+      _ => Cow::Borrowed(s),
+    })
+  }
+
+  pub fn local(&self) -> &'a str {
+    unsafe {
+      std::str::from_utf8_unchecked(std::slice::from_raw_parts(
+        self.local_start,
+        self.local_end as usize - self.local_start as usize,
+      ))
     }
+  }
 
-    let val = if code >= b'a' {
-      code - b'a' + 10
-    } else if code >= b'A' {
-      code - b'A' + 10
-    } else if code >= b'0' && code <= b'9' {
-      code - b'0'
-    } else {
-      break;
+  /// Whether this binds the default export, as `import a` or
+  /// `import { default as a }`.
+  pub fn is_default(&self) -> bool {
+    self.flags & BINDING_DEFAULT != 0
+  }
+
+  /// Whether this binds the namespace object, as `import * as ns`.
+  pub fn is_namespace(&self) -> bool {
+    self.flags & BINDING_NAMESPACE != 0
+  }
+
+  /// Whether this follows an import phase, as `import source a` or
+  /// `import defer * as ns`.
+  pub fn is_phase(&self) -> bool {
+    self.flags & BINDING_PHASE != 0
+  }
+
+  /// With `LexOptions::typescript`, whether this has its own `type` modifier,
+  /// as `import { type a }`. Bindings of an `import type` statement instead
+  /// have their import's `is_type_only` set.
+  pub fn is_type(&self) -> bool {
+    self.flags & BINDING_TYPE != 0
+  }
+}
+
+/// An import attribute, such as `type: 'json'`.
+#[repr(C)]
+pub struct Attribute<'a> {
+  key_start: *const u8,
+  key_end: *const u8,
+  value_start: *const u8,
+  value_end: *const u8,
+  value: *const u8,
+  value_len: i32,
+  key_quote: u8,
+  value_quote: u8,
+  next: *const Attribute<'a>,
+  phantom: PhantomData<&'a ()>,
+}
+
+impl<'a> NextPtr for Attribute<'a> {
+  fn next(&self) -> *const Self {
+    self.next
+  }
+}
+
+impl<'a> Attribute<'a> {
+  /// The key, decoded when it's a string.
+  pub fn key(&self) -> Cow<'a, str> {
+    let s = unsafe {
+      std::str::from_utf8_unchecked(std::slice::from_raw_parts(
+        self.key_start,
+        self.key_end as usize - self.key_start as usize,
+      ))
     };
+    if self.key_quote == 0 {
+      Cow::Borrowed(s)
+    } else {
+      unescape(s).unwrap_or(Cow::Borrowed(s))
+    }
+  }
+
+  /// The decoded value, or `None` when it has an invalid escape.
+  pub fn value(&self) -> Option<&'a str> {
+    if self.value_len < 0 {
+      return None;
+    }
+    std::str::from_utf8(unsafe { std::slice::from_raw_parts(self.value, self.value_len as usize) }).ok()
+  }
 
-    if val >= 16 {
-      break;
+  /// The quote of a string key, or `None` for an identifier.
+  pub fn key_quote(&self) -> Option<char> {
+    if self.key_quote == 0 {
+      None
+    } else {
+      Some(self.key_quote as char)
     }
+  }
 
-    last_code = code;
-    total = total * 16 + (val as u32);
-    *pos += 1;
+  pub fn value_quote(&self) -> char {
+    self.value_quote as char
   }
+}
 
-  if last_code == b'_' || *pos - start != len {
+/// Decodes the escapes of a string literal body, shared with the JS wrapper.
+fn unescape<'a>(s: &'a str) -> Result<Cow<'a, str>, ()> {
+  if !s.bytes().any(|b| b == b'\\' || b == b'\r') {
+    return Ok(Cow::Borrowed(s));
+  }
+  let mut out: Vec<u8> = Vec::with_capacity(s.len());
+  let range = s.as_bytes().as_ptr_range();
+  let len = unsafe { unescape_literal(range.start, range.end, out.as_mut_ptr()) };
+  if len < 0 {
     return Err(());
   }
-
-  Ok(unsafe { char::from_u32_unchecked(total) })
+  unsafe { out.set_len(len as usize) };
+  String::from_utf8(out).map(Cow::Owned).map_err(|_| ())
 }
 
 impl<'a> NextPtr for Import<'a> {
@@ -202,9 +367,24 @@ pub struct Export {
   end: *const u8,
   local_start: *const u8,
   local_end: *const u8,
+  cjs: bool,
+  type_only: bool,
+  kind: u32,
+  import_index: i32,
+  imported_start: *const u8,
+  imported_end: *const u8,
   next: *const Export,
 }
 
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum ExportKind {
+  Local,
+  /// `export { a as b } from`
+  ReexportNamed,
+  /// `export * as ns from`
+  ReexportNamespace,
+}
+
 impl NextPtr for Export {
   fn next(&self) -> *const Self {
     self.next
@@ -221,6 +401,51 @@ impl Export {
     }
   }
 
+  /// Whether this is a CommonJS export assignment, detected with
+  /// `LexOptions::cjs_exports`. Its local name is always `None`.
+  pub fn is_cjs(&self) -> bool {
+    self.cjs
+  }
+
+  /// With `LexOptions::typescript`, whether this is a type-only export: a type
+  /// alias, interface, or name of an `export type` statement or with its own
+  /// `type` modifier.
+  pub fn is_type_only(&self) -> bool {
+    self.type_only
+  }
+
+  pub fn kind(&self) -> ExportKind {
+    match self.kind {
+      1 => ExportKind::ReexportNamed,
+      2 => ExportKind::ReexportNamespace,
+      _ => ExportKind::Local,
+    }
+  }
+
+  /// For a re-export, the index in `LexResult::imports` of the import of the
+  /// module it re-exports from.
+  pub fn import_index(&self) -> Option<usize> {
+    if self.import_index < 0 {
+      None
+    } else {
+      Some(self.import_index as usize)
+    }
+  }
+
+  /// The name imported by a named re-export, including any quotes.
+  pub fn imported(&self) -> Option<&str> {
+    if self.imported_start.is_null() {
+      return None;
+    }
+
+    unsafe {
+      Some(std::str::from_utf8_unchecked(std::slice::from_raw_parts(
+        self.imported_start,
+        self.imported_end as usize - self.imported_start as usize,
+      )))
+    }
+  }
+
   pub fn local(&self) -> Option<&str> {
     if self.local_start.is_null() {
       return None;
@@ -240,15 +465,340 @@ struct ParseResult<'a> {
   first_import: *const Import<'a>,
   first_export: *const Export,
   parse_error: u32,
+  facade: bool,
+  line_starts: *const u32,
+  line_count: u32,
+  fast_rejected: bool,
+  meta: RawModuleMeta,
+  first_error: *const RawErrorRange,
+}
+
+#[repr(C)]
+struct Region {
+  start: u32,
+  end: u32,
+}
+
+#[repr(C)]
+struct RawErrorRange {
+  start: *const u8,
+  end: *const u8,
+  error: *const u8,
+  next: *const RawErrorRange,
 }
 
+#[repr(C)]
+struct RawModuleMeta {
+  top_level_await: *const u8,
+  import_meta: *const u8,
+  require: *const u8,
+  prologue_end: *const u8,
+  use_strict: bool,
+  hashbang: bool,
+  fingerprint: u64,
+}
+
+// parse option bit flags, matching ParseOption in lexer.h
+const OPTION_LINE_STARTS: u32 = 1;
+const OPTION_CJS_EXPORTS: u32 = 2;
+const OPTION_FAST_REJECT: u32 = 4;
+const OPTION_RECOVER: u32 = 8;
+const OPTION_SPECIFIERS: u32 = 16;
+const OPTION_FINGERPRINT: u32 = 32;
+const OPTION_JSX: u32 = 64;
+const OPTION_TYPESCRIPT: u32 = 128;
+
 pub struct LexResult<'a> {
-  bump: Bump,
+  // owns the arena the records are allocated from
+  _bump: Bump,
+  source: &'a str,
   first_import: *const Import<'a>,
   first_export: *const Export,
+  utf16: Option<Utf16Index<'a>>,
+  line_starts: *const u32,
+  line_count: usize,
+  fast_rejected: bool,
+  meta: ModuleMeta,
+  errors: Vec<ErrorRange>,
+}
+
+/// A region in which lexing failed, with `LexOptions::recover`, as byte
+/// offsets from the last record before the error to where lexing resumed, or
+/// the end of the source. Records inside it may be missing.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct ErrorRange {
+  pub start: usize,
+  pub end: usize,
+  /// Where the error was found.
+  pub error: usize,
+}
+
+impl ErrorRange {
+  pub fn to_utf16(&self, index: &Utf16Index) -> ErrorRange {
+    ErrorRange {
+      start: index.to_utf16(self.start),
+      end: index.to_utf16(self.end),
+      error: index.to_utf16(self.error),
+    }
+  }
+}
+
+/// Facts about the module as a whole, gathered in the same pass as the
+/// records. Offsets are byte offsets of the first occurrence.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct ModuleMeta {
+  /// Whether the module only has import and export statements, after any
+  /// hashbang and directives.
+  pub facade: bool,
+  /// An `await` outside of any function.
+  pub top_level_await: Option<usize>,
+  /// An `import.meta`.
+  pub import_meta: Option<usize>,
+  /// A `require` call or reference, as reported as an import.
+  pub require: Option<usize>,
+  /// The start of the first statement after the leading import and export
+  /// declarations, or the source length when there is none. `None` when fast
+  /// rejected.
+  pub prologue_end: Option<usize>,
+  /// A `"use strict"` directive in the directive prologue.
+  pub use_strict: bool,
+  /// A `#!` line at the very start of the source.
+  pub hashbang: bool,
+  /// With `LexOptions::fingerprint`, a hash of the module's shape.
+  pub fingerprint: Option<u64>,
+}
+
+/// Offsets of an import record, matching the `s`, `e`, `ss`, `se` and `a`
+/// fields of the JS API.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct ImportOffsets {
+  pub start: usize,
+  pub end: usize,
+  pub statement_start: usize,
+  pub statement_end: Option<usize>,
+  pub assert_index: Option<usize>,
+}
+
+/// Offsets of an export record, matching the `s`, `e`, `ls` and `le` fields of
+/// the JS API.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct ExportOffsets {
+  pub start: usize,
+  pub end: usize,
+  pub local_start: Option<usize>,
+  pub local_end: Option<usize>,
+}
+
+/// Offsets of an import attribute's key and value, inside any quotes.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct AttributeOffsets {
+  pub key_start: usize,
+  pub key_end: usize,
+  pub value_start: usize,
+  pub value_end: usize,
+}
+
+/// Offsets of an import binding's imported name, including any quotes, and
+/// local name.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct BindingOffsets {
+  pub imported_start: Option<usize>,
+  pub imported_end: Option<usize>,
+  pub local_start: usize,
+  pub local_end: usize,
+}
+
+impl ImportOffsets {
+  pub fn to_utf16(&self, index: &Utf16Index) -> ImportOffsets {
+    ImportOffsets {
+      start: index.to_utf16(self.start),
+      end: index.to_utf16(self.end),
+      statement_start: index.to_utf16(self.statement_start),
+      statement_end: self.statement_end.map(|o| index.to_utf16(o)),
+      assert_index: self.assert_index.map(|o| index.to_utf16(o)),
+    }
+  }
+}
+
+impl AttributeOffsets {
+  pub fn to_utf16(&self, index: &Utf16Index) -> AttributeOffsets {
+    AttributeOffsets {
+      key_start: index.to_utf16(self.key_start),
+      key_end: index.to_utf16(self.key_end),
+      value_start: index.to_utf16(self.value_start),
+      value_end: index.to_utf16(self.value_end),
+    }
+  }
+}
+
+impl BindingOffsets {
+  pub fn to_utf16(&self, index: &Utf16Index) -> BindingOffsets {
+    BindingOffsets {
+      imported_start: self.imported_start.map(|o| index.to_utf16(o)),
+      imported_end: self.imported_end.map(|o| index.to_utf16(o)),
+      local_start: index.to_utf16(self.local_start),
+      local_end: index.to_utf16(self.local_end),
+    }
+  }
+}
+
+impl ModuleMeta {
+  pub fn to_utf16(&self, index: &Utf16Index) -> ModuleMeta {
+    ModuleMeta {
+      top_level_await: self.top_level_await.map(|o| index.to_utf16(o)),
+      import_meta: self.import_meta.map(|o| index.to_utf16(o)),
+      require: self.require.map(|o| index.to_utf16(o)),
+      prologue_end: self.prologue_end.map(|o| index.to_utf16(o)),
+      ..*self
+    }
+  }
+}
+
+impl ExportOffsets {
+  pub fn to_utf16(&self, index: &Utf16Index) -> ExportOffsets {
+    ExportOffsets {
+      start: index.to_utf16(self.start),
+      end: index.to_utf16(self.end),
+      local_start: self.local_start.map(|o| index.to_utf16(o)),
+      local_end: self.local_end.map(|o| index.to_utf16(o)),
+    }
+  }
 }
 
 impl<'a> LexResult<'a> {
+  fn new(
+    bump: Bump,
+    source: &'a str,
+    result: &ParseResult<'a>,
+    options: &LexOptions,
+    utf16: Option<Utf16Index<'a>>,
+  ) -> LexResult<'a> {
+    let mut res = LexResult {
+      _bump: bump,
+      source,
+      first_import: result.first_import,
+      first_export: result.first_export,
+      utf16,
+      line_starts: result.line_starts,
+      line_count: result.line_count as usize,
+      fast_rejected: result.fast_rejected,
+      meta: ModuleMeta::default(),
+      errors: Vec::new(),
+    };
+    res.meta = ModuleMeta {
+      facade: result.facade,
+      top_level_await: res.offset(result.meta.top_level_await),
+      import_meta: res.offset(result.meta.import_meta),
+      require: res.offset(result.meta.require),
+      prologue_end: res.offset(result.meta.prologue_end),
+      use_strict: result.meta.use_strict,
+      hashbang: result.meta.hashbang,
+      fingerprint: if options.fingerprint {
+        Some(result.meta.fingerprint)
+      } else {
+        None
+      },
+    };
+    let mut error = result.first_error;
+    while let Some(range) = unsafe { error.as_ref() } {
+      res.errors.push(ErrorRange {
+        start: res.offset(range.start).unwrap(),
+        end: res.offset(range.end).unwrap(),
+        error: res.offset(range.error).unwrap(),
+      });
+      error = range.next;
+    }
+    res
+  }
+
+  fn offset(&self, ptr: *const u8) -> Option<usize> {
+    if ptr.is_null() {
+      None
+    } else {
+      Some(ptr as usize - self.source.as_ptr() as usize)
+    }
+  }
+
+  /// Byte offsets of an import. An unterminated dynamic import has an empty
+  /// specifier range.
+  pub fn import_offsets(&self, import: &Import) -> ImportOffsets {
+    let start = self.offset(import.start).unwrap();
+    ImportOffsets {
+      start,
+      end: self.offset(import.end).unwrap_or(start),
+      statement_start: self.offset(import.statement_start).unwrap(),
+      statement_end: self.offset(import.statement_end),
+      assert_index: self.offset(import.assert_index),
+    }
+  }
+
+  /// Byte offsets of an export.
+  pub fn export_offsets(&self, export: &Export) -> ExportOffsets {
+    ExportOffsets {
+      start: self.offset(export.start).unwrap(),
+      end: self.offset(export.end).unwrap(),
+      local_start: self.offset(export.local_start),
+      local_end: self.offset(export.local_end),
+    }
+  }
+
+  /// Byte offsets of an import attribute.
+  pub fn attribute_offsets(&self, attribute: &Attribute) -> AttributeOffsets {
+    AttributeOffsets {
+      key_start: self.offset(attribute.key_start).unwrap(),
+      key_end: self.offset(attribute.key_end).unwrap(),
+      value_start: self.offset(attribute.value_start).unwrap(),
+      value_end: self.offset(attribute.value_end).unwrap(),
+    }
+  }
+
+  /// Byte offsets of an import binding.
+  pub fn binding_offsets(&self, binding: &ImportBinding) -> BindingOffsets {
+    BindingOffsets {
+      imported_start: self.offset(binding.imported_start),
+      imported_end: self.offset(binding.imported_end),
+      local_start: self.offset(binding.local_start).unwrap(),
+      local_end: self.offset(binding.local_end).unwrap(),
+    }
+  }
+
+  /// Byte offsets of the start of every line, when lexed with
+  /// `LexOptions::line_starts`.
+  pub fn line_starts(&self) -> Option<&[u32]> {
+    if self.line_starts.is_null() {
+      None
+    } else {
+      Some(unsafe { std::slice::from_raw_parts(self.line_starts, self.line_count) })
+    }
+  }
+
+  /// Line and byte column of a byte offset, see `line_col`. Requires
+  /// `LexOptions::line_starts`.
+  pub fn line_col(&self, offset: usize) -> Option<(usize, usize)> {
+    self.line_starts().map(|line_starts| line_col(line_starts, offset))
+  }
+
+  /// Whether lexing was skipped by `LexOptions::fast_reject`.
+  pub fn fast_rejected(&self) -> bool {
+    self.fast_rejected
+  }
+
+  /// The syntax errors lexing recovered from, with `LexOptions::recover`.
+  pub fn errors(&self) -> &[ErrorRange] {
+    &self.errors
+  }
+
+  /// The module summary. When fast rejected, only `use_strict` and `hashbang`
+  /// are known.
+  pub fn meta(&self) -> ModuleMeta {
+    self.meta
+  }
+
+  /// The UTF-16 offset index, when lexed with `LexOptions::utf16_offsets`.
+  pub fn utf16_index(&self) -> Option<&Utf16Index<'a>> {
+    self.utf16.as_ref()
+  }
+
   pub fn imports(&'a self) -> ResultIter<'a, Import> {
     ResultIter {
       ptr: AtomicPtr::new(self.first_import as *mut Import),
@@ -297,31 +847,163 @@ unsafe extern "C" fn alloc(bytes: u32, user_data: *mut c_void) -> *mut c_void {
   bump.alloc_layout(layout).as_ptr() as *mut c_void
 }
 
+#[derive(Debug, Clone, Copy, Default)]
+pub struct LexOptions {
+  /// Build a `Utf16Index` so record offsets can also be reported as UTF-16
+  /// code unit offsets, as used by JS string indexing.
+  pub utf16_offsets: bool,
+  /// Collect the offsets of the start of every line, split on `\n`.
+  pub line_starts: bool,
+  /// Also detect CommonJS exports: `exports.a =`, `module.exports.a =`,
+  /// `Object.defineProperty(exports, 'a', ...)` and the keys of
+  /// `module.exports = { ... }`, as exports flagged `is_cjs`. The
+  /// `__esModule` marker is reported as an export of that name.
+  pub cjs_exports: bool,
+  /// Skip lexing sources in which `import`, `export` and `require` never
+  /// appear, after a vectorized search, returning no records with
+  /// `LexResult::fast_rejected` set and no line starts. Syntax errors in such
+  /// sources aren't detected.
+  pub fast_reject: bool,
+  /// Instead of failing on a syntax error, record an `ErrorRange` and resume
+  /// lexing from the next line starting with an `import` or `export`
+  /// statement, returning the records found outside of the error ranges.
+  pub recover: bool,
+  /// Classify string specifiers, split bare specifiers into package name and
+  /// subpath, and hash them, so resolvers need no further string work.
+  pub specifiers: bool,
+  /// Compute `ModuleMeta::fingerprint`, a hash of the decoded specifiers of
+  /// the imports with their kinds, attributes and bindings, and of the export
+  /// names with the names they re-export, independent of their order. Edits
+  /// that leave it unchanged don't change how the module links.
+  pub fingerprint: bool,
+  /// Skip over JSX elements, so their text and attributes aren't lexed as JS.
+  pub jsx: bool,
+  /// Lex TypeScript import and export syntax: type-only imports, exports and
+  /// bindings are returned flagged `is_type_only` or `is_type` rather than
+  /// dropped, declarations such as `export enum` and `export namespace` are
+  /// exported, and `import a = require('b')` is a `require` import.
+  pub typescript: bool,
+}
+
+/// Line (from 1) and column (from 0) of an offset, by binary search of sorted
+/// line start offsets. With no line starts, the offset is on the first line.
+pub fn line_col(line_starts: &[u32], offset: usize) -> (usize, usize) {
+  match line_starts.partition_point(|&start| start as usize <= offset) {
+    0 => (1, offset),
+    line => (line, offset - line_starts[line - 1] as usize),
+  }
+}
+
 pub fn lex<'a>(code: &'a str) -> Result<LexResult<'a>, usize> {
-  let code_ptr = code.as_ptr();
-  let mut res = LexResult {
-    bump: Bump::new(),
-    first_import: ptr::null(),
-    first_export: ptr::null(),
-  };
+  lex_with_options(code, &LexOptions::default())
+}
+
+fn option_flags(options: &LexOptions) -> u32 {
+  (if options.line_starts { OPTION_LINE_STARTS } else { 0 })
+    | (if options.cjs_exports { OPTION_CJS_EXPORTS } else { 0 })
+    | (if options.fast_reject { OPTION_FAST_REJECT } else { 0 })
+    | (if options.recover { OPTION_RECOVER } else { 0 })
+    | (if options.specifiers { OPTION_SPECIFIERS } else { 0 })
+    | (if options.fingerprint { OPTION_FINGERPRINT } else { 0 })
+    | (if options.jsx { OPTION_JSX } else { 0 })
+    | (if options.typescript { OPTION_TYPESCRIPT } else { 0 })
+}
+
+/// Lexes with the given options. Error offsets are always byte offsets.
+pub fn lex_with_options<'a>(code: &'a str, options: &LexOptions) -> Result<LexResult<'a>, usize> {
+  let mut bump = Bump::new();
   let mut result: ParseResult = unsafe { MaybeUninit::zeroed().assume_init() };
   let success = unsafe {
     parse(
-      code_ptr,
+      code.as_ptr(),
       code.len() as u32,
+      option_flags(options),
       alloc,
-      &mut res.bump as *mut Bump as *mut c_void,
+      &mut bump as *mut Bump as *mut c_void,
       &mut result as *mut ParseResult,
     )
   };
+  if !success {
+    return Err(result.parse_error as usize);
+  }
+  let utf16 = if options.utf16_offsets {
+    Some(Utf16Index::new(code))
+  } else {
+    None
+  };
+  Ok(LexResult::new(bump, code, &result, options, utf16))
+}
+
+/// The results of `lex_regions`, one per region in order, with the records of
+/// all of them allocated from one arena.
+pub struct RegionsResult<'a> {
+  // the results' own arenas are left empty
+  _bump: Bump,
+  results: Vec<LexResult<'a>>,
+}
 
-  if success {
-    res.first_import = result.first_import;
-    res.first_export = result.first_export;
-    return Ok(res);
+impl<'a> RegionsResult<'a> {
+  pub fn results(&self) -> &[LexResult<'a>] {
+    &self.results
   }
+}
 
-  return Err(result.parse_error as usize);
+/// Lexes each byte range of the code as a module of its own, in place, such as
+/// the `<script type="module">` blocks of an HTML file or single-file
+/// component. Record offsets, line starts and the error offset are all of the
+/// whole code, with the line starts of the whole code shared by every result,
+/// so nothing needs shifting. Fails with the first parse error.
+///
+/// Regions should end at a token boundary, as scripts do before their
+/// `</script>`, since the byte after a region may be read as lookahead.
+///
+/// Panics if a region isn't a range of the code on char boundaries.
+pub fn lex_regions<'a>(
+  code: &'a str,
+  regions: &[Range<usize>],
+  options: &LexOptions,
+) -> Result<RegionsResult<'a>, usize> {
+  let raw_regions: Vec<Region> = regions
+    .iter()
+    .map(|region| {
+      // panics like slicing
+      let _ = &code[region.clone()];
+      Region {
+        start: region.start as u32,
+        end: region.end as u32,
+      }
+    })
+    .collect();
+  let mut bump = Bump::new();
+  let mut results: Vec<ParseResult> = Vec::with_capacity(regions.len());
+  let lexed = unsafe {
+    let lexed = parse_regions(
+      code.as_ptr(),
+      code.len() as u32,
+      raw_regions.as_ptr(),
+      raw_regions.len() as u32,
+      option_flags(options),
+      alloc,
+      &mut bump as *mut Bump as *mut c_void,
+      results.as_mut_ptr(),
+    );
+    // results are written up to and including the region that failed
+    results.set_len((lexed as usize + 1).min(regions.len()));
+    lexed as usize
+  };
+  if lexed < regions.len() {
+    return Err(results[lexed].parse_error as usize);
+  }
+  let utf16 = if options.utf16_offsets {
+    Some(Utf16Index::new(code))
+  } else {
+    None
+  };
+  let results = results
+    .iter()
+    .map(|result| LexResult::new(Bump::new(), code, result, options, utf16.clone()))
+    .collect();
+  Ok(RegionsResult { _bump: bump, results })
 }
 
 #[cfg(test)]
@@ -437,4 +1119,544 @@ mod tests {
       ]
     );
   }
+
+  #[test]
+  fn unescape_literals() {
+    assert_eq!(unescape("./a.js"), Ok(Cow::Borrowed("./a.js")));
+    assert_eq!(unescape(r"\x61\u0062\u{63}\143"), Ok(Cow::Owned("abcc".to_string())));
+    assert_eq!(
+      unescape(r"\uD83D\uDE00\uD83D"),
+      Ok(Cow::Owned("\u{1F600}\u{FFFD}".to_string()))
+    );
+    assert_eq!(unescape("a\\\r\nb\\\u{2028}c"), Ok(Cow::Owned("abc".to_string())));
+    assert_eq!(unescape(r"\é\q"), Ok(Cow::Owned("éq".to_string())));
+    assert_eq!(unescape(r"\x6"), Err(()));
+    assert_eq!(unescape(r"\18"), Err(()));
+    assert_eq!(unescape(r"\1a"), Ok(Cow::Owned("\u{1}a".to_string())));
+    assert_eq!(unescape(r"\u{110000}"), Err(()));
+  }
+
+  #[test]
+  fn import_attributes() {
+    let source = r#"
+      import a from './a.json' with { type: 'json' };
+      import b from "./b" assert { type: "j\x73on", 'x-y': 'z', };
+      export * from './c' with {};
+      import('./d.json', { with: { "type": 'json' } });
+      import('./e.json', opts);
+      import f from './f' with { type: json };
+      import g from './g' with { type: 'bad\x' };
+    "#;
+    let res = lex(source).unwrap();
+    let attributes: Vec<Vec<(Cow<'_, str>, Option<&str>)>> = res
+      .imports()
+      .map(|i| i.attributes().map(|a| (a.key(), a.value())).collect())
+      .collect();
+    let json = vec![(Cow::Borrowed("type"), Some("json"))];
+    assert_eq!(
+      attributes,
+      vec![
+        json.clone(),
+        vec![(Cow::Borrowed("type"), Some("json")), (Cow::Borrowed("x-y"), Some("z"))],
+        vec![],
+        json,
+        vec![],
+        vec![],
+        vec![(Cow::Borrowed("type"), None)],
+      ]
+    );
+
+    let imports: Vec<&mut Import> = res.imports().collect();
+    assert_eq!(imports[0].statement(), "import a from './a.json' with { type: 'json' }");
+    assert!(res.import_offsets(imports[2]).assert_index.is_some());
+    assert!(res.import_offsets(imports[5]).assert_index.is_none());
+    let attribute = imports[3].attributes().next().unwrap();
+    let offsets = res.attribute_offsets(attribute);
+    assert_eq!(&source[offsets.key_start..offsets.key_end], "type");
+    assert_eq!(&source[offsets.value_start..offsets.value_end], "json");
+    assert_eq!((attribute.key_quote(), attribute.value_quote()), (Some('"'), '\''));
+  }
+
+  #[test]
+  fn import_bindings() {
+    let source = r#"
+      import a, * as ns from './a';
+      import b, { c, d as e, default as f, "g-\x68" as i, } from "./b";
+      import source j from './c';
+      import './d';
+      import('./e');
+      export { k } from './f';
+    "#;
+    let res = lex(source).unwrap();
+    let bindings: Vec<Vec<(Option<Cow<'_, str>>, &str, u32)>> = res
+      .imports()
+      .map(|i| i.bindings().map(|b| (b.imported(), b.local(), b.flags)).collect())
+      .collect();
+    let named = |imported: &'static str, local: &'static str| (Some(Cow::Borrowed(imported)), local, 0);
+    assert_eq!(
+      bindings,
+      vec![
+        vec![(None, "a", BINDING_DEFAULT), (None, "ns", BINDING_NAMESPACE)],
+        vec![
+          (None, "b", BINDING_DEFAULT),
+          named("c", "c"),
+          named("d", "e"),
+          (Some(Cow::Borrowed("default")), "f", BINDING_DEFAULT),
+          (Some(Cow::Owned("g-h".to_string())), "i", 0),
+        ],
+        vec![(None, "j", BINDING_PHASE)],
+        vec![],
+        vec![],
+        vec![],
+      ]
+    );
+
+    let import = res.imports().nth(1).unwrap();
+    let binding = import.bindings().nth(4).unwrap();
+    assert!(!binding.is_default() && !binding.is_namespace() && !binding.is_phase());
+    let offsets = res.binding_offsets(binding);
+    assert_eq!(
+      &source[offsets.imported_start.unwrap()..offsets.imported_end.unwrap()],
+      "\"g-\\x68\""
+    );
+    assert_eq!(&source[offsets.local_start..offsets.local_end], "i");
+  }
+
+  #[test]
+  fn reexports() {
+    let source = r#"
+      import a from './a';
+      export * from './b';
+      export * as ns from './c';
+      if (x) { import('./d'); }
+      export { e, f as g, "h" as i } from './e';
+      export { j };
+    "#;
+    let res = lex(source).unwrap();
+    let imports: Vec<&mut Import> = res.imports().collect();
+    let stars: Vec<bool> = imports.iter().map(|i| i.is_star_reexport()).collect();
+    assert_eq!(stars, vec![false, true, false, false, false]);
+
+    let exports: Vec<(&str, ExportKind, Option<usize>, Option<&str>)> = res
+      .exports()
+      .map(|e| (e.exported(), e.kind(), e.import_index(), e.imported()))
+      .collect();
+    assert_eq!(
+      exports,
+      vec![
+        ("ns", ExportKind::ReexportNamespace, Some(2), None),
+        ("e", ExportKind::ReexportNamed, Some(4), Some("e")),
+        ("g", ExportKind::ReexportNamed, Some(4), Some("f")),
+        ("i", ExportKind::ReexportNamed, Some(4), Some("\"h\"")),
+        ("j", ExportKind::Local, None, None),
+      ]
+    );
+    assert_eq!(imports[4].specifier(), "./e");
+  }
+
+  #[test]
+  fn module_meta() {
+    let source = "#!/usr/bin/env node\n'use strict';\nimport a from 'a';\nexport * from 'b';\nconst c = require('c');\nawait import.meta.resolve('d');\n";
+    let meta = lex(source).unwrap().meta();
+    assert_eq!(
+      meta,
+      ModuleMeta {
+        facade: false,
+        top_level_await: source.find("await"),
+        import_meta: source.find("import.meta"),
+        require: source.find("require"),
+        prologue_end: source.find("const"),
+        use_strict: true,
+        hashbang: true,
+        fingerprint: None,
+      }
+    );
+
+    let source = "'use strict'\nimport a from 'a';\nexport { a };\n";
+    let meta = lex(source).unwrap().meta();
+    assert!(meta.facade && meta.use_strict);
+    assert_eq!(meta.prologue_end, Some(source.len()));
+
+    for source in [
+      "async function f() { await x; }",
+      "const f = async () => { await x; };",
+      "xs.map(async (x) => await x);",
+      "class A { async m() { await x; } }",
+    ] {
+      assert_eq!(lex(source).unwrap().meta().top_level_await, None, "{}", source);
+    }
+    for source in [
+      "await x;",
+      "if (a) { await x; }",
+      "for await (const x of xs) {}",
+      "f(await x);",
+    ] {
+      assert!(lex(source).unwrap().meta().top_level_await.is_some(), "{}", source);
+    }
+    assert!(!lex("'use strict' + x").unwrap().meta().use_strict);
+  }
+
+  #[test]
+  fn recover() {
+    let source = "import a from './a';\nconst t = `unterminated;\nimport b from './b';\nexport const c = 1;\n";
+    assert!(lex(source).is_err());
+    let options = LexOptions {
+      recover: true,
+      ..LexOptions::default()
+    };
+    let res = lex_with_options(source, &options).unwrap();
+    let specifiers: Vec<Cow<'_, str>> = res.imports().map(|i| i.specifier()).collect();
+    assert_eq!(specifiers, vec!["./a", "./b"]);
+    assert_eq!(res.exports().map(|e| e.exported()).collect::<Vec<_>>(), vec!["c"]);
+    assert_eq!(
+      res.errors(),
+      &[ErrorRange {
+        start: source.find(';').unwrap(),
+        end: source.find("import b").unwrap(),
+        error: source.len(),
+      }]
+    );
+    assert!(!res.meta().facade);
+
+    let res = lex_with_options("import a from './a';\nf(\n", &options).unwrap();
+    assert_eq!(res.errors().len(), 1);
+    assert_eq!(res.errors()[0].end, 24);
+    assert!(lex_with_options("import a from './a';", &options).unwrap().errors().is_empty());
+
+    // a dynamic import left open is dropped rather than kept without an end
+    let source = "import a from './a';\nimport(\n  foo\nimport b from './b';\n";
+    let res = lex_with_options(source, &options).unwrap();
+    let statements: Vec<&str> = res.imports().map(|i| i.statement()).collect();
+    assert_eq!(statements, vec!["import a from './a'", "import b from './b'"]);
+    assert_eq!(res.errors().len(), 1);
+    assert_eq!(res.errors()[0].end, source.find("import b").unwrap());
+  }
+
+  #[test]
+  fn specifiers() {
+    let source = r#"
+      import './a.js';
+      import '../b';
+      import '/c';
+      import 'node:fs';
+      import '@scope/pkg/sub/d.js';
+      import 'pkg';
+      import '#internal';
+      import 'C:/e';
+      import('lodash/fp');
+      import('\u0061');
+      import(`f`);
+    "#;
+    let options = LexOptions {
+      specifiers: true,
+      ..LexOptions::default()
+    };
+    let res = lex_with_options(source, &options).unwrap();
+    let kinds: Vec<SpecifierKind> = res.imports().map(|i| i.specifier_kind()).collect();
+    use SpecifierKind::{Absolute, Bare, Imports, Relative, Url};
+    assert_eq!(
+      kinds,
+      vec![
+        Relative,
+        Relative,
+        Absolute,
+        Url,
+        Bare,
+        Bare,
+        Imports,
+        Bare,
+        Bare,
+        SpecifierKind::None,
+        SpecifierKind::None
+      ]
+    );
+    let splits: Vec<Option<(&str, &str)>> = res.imports().map(|i| i.package_subpath()).collect();
+    assert_eq!(splits[4], Some(("@scope/pkg", "/sub/d.js")));
+    assert_eq!(splits[5], Some(("pkg", "")));
+    assert_eq!(splits[8], Some(("lodash", "/fp")));
+    assert_eq!(splits[0], None);
+    // FNV-1a
+    let hash = |s: &str| {
+      s.bytes()
+        .fold(0xcbf29ce484222325u64, |h, b| (h ^ b as u64).wrapping_mul(0x100000001b3))
+    };
+    for import in res.imports().filter(|i| i.specifier_kind() != SpecifierKind::None) {
+      assert_eq!(import.specifier_hash(), Some(hash(&import.specifier())));
+    }
+    assert_eq!(res.imports().nth(9).unwrap().specifier_hash(), None);
+    // the same as from JS, which hashes the UTF-8 encoding of UTF-16 sources
+    let res = lex_with_options("import './ü/😀.js'", &options).unwrap();
+    let import = res.imports().next().unwrap();
+    assert_eq!(import.specifier_hash(), Some(0x912eb84e051094d8));
+    assert_eq!(import.specifier_hash(), Some(hash(&import.specifier())));
+    assert!(lex(source)
+      .unwrap()
+      .imports()
+      .all(|i| i.specifier_kind() == SpecifierKind::None));
+  }
+
+  #[test]
+  fn fingerprint() {
+    let options = LexOptions {
+      fingerprint: true,
+      ..LexOptions::default()
+    };
+    let fingerprint = |source: &str| lex_with_options(source, &options).unwrap().meta().fingerprint.unwrap();
+    let base = fingerprint(
+      "import a from './a';\nimport json from './b.json' with { type: 'json' };\nexport const c = a;\n",
+    );
+    assert_ne!(base, 0);
+    // body edits, reordering and escapes don't change the shape
+    assert_eq!(
+      base,
+      fingerprint("export const c = a + 1;\nimport json from \"./b.json\" with { 'type': 'json' };\nimport a from './\\u0061';\n")
+    );
+    for source in [
+      "import a from './a';\nimport json from './b.json' with { type: 'css' };\nexport const c = a;\n",
+      "import a from './a';\nimport json from './b.json';\nexport const c = a;\n",
+      "import a from './a';\nimport json from './b.json' with { type: 'json' };\nexport const d = a;\n",
+      "import a from './a';\nconst json = import('./b.json', { with: { type: 'json' } });\nexport const c = a;\n",
+      "import a from './a';\nimport json from './b.json' with { type: 'json' };\nexport const c = a;\nexport function d() {}\n",
+    ] {
+      assert_ne!(base, fingerprint(source), "{}", source);
+    }
+    // the names re-exported and imported from a module, and how they bind
+    let reexport = fingerprint("export { a as b } from 'x';\n");
+    assert_ne!(reexport, fingerprint("export { c as b } from 'x';\n"));
+    assert_ne!(reexport, fingerprint("export * as b from 'x';\n"));
+    let named = fingerprint("import { a, b as c } from 'x';\n");
+    assert_eq!(named, fingerprint("import { b as c, a } from 'x';\n"));
+    for source in [
+      "import { a, b as d } from 'x';\n",
+      "import { a, c } from 'x';\n",
+      "import { a } from 'x';\n",
+      "import a, { b as c } from 'x';\n",
+      "import * as a from 'x';\nimport { b as c } from 'x';\n",
+    ] {
+      assert_ne!(named, fingerprint(source), "{}", source);
+    }
+    assert_eq!(lex("export const c = 1;").unwrap().meta().fingerprint, None);
+  }
+
+  #[test]
+  fn regions() {
+    let html = "<script type=\"module\">\nimport a from './a';\n</script>\n<p>import b from './b'</p>\n<script type=\"module\">export const c = 1;\nimport('./d');</script>\n";
+    let region = |open: &str, from: usize| {
+      let start = html[from..].find(open).unwrap() + from + open.len();
+      start..html[start..].find("</script>").unwrap() + start
+    };
+    let first = region("<script type=\"module\">", 0);
+    let second = region("<script type=\"module\">", first.end);
+    let options = LexOptions {
+      line_starts: true,
+      ..LexOptions::default()
+    };
+    let res = lex_regions(html, &[first.clone(), second.clone()], &options).unwrap();
+    let results = res.results();
+    assert_eq!(results.len(), 2);
+
+    let imports: Vec<_> = results[0]
+      .imports()
+      .map(|i| (i.specifier(), results[0].import_offsets(&i).start))
+      .collect();
+    assert_eq!(imports, vec![(Cow::Borrowed("./a"), html.find("./a").unwrap())]);
+    assert_eq!(results[0].meta().prologue_end, Some(first.end));
+    let imports: Vec<_> = results[1].imports().map(|i| results[1].import_offsets(&i).start).collect();
+    assert_eq!(imports, vec![html.find("./d").unwrap() - 1]);
+    let exports: Vec<_> = results[1].exports().map(|e| e.exported().to_string()).collect();
+    assert_eq!(exports, vec!["c"]);
+    // line starts are of the whole source
+    let line_starts: Vec<u32> = std::iter::once(0)
+      .chain(html.match_indices('\n').map(|(i, _)| i as u32 + 1))
+      .collect();
+    assert_eq!(results[0].line_starts(), Some(&line_starts[..]));
+    assert_eq!(results[1].line_starts(), Some(&line_starts[..]));
+    assert_eq!(results[1].line_col(html.find("import(").unwrap()), Some((6, 0)));
+
+    assert!(lex_regions(html, &[], &options).unwrap().results().is_empty());
+    // the error offset is of the whole source, and later regions aren't lexed
+    let broken = "<script type=\"module\">import a from 'a'</script><script type=\"module\">export { b</script><script>}</script>";
+    let a = broken.find("import").unwrap()..broken.find("</script>").unwrap();
+    let b = broken.find("export").unwrap()..broken.rfind("</script><script>").unwrap();
+    let c = broken.rfind('}').unwrap()..broken.len() - "</script>".len();
+    let error = lex(&broken[b.clone()]).err().unwrap() + b.start;
+    assert_eq!(lex_regions(broken, &[a, b, c], &options).err(), Some(error));
+  }
+
+  #[test]
+  fn typescript_jsx() {
+    let source = r#"
+      import type { A } from './a';
+      import { type B, c } from './b';
+      import d = require('./d');
+      export type { E } from './e';
+      export interface F {}
+      export enum G {}
+      export declare const h: number;
+      export const i = (j!) / 2, k = <T,>(t: T) => t;
+      const el = <div title="it's">{'}'} it's </div>;
+      export { type L, m };
+    "#;
+    let options = LexOptions {
+      jsx: true,
+      typescript: true,
+      ..Default::default()
+    };
+    let res = lex_with_options(source, &options).unwrap();
+    let imports: Vec<_> = res.imports().map(|i| (i.specifier(), i.is_type_only())).collect();
+    assert_eq!(
+      imports,
+      vec![
+        (Cow::Borrowed("./a"), true),
+        (Cow::Borrowed("./b"), false),
+        (Cow::Borrowed("./d"), false),
+        (Cow::Borrowed("./e"), true),
+      ]
+    );
+    let bindings: Vec<_> = res
+      .imports()
+      .nth(1)
+      .unwrap()
+      .bindings()
+      .map(|b| (b.local(), b.is_type()))
+      .collect();
+    assert_eq!(bindings, vec![("B", true), ("c", false)]);
+    let exports: Vec<_> = res.exports().map(|e| (e.exported(), e.is_type_only())).collect();
+    assert_eq!(
+      exports,
+      vec![
+        ("E", true),
+        ("F", true),
+        ("G", false),
+        ("h", false),
+        ("i", false),
+        ("L", true),
+        ("m", false),
+      ]
+    );
+    // the JSX text's quotes are unterminated strings without the option
+    assert!(lex(source).is_err());
+  }
+
+  #[test]
+  fn cjs_exports() {
+    let source = r#"
+      Object.defineProperty(exports, "__esModule", { value: true });
+      exports.a = exports.b = void 0;
+      module.exports['c'] = require('./c');
+      exports.d == 1;
+      module.exports = { e, f: g, h() {} };
+    "#;
+    let options = LexOptions {
+      cjs_exports: true,
+      ..Default::default()
+    };
+    let res = lex_with_options(source, &options).unwrap();
+    let exports: Vec<(&str, bool)> = res.exports().map(|e| (e.exported(), e.is_cjs())).collect();
+    assert_eq!(
+      exports,
+      vec![
+        ("\"__esModule\"", true),
+        ("a", true),
+        ("b", true),
+        ("'c'", true),
+        ("e", true),
+        ("f", true),
+      ]
+    );
+    assert_eq!(res.imports().count(), 1);
+    assert_eq!(lex(source).unwrap().exports().count(), 0);
+  }
+
+  #[test]
+  fn line_starts() {
+    let source = "import a from './a.js';\n\nexport { a };\r\nimport('./b.js');";
+    let res = lex_with_options(
+      source,
+      &LexOptions {
+        line_starts: true,
+        ..Default::default()
+      },
+    )
+    .unwrap();
+    assert_eq!(res.line_starts(), Some(&[0, 24, 25, 40][..]));
+    let imports: Vec<ImportOffsets> = res.imports().map(|i| res.import_offsets(i)).collect();
+    assert_eq!(res.line_col(imports[0].start), Some((1, 15)));
+    assert_eq!(res.line_col(imports[1].statement_start), Some((4, 0)));
+    assert_eq!(res.line_col(source.len()), Some((4, 17)));
+    assert_eq!(lex(source).unwrap().line_col(0), None);
+    assert_eq!(line_col(&[], 5), (1, 5));
+  }
+
+  #[test]
+  fn fast_reject() {
+    let options = LexOptions {
+      fast_reject: true,
+      ..Default::default()
+    };
+    let res = lex_with_options("var data = [1, 2, 3]; (", &options).unwrap();
+    assert!(res.fast_rejected());
+    assert_eq!(res.imports().count() + res.exports().count(), 0);
+    let lines = LexOptions {
+      line_starts: true,
+      ..options
+    };
+    assert_eq!(lex_with_options("var a;\nvar b;", &lines).unwrap().line_starts(), None);
+    assert_eq!(
+      lex_with_options("import 'a';\n", &lines).unwrap().line_starts(),
+      Some(&[0, 12][..])
+    );
+
+    for source in ["// import\n", "const exported = 1;", "x.require", "import.meta.url"] {
+      let res = lex_with_options(source, &options).unwrap();
+      assert!(!res.fast_rejected());
+      assert_eq!(res.imports().count(), source.starts_with("import.meta") as usize);
+    }
+    assert!(lex_with_options("exported(", &options).is_err());
+    assert!(!lex("var a;").unwrap().fast_rejected());
+  }
+
+  #[test]
+  fn utf16_offsets() {
+    let source = "const s = '\u{1F600}é';\nimport a from './é.js';\nexport { a as 'π𝒳' };\nimport('./b.js');";
+    let res = lex_with_options(
+      source,
+      &LexOptions {
+        utf16_offsets: true,
+        ..Default::default()
+      },
+    )
+    .unwrap();
+    let index = res.utf16_index().unwrap();
+    let to_utf16 = |offset: usize| source[..offset].encode_utf16().count();
+
+    let imports: Vec<ImportOffsets> = res.imports().map(|i| res.import_offsets(i)).collect();
+    assert_eq!(&source[imports[0].start..imports[0].end], "./é.js");
+    assert_eq!(
+      &source[imports[1].statement_start..imports[1].statement_end.unwrap()],
+      "import('./b.js')"
+    );
+    for offsets in imports {
+      let utf16 = offsets.to_utf16(index);
+      assert_eq!(utf16.start, to_utf16(offsets.start));
+      assert_eq!(utf16.end, to_utf16(offsets.end));
+      assert_eq!(utf16.statement_start, to_utf16(offsets.statement_start));
+      assert_eq!(utf16.statement_end, offsets.statement_end.map(to_utf16));
+    }
+
+    let export = res.exports().next().unwrap();
+    let offsets = res.export_offsets(export);
+    assert_eq!(&source[offsets.start..offsets.end], "'π𝒳'");
+    let utf16 = offsets.to_utf16(index);
+    assert_eq!(
+      (utf16.start, utf16.end),
+      (to_utf16(offsets.start), to_utf16(offsets.end))
+    );
+    assert_eq!(utf16.end - utf16.start, 5);
+
+    // out of order lookups, including offsets inside a run of non-ASCII
+    for offset in (0..=source.len()).rev().filter(|&o| source.is_char_boundary(o)) {
+      assert_eq!(index.to_utf16(offset), to_utf16(offset));
+    }
+  }
 }
@@ -0,0 +1,158 @@
+import { Worker } from 'worker_threads';
+import { cpus } from 'os';
+import { init, parse, parseOptionFlags, readParseResult, wasmModule } from './lexer.js';
+import type { ParseOptions } from './lexer.js';
+
+export interface LexerPoolOptions {
+  /**
+   * Number of worker threads, defaulting to the number of CPUs.
+   */
+  threads?: number;
+  /**
+   * Once a worker's wasm memory grows past this many bytes it is recycled by
+   * instantiating a fresh instance, since wasm memory never shrinks.
+   * Defaults to 64MiB.
+   */
+  highWaterMark?: number;
+}
+
+export interface LexerPool {
+  /**
+   * Parses the source on a worker thread, with the same result and errors as
+   * `parse`.
+   */
+  parse (source: string, name?: string, options?: ParseOptions): Promise<ReturnType<typeof parse>>;
+  /**
+   * Stops all workers, rejecting any pending parses.
+   */
+  terminate (): Promise<void>;
+}
+
+interface Task {
+  source: string;
+  name: string;
+  options: ParseOptions;
+  resolve (result: ReturnType<typeof parse>): void;
+  reject (err: Error): void;
+}
+
+interface PoolWorker {
+  worker: Worker;
+  tasks: Map<number, Task>;
+}
+
+const isLE = new Uint8Array(new Uint16Array([1]).buffer)[0] === 1;
+
+/**
+ * Creates a pool of worker threads that lex off the calling thread.
+ *
+ * The compiled lexer module is shared with the workers, each of which
+ * instantiates its own copy. Sources are transferred to workers as UTF-16
+ * buffers, and results are transferred back as the packed Int32Array of the
+ * wasm API, so `n` and `ln` remain lazily decoded on the calling thread.
+ *
+ * Idle workers don't keep the process alive.
+ */
+export function createLexerPool ({ threads = cpus().length || 1, highWaterMark = 64 * 1024 * 1024 }: LexerPoolOptions = {}): LexerPool {
+  let nextId = 0;
+  let terminated = false;
+
+  const workers: Promise<PoolWorker[]> = Promise.all([wasmModule, init]).then(([module]) => {
+    const workers: PoolWorker[] = [];
+    for (let i = 0; i < threads; i++) {
+      const worker = new Worker(`(${workerMain})()`, { eval: true, workerData: { module, highWaterMark } });
+      const poolWorker: PoolWorker = { worker, tasks: new Map() };
+      worker.unref();
+      worker.on('message', ({ id, result }: { id: number, result: Int32Array }) => {
+        const task = poolWorker.tasks.get(id)!;
+        poolWorker.tasks.delete(id);
+        if (poolWorker.tasks.size === 0)
+          worker.unref();
+        try {
+          task.resolve(readParseResult(task.source, result, task.name, task.options));
+        }
+        catch (err) {
+          task.reject(err as Error);
+        }
+      });
+      worker.on('error', err => {
+        workers.splice(workers.indexOf(poolWorker), 1);
+        for (const task of poolWorker.tasks.values())
+          task.reject(err);
+        poolWorker.tasks.clear();
+      });
+      workers.push(poolWorker);
+    }
+    return workers;
+  });
+
+  return {
+    async parse (source, name = '@', options = {}) {
+      const pool = await workers;
+      if (terminated || pool.length === 0)
+        throw new Error(terminated ? 'Lexer pool has been terminated' : 'Lexer pool has no running workers');
+
+      // the least busy worker
+      let target = pool[0];
+      for (const poolWorker of pool) {
+        if (poolWorker.tasks.size < target.tasks.size)
+          target = poolWorker;
+      }
+
+      const buffer = new Uint16Array(source.length);
+      for (let i = 0; i < source.length; i++) {
+        const ch = source.charCodeAt(i);
+        buffer[i] = isLE ? ch : (ch & 0xff) << 8 | ch >>> 8;
+      }
+
+      const id = nextId++;
+      return new Promise((resolve, reject) => {
+        target.tasks.set(id, { source, name, options, resolve, reject });
+        if (target.tasks.size === 1)
+          target.worker.ref();
+        target.worker.postMessage({ id, source: buffer, flags: parseOptionFlags(options) }, [buffer.buffer]);
+      });
+    },
+    async terminate () {
+      terminated = true;
+      const pool = await workers;
+      await Promise.all(pool.map(({ worker, tasks }) => {
+        for (const task of tasks.values())
+          task.reject(new Error('Lexer pool has been terminated'));
+        tasks.clear();
+        return worker.terminate();
+      }));
+    }
+  };
+}
+
+// Runs in each worker, as an eval worker so it doesn't load (and compile) the
+// lexer module again.
+function workerMain () {
+  const { parentPort, workerData } = require('worker_threads');
+  const { module, highWaterMark } = workerData;
+  let wasm: any;
+
+  function instantiate () {
+    wasm = new WebAssembly.Instance(module).exports;
+  }
+  instantiate();
+
+  parentPort.on('message', ({ id, source, flags }: { id: number, source: Uint16Array, flags: number }) => {
+    const len = source.length + 1;
+    const extraMem = (wasm.__heap_base.value || wasm.__heap_base) + len * 4 - wasm.memory.buffer.byteLength;
+    if (extraMem > 0)
+      wasm.memory.grow(Math.ceil(extraMem / 65536));
+
+    const addr = wasm.sa(len - 1);
+    new Uint16Array(wasm.memory.buffer, addr, len - 1).set(source);
+
+    const resultAddr = wasm.p(flags);
+    const header = new Int32Array(wasm.memory.buffer, resultAddr, 14);
+    const result = new Int32Array(wasm.memory.buffer, resultAddr, 14 + header[0] * 15 + header[1] * 9 + header[5] * 4 + header[6] * 5 + header[11] * 3 + header[4]).slice();
+    parentPort.postMessage({ id, result }, [result.buffer]);
+
+    if (wasm.memory.buffer.byteLength > highWaterMark)
+      instantiate();
+  });
+}
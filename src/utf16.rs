@@ -0,0 +1,121 @@
+/// Maps UTF-8 byte offsets of a source to UTF-16 code unit offsets, as used by
+/// JS string indexing.
+///
+/// Only runs of non-ASCII characters are recorded, so an ASCII-only source has
+/// an empty table and every lookup is O(1). Lookups in ascending order, which
+/// is the order records are produced in, walk the table from the previous
+/// position and are amortized O(1); other lookups fall back to a binary search.
+#[derive(Clone)]
+pub struct Utf16Index<'a> {
+  source: &'a [u8],
+  runs: Vec<Run>,
+  hint: std::cell::Cell<usize>,
+}
+
+#[derive(Clone, Copy)]
+struct Run {
+  // byte range of consecutive non-ASCII characters
+  start: u32,
+  end: u32,
+  // bytes minus UTF-16 code units before and after the run
+  delta_before: u32,
+  delta_after: u32,
+}
+
+impl<'a> Utf16Index<'a> {
+  pub fn new(source: &'a str) -> Self {
+    let bytes = source.as_bytes();
+    let mut runs: Vec<Run> = Vec::new();
+    let mut delta = 0;
+    let mut i = 0;
+    while i < bytes.len() {
+      // skip ASCII a word at a time
+      while i + 8 <= bytes.len()
+        && u64::from_ne_bytes(bytes[i..i + 8].try_into().unwrap()) & 0x8080808080808080 == 0
+      {
+        i += 8;
+      }
+      if i >= bytes.len() {
+        break;
+      }
+      let b = bytes[i];
+      if b < 0x80 {
+        i += 1;
+        continue;
+      }
+      let len = utf8_len(b);
+      let units = if len == 4 { 2 } else { 1 };
+      match runs.last_mut() {
+        Some(run) if run.end as usize == i => {
+          run.end += len as u32;
+          run.delta_after += (len - units) as u32;
+        }
+        _ => runs.push(Run {
+          start: i as u32,
+          end: (i + len) as u32,
+          delta_before: delta,
+          delta_after: delta + (len - units) as u32,
+        }),
+      }
+      delta += (len - units) as u32;
+      i += len;
+    }
+
+    Utf16Index {
+      source: bytes,
+      runs,
+      hint: std::cell::Cell::new(0),
+    }
+  }
+
+  /// Returns the UTF-16 code unit offset of the given byte offset.
+  pub fn to_utf16(&self, offset: usize) -> usize {
+    let runs = &self.runs;
+    if runs.is_empty() {
+      return offset;
+    }
+    let offset32 = offset as u32;
+
+    // index of the first run starting after the offset, walking forward a few
+    // runs from the last lookup before falling back to a binary search
+    let mut i = self.hint.get();
+    if i > 0 && runs[i - 1].start > offset32 {
+      i = runs.partition_point(|run| run.start <= offset32);
+    } else {
+      let limit = (i + 8).min(runs.len());
+      while i < limit && runs[i].start <= offset32 {
+        i += 1;
+      }
+      if i == limit {
+        i += runs[i..].partition_point(|run| run.start <= offset32);
+      }
+    }
+    self.hint.set(i);
+
+    if i == 0 {
+      return offset;
+    }
+    let run = runs[i - 1];
+    if offset32 >= run.end {
+      return offset - run.delta_after as usize;
+    }
+    // inside a run, count the code units of the characters before the offset
+    let mut units = run.start as usize - run.delta_before as usize;
+    let mut pos = run.start as usize;
+    while pos < offset {
+      let len = utf8_len(self.source[pos]);
+      units += if len == 4 { 2 } else { 1 };
+      pos += len;
+    }
+    units
+  }
+}
+
+fn utf8_len(lead: u8) -> usize {
+  match lead {
+    0..=0x7f => 1,
+    0xc0..=0xdf => 2,
+    0xe0..=0xef => 3,
+    _ => 4,
+  }
+}
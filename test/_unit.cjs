@@ -1,17 +1,22 @@
 const assert = require('assert');
 
 let js = false;
-let parse;
+let parse, lineCol, parseRegions;
 const init = (async () => {
   if (parse) return;
   if (process.env.WASM) {
     const m = await import('../dist/lexer.js');
     await m.init;
     parse = m.parse;
+    lineCol = m.lineCol;
+    parseRegions = m.parseRegions;
   }
   else if (process.env.ASM) {
     ({ parse } = await import('../dist/lexer.asm.js'));
   }
+  else if (process.env.ADDON) {
+    ({ parse, lineCol, parseRegions } = await import('../dist/addon.js'));
+  }
   else {
     js = true;
     ({ parse } = await import('../lexer.js'));
@@ -113,6 +118,94 @@ suite('Invalid syntax', () => {
     assertExportIs(source, exports[0], {n: 'p', ln: 'p', a: false});
   });
 
+  if (!js)
+  test('Import attributes', () => {
+    const source = `
+      import a from './a.json' with { type: 'json' };
+      import b from "./b" assert { type: "j\\x73on", 'x-y': 'z', };
+      export * from './c' with {};
+      import('./d.json', { with: { "type": 'json' } });
+      import('./e.json', opts);
+      import f from './f' with { type: json };
+    `;
+    const [imports] = parse(source);
+    assert.strictEqual(imports.length, 6);
+    assert.deepStrictEqual(imports[0].at, [['type', 'json']]);
+    assert.deepStrictEqual(imports[1].at, [['type', 'json'], ['x-y', 'z']]);
+    assert.strictEqual(imports[2].at, null);
+    assert.strictEqual(source.slice(imports[2].a, imports[2].se), '{}');
+    assert.deepStrictEqual(imports[3].at, [['type', 'json']]);
+    assert.strictEqual(imports[4].at, null);
+    assert.strictEqual(imports[5].at, null);
+    assert.strictEqual(imports[5].a, -1);
+  });
+
+  if (!js)
+  test('Import bindings', () => {
+    const source = `
+      import a, * as ns from './a';
+      import b, { c, d as e, default as f, "g-h" as i, } from "./b";
+      import source j from './c';
+      import './d';
+      import('./e');
+    `;
+    const [imports] = parse(source);
+    const bindings = imports.map(i => i.b && i.b.map(b => [b.n, b.ln, b.d, b.ns, b.ph]));
+    assert.deepStrictEqual(bindings, [
+      [[undefined, 'a', true, false, false], [undefined, 'ns', false, true, false]],
+      [
+        [undefined, 'b', true, false, false],
+        ['c', 'c', false, false, false],
+        ['d', 'e', false, false, false],
+        ['default', 'f', true, false, false],
+        ['g-h', 'i', false, false, false]
+      ],
+      [[undefined, 'j', false, false, true]],
+      null,
+      null
+    ]);
+    const binding = imports[1].b[4];
+    assert.strictEqual(source.slice(binding.s, binding.e), '"g-h"');
+    assert.strictEqual(source.slice(binding.ls, binding.le), 'i');
+    assert.strictEqual(imports[0].b[0].s, -1);
+  });
+
+  if (!js)
+  test('Records are plain objects', () => {
+    const source = `import { "b\\x63" as a } from './\\x61';\nexport { c as "\\x64" };`;
+    const [[imp], [exp]] = parse(source);
+    assert.strictEqual({ ...imp }.n, './a');
+    assert.deepStrictEqual([{ ...imp.b[0] }.n, { ...imp.b[0] }.ln], ['bc', 'a']);
+    const s = source.indexOf('"\\x64"'), ls = source.indexOf('c as');
+    assert.deepStrictEqual({ ...exp }, { s, e: s + 6, ls, le: ls + 1, cjs: false, ri: -1, rs: -1, re: -1, t: false, n: 'd', ln: 'c', rn: undefined });
+    assert.strictEqual(JSON.stringify(imp).indexOf('export'), -1);
+    assert.deepStrictEqual(Object.keys(imp.b[0]), ['s', 'e', 'ls', 'le', 'd', 'ns', 'ph', 't', 'n', 'ln']);
+  });
+
+  if (!js)
+  test('Re-exports', () => {
+    const source = `
+      import a from './a';
+      export * from './b';
+      export * as ns from './c';
+      if (x) { import('./d'); }
+      export { e, f as g, "h" as i } from './e';
+      export { j };
+    `;
+    const [imports, exports] = parse(source);
+    assert.deepStrictEqual(imports.map(i => i.star), [false, true, false, false, false]);
+    assert.deepStrictEqual(exports.map(e => [e.n, e.ri, e.rn]), [
+      ['ns', 2, undefined],
+      ['e', 4, 'e'],
+      ['g', 4, 'f'],
+      ['i', 4, 'h'],
+      ['j', -1, undefined]
+    ]);
+    assert.strictEqual(imports[exports[1].ri].n, './e');
+    assert.strictEqual(source.slice(exports[3].rs, exports[3].re), '"h"');
+    assert.strictEqual(exports[3].ln, undefined);
+  });
+
   test('Import meta inside dynamic import', () => {
     const source = `import(import.meta.url)`;
     const [imports] = parse(source);
@@ -177,6 +270,206 @@ suite('Lexer', () => {
     assertExportIs(source, exports[0], { n: 'p', ln: 'p' });
   });
 
+  if (process.env.WASM || process.env.ADDON)
+  test('Line starts', () => {
+    const source = `import a from './a.js';\n\nexport { a };\r\nimport('./b.js');`;
+    const [imports,,, lineStarts] = parse(source, '@', { lineStarts: true });
+    assert.deepStrictEqual(Array.from(lineStarts), [0, 24, 25, 40]);
+    assert.deepStrictEqual(lineCol(lineStarts, imports[0].s), { line: 1, column: 15 });
+    assert.deepStrictEqual(lineCol(lineStarts, imports[1].ss), { line: 4, column: 0 });
+    assert.deepStrictEqual(lineCol(new Uint32Array(0), 5), { line: 1, column: 5 });
+    assert.strictEqual(parse(source).length, 3);
+    assert.throws(() => parse('\n\n  import {', 'x.js'), /Parse error x.js:3:10/);
+  });
+
+  if (process.env.WASM || process.env.ADDON)
+  test('CommonJS exports', () => {
+    const source = `
+      Object.defineProperty(exports, "__esModule", { value: true });
+      exports.a = exports.b = void 0;
+      module.exports['c'] = require('./c');
+      exports.d == 1;
+      module.exports = { e, f: g, h() {} };
+    `;
+    const [imports, exports] = parse(source, '@', { cjsExports: true });
+    assert.strictEqual(imports.length, 1);
+    assert.deepStrictEqual(exports.map(e => e.n), ['__esModule', 'a', 'b', 'c', 'e', 'f']);
+    assert.ok(exports.every(e => e.cjs && e.ln === undefined));
+    assert.strictEqual(parse(source)[1].length, 0);
+    // cut off by the end of the source
+    for (const source of ['exports.', 'module.exports.'])
+      assert.strictEqual(parse(source, '@', { cjsExports: true })[1].length, 0);
+    for (const source of ['module.exports = {', "exports['a", 'module.exports = { "a', 'Object.defineProperty(exports, "'])
+      assert.throws(() => parse(source, '@', { cjsExports: true }), /Parse error/);
+  });
+
+  if (process.env.WASM || process.env.ADDON)
+  test('Tokens cut off by the end of the source', () => {
+    for (const source of ["'", '/', '`${', 'a = /[', './', '-/', 'import {', 'import "a', "import('", "import { '", "export { '"])
+      assert.throws(() => parse(source), /Parse error/);
+    assert.throws(() => parse('<a b="', '@', { jsx: true }), /Parse error/);
+    assert.strictEqual(parse('/* ')[0].length, 0);
+    for (const source of ['export /*', 'export //', 'export * //', 'export a', 'export va'])
+      assert.strictEqual(parse(source)[1].length, 0);
+    assert.strictEqual(parse('export namespace //', '@', { typescript: true })[1].length, 0);
+  });
+
+  if (process.env.WASM || process.env.ADDON)
+  test('Closing punctuators ending a statement', () => {
+    assert.throws(() => parse('export)/'), /Parse error/);
+    const [imports] = parse('import "a" assert { type: "json" }\n/re/.test(x)');
+    assert.strictEqual(imports.length, 1);
+    assert.strictEqual(imports[0].n, 'a');
+  });
+
+  if (process.env.WASM || process.env.ADDON)
+  test('Fast reject', () => {
+    const [imports, exports, facade,, fastRejected] = parse('var data = [1, 2, 3]; (', '@', { fastReject: true });
+    assert.strictEqual(imports.length + exports.length, 0);
+    assert.strictEqual(facade, false);
+    assert.strictEqual(fastRejected, true);
+    assert.strictEqual(parse('var a;\nvar b;', '@', { fastReject: true, lineStarts: true })[3].length, 0);
+    for (const source of ['// import\n', 'const exported = 1;', 'x.require', 'import.meta.url']) {
+      const [imports,,,, fastRejected] = parse(source, '@', { fastReject: true });
+      assert.strictEqual(fastRejected, false);
+      assert.strictEqual(imports.length, source.startsWith('import.meta') ? 1 : 0);
+    }
+    assert.throws(() => parse('exported(', '@', { fastReject: true }));
+  });
+
+  if (process.env.WASM || process.env.ADDON)
+  test('Module meta', () => {
+    const source = `#!/usr/bin/env node
+'use strict';
+import a from './a';
+const b = require('./b');
+await import.meta.resolve('./c');
+`;
+    const [,, facade,,, meta] = parse(source, '@', { meta: true });
+    assert.strictEqual(facade, false);
+    assert.deepStrictEqual(meta, {
+      topLevelAwait: source.indexOf('await'),
+      importMeta: source.indexOf('import.meta'),
+      require: source.indexOf('require'),
+      prologueEnd: source.indexOf('const'),
+      useStrict: true,
+      hashbang: true
+    });
+
+    const facadeSource = `'use strict'\nexport * from './a';\n`;
+    const [,, isFacade,,, facadeMeta] = parse(facadeSource, '@', { meta: true });
+    assert.strictEqual(isFacade, true);
+    assert.strictEqual(facadeMeta.prologueEnd, facadeSource.length);
+
+    for (const source of ['async function f () { await x }', 'const f = async () => await x;', 'class A { async m () { await x } }'])
+      assert.strictEqual(parse(source, '@', { meta: true })[5].topLevelAwait, -1, source);
+    for (const source of ['if (x) { await y }', 'for await (const x of y) {}'])
+      assert.notStrictEqual(parse(source, '@', { meta: true })[5].topLevelAwait, -1, source);
+    assert.strictEqual(parse(`'use strict' + x`, '@', { meta: true })[5].useStrict, false);
+  });
+
+  if (process.env.WASM || process.env.ADDON)
+  test('Error recovery', () => {
+    const source = `import a from './a';
+const t = \`unterminated;
+import b from './b';
+export const c = 1;
+`;
+    assert.throws(() => parse(source));
+    const [imports, exports, facade,,,, errors] = parse(source, '@', { recover: true });
+    assert.deepStrictEqual(imports.map(i => i.n), ['./a', './b']);
+    assert.deepStrictEqual(exports.map(e => e.n), ['c']);
+    assert.strictEqual(facade, false);
+    assert.deepStrictEqual(errors, [{ s: source.indexOf(';'), e: source.indexOf('import b'), idx: source.length }]);
+
+    const [,,,,,, none] = parse(`import a from './a';`, '@', { recover: true });
+    assert.deepStrictEqual(none, []);
+
+    const unclosed = `import a from './a';\nimport(\n  foo\nimport b from './b';\n`;
+    const [dynamic,,,,,, dynamicErrors] = parse(unclosed, '@', { recover: true });
+    assert.deepStrictEqual(dynamic.map(i => [i.n, i.se]), [['./a', 19], ['./b', unclosed.length - 2]]);
+    assert.strictEqual(dynamicErrors.length, 1);
+  });
+
+  if (process.env.WASM || process.env.ADDON)
+  test('Specifiers', () => {
+    const source = `import './a.js';\nimport '/b';\nimport 'node:fs';\nimport '@scope/pkg/sub.js';\nimport '#internal';\nimport('lodash/fp');\nimport('\\u0061');`;
+    const [imports] = parse(source, '@', { specifiers: true });
+    assert.deepStrictEqual(imports.map(i => i.k), [1, 2, 3, 4, 5, 4, 0]);
+    assert.strictEqual(source.slice(imports[3].s, imports[3].ps), '@scope/pkg');
+    assert.strictEqual(source.slice(imports[5].s + 1, imports[5].ps), 'lodash');
+    assert.strictEqual(imports[0].ps, -1);
+    assert.strictEqual(imports[0].h, '860ba38e5c344a92');
+    assert.strictEqual(imports[6].h, undefined);
+    assert.strictEqual(parse(source)[0][3].k, 0);
+    // the FNV-1a of the UTF-8 encoding, as from the Rust crate
+    assert.strictEqual(parse(`import './ü/😀.js'`, '@', { specifiers: true })[0][0].h, '912eb84e051094d8');
+  });
+
+  if (process.env.WASM || process.env.ADDON)
+  test('Fingerprint', () => {
+    const fingerprint = source => parse(source, '@', { fingerprint: true })[5].fingerprint;
+    const base = fingerprint(`import a from './a';\nimport json from './b.json' with { type: 'json' };\nexport const c = a;`);
+    assert.match(base, /^[0-9a-f]{16}$/);
+    assert.strictEqual(fingerprint(`export const c = a + 1;\nimport json from "./b.json" with { 'type': 'json' };\nimport a from './\\u0061';`), base);
+    assert.notStrictEqual(fingerprint(`import a from './a';\nimport json from './b.json' with { type: 'css' };\nexport const c = a;`), base);
+    assert.notStrictEqual(fingerprint(`import a from './a';\nimport json from './b.json' with { type: 'json' };\nexport const d = a;`), base);
+    assert.notStrictEqual(fingerprint(`export { a as b } from 'x'`), fingerprint(`export { c as b } from 'x'`));
+    assert.strictEqual(fingerprint(`import { a, b as c } from 'x'`), fingerprint(`import { b as c, a } from 'x'`));
+    assert.notStrictEqual(fingerprint(`import { a, b as c } from 'x'`), fingerprint(`import { a, b as d } from 'x'`));
+    assert.notStrictEqual(fingerprint(`import a from 'x'`), fingerprint(`import * as a from 'x'`));
+    // the same as the Rust crate's for non-ASCII names
+    assert.strictEqual(fingerprint(`export const ünï = 1; export { ünï as '😀' }; import 'ü'`), fingerprint(`import '\\u00fc'; export { ünï as '\\u{1F600}' }; export const ünï = 1;`));
+    assert.strictEqual(parse('export {}', '@', { meta: true })[5].fingerprint, undefined);
+  });
+
+  if (process.env.WASM || process.env.ADDON)
+  test('TypeScript and JSX', () => {
+    const source = `
+      import type { A } from './a';
+      import { type B, c } from './b';
+      import d = require('./d');
+      export type * as E from './e';
+      export interface F {}
+      export const enum G {}
+      export declare function h (): void;
+      export const i = (j!) / 2, k = <T,>(t: T) => t;
+      const el = <div title="it's">{'}'} it's {<br />}</div>;
+      export { type L, m };
+    `;
+    const [imports, exports] = parse(source, '@', { jsx: true, typescript: true });
+    assert.deepStrictEqual(imports.map(i => [i.n, i.t]), [['./a', true], ['./b', false], ['./d', false], ['./e', true]]);
+    assert.deepStrictEqual(imports[1].b.map(b => [b.ln, b.t]), [['B', true], ['c', false]]);
+    assert.deepStrictEqual(exports.map(e => [e.n, e.t]), [['E', true], ['F', true], ['G', false], ['h', false], ['i', false], ['L', true], ['m', false]]);
+    assert.throws(() => parse(source));
+  });
+
+  if (process.env.WASM || process.env.ADDON)
+  test('Regions', () => {
+    const html = `<script type="module">\nimport a from './a';\n</script>\n<p>import b from './b'</p>\n<script type="module">export const c = 1;\nimport('./\\u0064');</script>\n`;
+    const regions = [];
+    for (let end = 0, start; (start = html.indexOf('<script type="module">', end)) !== -1;) {
+      start += '<script type="module">'.length;
+      end = html.indexOf('</script>', start);
+      regions.push([start, end]);
+    }
+    const [[imports, , , lineStarts, , meta], [dynImports, exports]] = parseRegions(html, regions, '@', { lineStarts: true, meta: true });
+    assert.strictEqual(imports.length, 1);
+    assert.strictEqual(imports[0].n, './a');
+    assert.strictEqual(imports[0].s, html.indexOf('./a'));
+    assert.strictEqual(meta.prologueEnd, regions[0][1]);
+    assert.strictEqual(dynImports[0].n, './d');
+    assert.strictEqual(dynImports[0].ss, html.indexOf('import('));
+    assertExportIs(html, exports[0], { n: 'c', ln: 'c' });
+    // line starts are of the whole source
+    assert.deepStrictEqual(lineCol(lineStarts, dynImports[0].ss), { line: 6, column: 0 });
+
+    assert.deepStrictEqual(parseRegions(html, []), []);
+    assert.throws(() => parseRegions(html, [[0, html.length + 1]]), RangeError);
+    assert.throws(() => parseRegions(html, [[1, 0]]), RangeError);
+    assert.throws(() => parseRegions(`<script>import a from './a'</script><script>\nexport { a</script>`, [[8, 27], [44, 55]], 'x.html'), /Parse error x.html:2:/);
+  });
+
   test('String encoding', () => {
     const [imports,] = parse(`
       import './\\x61\\x62\\x63.js';
@@ -1345,3 +1638,83 @@ function x() {
   });
 });
 
+
+if (process.env.WASM) {
+  suite('Pool', () => {
+    test('Parses on worker threads', async () => {
+      const { createLexerPool } = await import('../dist/pool.js');
+      const pool = createLexerPool({ threads: 2, highWaterMark: 0 });
+      const sources = Array.from({ length: 8 }, (_, i) => `import a from './mod${i}.js';\nexport { a as 'b\\u0031' };`);
+      const results = await Promise.all(sources.map(source => pool.parse(source)));
+      for (const [i, [imports, exports, facade]] of results.entries()) {
+        assert.strictEqual(imports.length, 1);
+        assert.strictEqual(imports[0].n, `./mod${i}.js`);
+        assertExportIs(sources[i], exports[0], { n: 'b1', ln: 'a' });
+        assert.strictEqual(facade, true);
+      }
+      await assert.rejects(pool.parse('import {', 'bad.js'), /Parse error bad.js:1:8/);
+      await pool.terminate();
+    });
+  });
+
+  suite('Async', () => {
+    test('Parses in slices', async () => {
+      const { parse, parseAsync } = await import('../dist/lexer.js');
+      const source = Array.from({ length: 200 }, (_, i) => `import a${i} from './mod${i}.js';\nconst t${i} = \`\${a${i}}\`;\nexport { a${i} };`).join('\n');
+      const expected = parse(source, '@', { lineStarts: true });
+      // parse calls between slices don't affect sliced parses
+      const [result] = await Promise.all([
+        parseAsync(source, '@', { lineStarts: true, sliceLength: 7 }),
+        parseAsync('export var p = 5', '@', { sliceLength: 1 }),
+        Promise.resolve().then(() => parse('import "other"'))
+      ]);
+      assert.deepStrictEqual(result[0].map(i => [i.n, i.s, i.e, i.ss, i.se]), expected[0].map(i => [i.n, i.s, i.e, i.ss, i.se]));
+      assert.deepStrictEqual(result[1].map(e => [e.n, e.s, e.e]), expected[1].map(e => [e.n, e.s, e.e]));
+      assert.deepStrictEqual(result[3], expected[3]);
+      await assert.rejects(parseAsync('import a from "a";\n  import {', 'bad.js', { sliceLength: 4 }), /Parse error bad.js:2:10/);
+    });
+  });
+}
+
+if (process.env.ADDON) {
+  suite('Addon', () => {
+    test('Lexes buffers', async () => {
+      const { parse, parseRegions } = await import('../dist/addon.js');
+      const source = `import a from './a\\u0031.js';\nexport { a as "b" };\nimport('./c.js');`;
+      const [imports, exports, facade] = parse(Buffer.from(source));
+      assert.deepStrictEqual(imports.map(i => [i.n, i.s, i.e, i.ss, i.se, i.d]), parse(source)[0].map(i => [i.n, i.s, i.e, i.ss, i.se, i.d]));
+      assert.strictEqual(imports[0].n, './a1.js');
+      assertExportIs(source, exports[0], { n: 'b', ln: 'a' });
+      assert.strictEqual(facade, parse(source)[2]);
+      assert.strictEqual(parse(new Uint8Array(0))[0].length, 0);
+      const regions = [[0, source.indexOf('\n')], [source.lastIndexOf('\n') + 1, source.length]];
+      assert.deepStrictEqual(parseRegions(Buffer.from(source), regions).map(([imports]) => imports.map(i => [i.n, i.s])), [[['./a1.js', 15]], [['./c.js', source.indexOf("'./c.js'")]]]);
+      assert.throws(() => parse(Buffer.from('import {'), 'x.js'), /Parse error x.js:1:8/);
+      assert.throws(() => parse(new Uint16Array(4)), TypeError);
+      // lexed up to the end of the view, not on into the bytes after it
+      assert.throws(() => parse(Buffer.from(`import 'a' + 'b'`).subarray(0, 9)), /Parse error/);
+      const utf8 = `export const ünï = 1, 'ö' = 2;\nexport { ünï as "😀" } from './ä.js';`;
+      const [utf8Imports, utf8Exports] = parse(Buffer.from(utf8));
+      assert.strictEqual(utf8Imports[0].n, './ä.js');
+      assert.deepStrictEqual(utf8Exports.map(e => [e.n, e.ln]), [['ünï', 'ünï'], ['😀', undefined]]);
+    });
+
+    test('Parses many on the thread pool', async () => {
+      const { parse, parseMany } = await import('../dist/addon.js');
+      const sources = Array.from({ length: 16 }, (_, i) => `import a from './mod${i}.js';\nexport { a as 'b\\u0031' };`);
+      const results = await parseMany(sources.map((source, i) => i % 2 ? Buffer.from(source) : source), { lineStarts: true });
+      for (const [i, [imports, exports, facade, lineStarts]] of results.entries()) {
+        assert.strictEqual(imports[0].n, `./mod${i}.js`);
+        assertExportIs(sources[i], exports[0], { n: 'b1', ln: 'a' });
+        assert.strictEqual(facade, true);
+        assert.deepStrictEqual(lineStarts, parse(sources[i], '@', { lineStarts: true })[3]);
+      }
+      const buffer = Buffer.from(`import './ü.js'`);
+      const pending = parseMany([buffer]);
+      buffer.fill(0);
+      assert.strictEqual((await pending)[0][0][0].n, './ü.js');
+      await assert.rejects(parseMany(['export {}', 'import {']), /Parse error @:1:8/);
+      await assert.rejects(parseMany([1]), TypeError);
+    });
+  });
+}